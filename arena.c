@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "coretypes.h"
+#include "error.h"
+#include "arena.h"
+
+static void arena_new_block(Arena *arena, const size_t size)
+{
+    size_t capacity = (arena->block) ? 2 * arena->block->capacity : ARENA_FIRST_BLOCK_SIZE;
+    while (capacity < size + ARENA_ALIGNMENT)
+        capacity *= 2;
+
+    /* Header and data are allocated together, data is aligned after the header */
+    ArenaBlock *block = malloc(sizeof(ArenaBlock) + ARENA_ALIGNMENT + capacity);
+    if (block == NULL) {
+        INTERNAL_ERROR("Failed to allocate arena block!");
+        exit(EXIT_FAILURE);
+    }
+    uintptr_t data = ((uintptr_t)(block + 1) + ARENA_ALIGNMENT - 1) & ~(uintptr_t)(ARENA_ALIGNMENT - 1);
+    block->data = (unsigned char *)data;
+    block->capacity = capacity;
+    block->used = 0;
+    block->next = arena->block;
+    arena->block = block;
+    arena->bytes_reserved += capacity;
+}
+
+extern void *arena_alloc(Arena *arena, const size_t size)
+{
+    size_t aligned = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (arena->block == NULL || arena->block->capacity - arena->block->used < aligned)
+        arena_new_block(arena, aligned);
+
+    void *memory = arena->block->data + arena->block->used;
+    arena->block->used += aligned;
+    arena->bytes_used += aligned;
+    arena->last = memory;
+    return memory;
+}
+
+extern void *arena_grow(Arena *arena, void *old, const size_t old_size, const size_t new_size)
+{
+    size_t old_aligned = (old_size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    size_t new_aligned = (new_size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    /* Last allocation is at the top of current block, just move the top */
+    if (old != NULL && old == arena->last && arena->block->capacity - arena->block->used >= new_aligned - old_aligned) {
+        arena->block->used += new_aligned - old_aligned;
+        arena->bytes_used += new_aligned - old_aligned;
+        return old;
+    }
+
+    void *memory = arena_alloc(arena, new_size);
+    if (old != NULL)
+        memcpy(memory, old, old_size);
+    return memory;
+}
+
+extern void arena_merge(Arena *arena, Arena *other)
+{
+    if (other->block == NULL)
+        return;
+
+    /* Blocks of other go behind current block, so that arena keeps allocating and growing in place */
+    ArenaBlock *tail = other->block;
+    while (tail->next != NULL)
+        tail = tail->next;
+    if (arena->block == NULL) {
+        arena->block = other->block;
+        arena->last = other->last;
+    }
+    else {
+        tail->next = arena->block->next;
+        arena->block->next = other->block;
+    }
+    arena->bytes_used += other->bytes_used;
+    arena->bytes_reserved += other->bytes_reserved;
+    *other = (Arena){.block = NULL, .bytes_used = 0, .bytes_reserved = 0, .last = NULL};
+}
+
+extern void arena_release(Arena *arena)
+{
+    for (ArenaBlock *block = arena->block, *next; block != NULL; block = next) {
+        next = block->next;
+        free(block);
+    }
+    *arena = (Arena){.block = NULL, .bytes_used = 0, .bytes_reserved = 0, .last = NULL};
+}
@@ -0,0 +1,51 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#define ARENA_ALIGNMENT 16
+#define ARENA_FIRST_BLOCK_SIZE 4096
+
+/*@Function: arena_new_block
+*Helper Function: Adds block that is at least twice as big as previous one and fits size bytes */
+static void arena_new_block(Arena *, const size_t);
+
+/*@Function: arena_alloc
+*Function that returns size bytes from arena, memory is not initialized */
+extern void *arena_alloc(Arena *, const size_t);
+
+/*@Function: arena_grow
+*Function that grows allocation from old_size to new_size, last allocation grows in place, others are copied */
+extern void *arena_grow(Arena *, void *, const size_t, const size_t);
+
+/*@Function: arena_merge
+*Function that moves every block of other into arena and leaves other empty, both are released together */
+extern void arena_merge(Arena *, Arena *);
+
+/*@Function: arena_release
+*Function that frees every block of arena at once, number of blocks is logarithmic in bytes used */
+extern void arena_release(Arena *);
+
+#endif // ARENA_H
@@ -0,0 +1,210 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+/* Allocation benchmark: counts heap allocations made while engines run numeric scripts of growing size. 
+ * Allocations of every engine must not grow with number of loop iterations or calls, benchmark fails if 
+ * they do. Linked with --wrap so that malloc, calloc and realloc go through counters below */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <setjmp.h>
+#include <unistd.h>
+#include "coretypes.h"
+#include "error.h"
+#include "lexer.h"
+#include "arena.h"
+#include "parser.h"
+#include "symbol.h"
+#include "environment.h"
+#include "interpreter.h"
+#include "flat_ast.h"
+#include "flat_interpreter.h"
+#include "optimizer.h"
+#include "resolver.h"
+#include "frontend.h"
+#include "bytecode.h"
+#include "vm.h"
+#include "closure.h"
+
+#define BENCH_SMALL 1000
+#define BENCH_LARGE 100000
+#define BENCH_SCRIPT_SIZE 512
+
+/*@Type BenchScript: Script with %d in place of loop count, checked scripts must not allocate per iteration */
+typedef struct bench_script_s
+{
+    const char *name;
+    const char *format;
+    int checked;
+} BenchScript;
+
+static const BenchScript scripts[] = {
+    {"loop",
+     "{\n"
+     "    var total = 0;\n"
+     "    for (var i = 0; i < %d; i = i + 1) {\n"
+     "        total = total + i * 2 - 1;\n"
+     "        if (total > 1000000 || total < 0 && !false) total = total - 1000000;\n"
+     "    }\n"
+     "    echo total;\n"
+     "}\n", TRUE},
+    {"while",
+     "var k = 0;\n"
+     "var f = 0.5;\n"
+     "while (k < %d) {\n"
+     "    k = k + 1;\n"
+     "    f = f * 1.5 / 1.5 + (k %% 7) - -1;\n"
+     "}\n"
+     "echo f;\n", TRUE},
+    {"calls",
+     "funct add(a, b) {\n"
+     "    return a + b;\n"
+     "}\n"
+     "{\n"
+     "    var sum = 0;\n"
+     "    for (var i = 0; i < %d; i = i + 1) sum = add(sum, i);\n"
+     "    echo sum;\n"
+     "}\n", TRUE},
+};
+
+static const char *engine_names[] = {
+    [ENGINE_TREE] = "tree",
+    [ENGINE_FLAT] = "flat",
+    [ENGINE_VM] = "vm",
+    [ENGINE_CLOSURE] = "closure",
+};
+
+static int counting = FALSE;
+static size_t allocations = 0;
+
+extern void *__real_malloc(size_t);
+extern void *__real_calloc(size_t, size_t);
+extern void *__real_realloc(void *, size_t);
+
+void *__wrap_malloc(size_t size)
+{
+    if(counting) ++allocations;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    if(counting) ++allocations;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size)
+{
+    if(counting) ++allocations;
+    return __real_realloc(pointer, size);
+}
+
+/* Parses script with loop count and returns number of allocations made while engine runs it */
+static size_t bench_count(const BenchScript *script, const Engine engine, const int count)
+{
+    char text[BENCH_SCRIPT_SIZE];
+    snprintf(text, sizeof(text), script->format, count);
+    Source source = {.data = text, .size = strlen(text)};
+    TokenVector ctokens = {NULL, 0, 0};
+    Arena ast_arena = {NULL, 0, 0, NULL};
+    FlatAST flat = {0};
+    Bytecode bytecode = {0};
+    size_t number_of_statements = 0;
+
+    reset_error_flag();
+    AST **ast = (source_lexer(&source, &ctokens) == NULL) ? NULL : parser(ctokens.tokens, &number_of_statements, &ast_arena);
+    if(ast == NULL || error_flag) {
+        fprintf(stderr, "bench: %s script did not parse\n", script->name);
+        exit(EXIT_FAILURE);
+    }
+    ast_optimize(ast, number_of_statements, &ast_arena);
+    ast_resolve(ast, number_of_statements);
+    flat_ast_build(&flat, ast, number_of_statements, ctokens.tokens, ctokens.size);
+    bytecode_build(&bytecode, &flat);
+    Closure *closures[number_of_statements + 1];
+    for(size_t i = 0; i < number_of_statements; ++i) {
+        closures[i] = (ast[i] == NULL) ? NULL : closure_build(ast[i]);
+    }
+
+    allocations = 0;
+    counting = TRUE;
+    for(size_t i = 0; i < number_of_statements; ++i) {
+        if(ast[i] == NULL) continue;
+        if(engine == ENGINE_VM) vm_interpret(&bytecode, i);
+        else if(engine == ENGINE_FLAT) flat_interpret(&flat, flat.extra[flat.roots + i]);
+        else if(engine == ENGINE_CLOSURE) closure_interpret(closures[i]);
+        else interpret(ast[i]);
+    }
+    counting = FALSE;
+    if(error_flag) {
+        fprintf(stderr, "bench: engine failed on %s script\n", script->name);
+        exit(EXIT_FAILURE);
+    }
+
+    env_reset(&env_global);
+    closure_release();
+    bytecode_free(&bytecode);
+    flat_ast_free(&flat);
+    arena_release(&ast_arena);
+    frontend_release();
+    token_vector_free(&ctokens);
+    symbol_table_free();
+    return allocations;
+}
+
+int main(void)
+{
+    /* Scripts echo their results, keep them out of the report. Buffer of stdout is given 
+     * up front so that first echo does not allocate it */
+    static char stdout_buffer[BUFSIZ];
+    FILE *report = fdopen(dup(fileno(stdout)), "w");
+    if (report == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        fprintf(stderr, "bench: failed to redirect stdout\n");
+        return EXIT_FAILURE;
+    }
+    setvbuf(stdout, stdout_buffer, _IOFBF, sizeof(stdout_buffer));
+
+    const Engine engines[] = {ENGINE_TREE, ENGINE_FLAT, ENGINE_CLOSURE, ENGINE_VM};
+    int failed = FALSE;
+    fprintf(report, "%-10s %-8s %12d %12d %14s\n", "script", "engine", BENCH_SMALL, BENCH_LARGE, "per iteration");
+    for (size_t s = 0; s < sizeof(scripts) / sizeof(scripts[0]); ++s) {
+        for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); ++e) {
+            /* First run grows stacks and scopes that engines keep between statements */
+            bench_count(&scripts[s], engines[e], BENCH_SMALL);
+            size_t small = bench_count(&scripts[s], engines[e], BENCH_SMALL);
+            size_t large = bench_count(&scripts[s], engines[e], BENCH_LARGE);
+            double per_iteration = ((double)large - (double)small) / (BENCH_LARGE - BENCH_SMALL);
+            fprintf(report, "%-10s %-8s %12zu %12zu %14.2f%s\n", scripts[s].name, engine_names[engines[e]], small, large, per_iteration, 
+                    (scripts[s].checked && small != large) ? "  FAILED" : "");
+            if (scripts[s].checked && small != large) failed = TRUE;
+        }
+    }
+    vm_release();
+    env_pool_release();
+    fclose(report);
+    return (failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
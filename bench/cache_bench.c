@@ -0,0 +1,194 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* Compiled script cache benchmark: times full front end (lexer, parser, optimizer,
+ * flat AST build) against hashing the source and loading its cache entry */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <setjmp.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "coretypes.h"
+#include "error.h"
+#include "lexer.h"
+#include "arena.h"
+#include "parser.h"
+#include "symbol.h"
+#include "flat_ast.h"
+#include "optimizer.h"
+#include "resolver.h"
+#include "frontend.h"
+#include "cache.h"
+
+#define BENCH_UNITS 32768
+#define BENCH_REPEAT 5
+
+/*@Type BenchBuffer: Growable text buffer for generated scripts */
+typedef struct bench_buffer_s
+{
+    char *data;
+    size_t size;
+    size_t capacity;
+} BenchBuffer;
+
+static void bench_append(BenchBuffer *buffer, const char *format, ...);
+static double bench_now(void);
+
+static void bench_append(BenchBuffer *buffer, const char *format, ...)
+{
+    va_list args;
+    for (;;) {
+        va_start(args, format);
+        int written = vsnprintf(buffer->data + buffer->size, buffer->capacity - buffer->size, format, args);
+        va_end(args);
+        if (written < 0) {
+            fprintf(stderr, "bench: failed to format script\n");
+            exit(EXIT_FAILURE);
+        }
+        if (buffer->size + (size_t)written < buffer->capacity) {
+            buffer->size += (size_t)written;
+            return;
+        }
+        buffer->capacity = (buffer->capacity) ? 2 * buffer->capacity : 4096;
+        buffer->data = realloc(buffer->data, buffer->capacity);
+        if (buffer->data == NULL) {
+            fprintf(stderr, "bench: failed to allocate script\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static double bench_now(void)
+{
+    struct timespec time_spec;
+    clock_gettime(CLOCK_MONOTONIC, &time_spec);
+    return time_spec.tv_sec + time_spec.tv_nsec * 1e-9;
+}
+
+static void generate_script(BenchBuffer *buffer, const size_t units)
+{
+    bench_append(buffer, "funct step(a, b) {\n    return a + b * 2;\n}\n");
+    for (size_t i = 0; i < units; ++i) {
+        bench_append(buffer, "var v%zu = %zu * (3 + 4) - v%zu;\n", i, i, i ? i - 1 : 0);
+        bench_append(buffer, "if (v%zu > %zu) { echo \"big\"; } else { v%zu = step(v%zu, 1); }\n", i, i, i, i);
+    }
+}
+
+/* Cold run: what run_file does when the cache entry is missing */
+static double bench_compile(const Source *source, const uint64_t hash)
+{
+    TokenVector ctokens = {NULL, 0, 0};
+    Arena ast_arena = {NULL, 0, 0, NULL};
+    FlatAST flat = {0};
+    size_t number_of_statements = 0;
+
+    double start = bench_now();
+    if (source_lexer(source, &ctokens) == NULL) {
+        fprintf(stderr, "bench: source_lexer failed on generated script\n");
+        exit(EXIT_FAILURE);
+    }
+    AST **ast = parser(ctokens.tokens, &number_of_statements, &ast_arena);
+    if (ast == NULL || error_flag) {
+        fprintf(stderr, "bench: generated script did not parse\n");
+        exit(EXIT_FAILURE);
+    }
+    ast_optimize(ast, number_of_statements, &ast_arena);
+    ast_resolve(ast, number_of_statements);
+    flat_ast_build(&flat, ast, number_of_statements, ctokens.tokens, ctokens.size);
+    double end = bench_now();
+
+    cache_store(source, hash, &ctokens, &flat);
+    flat_ast_free(&flat);
+    arena_release(&ast_arena);
+    frontend_release();
+    token_vector_free(&ctokens);
+    symbol_table_free();
+    return end - start;
+}
+
+/* Warm run: what run_file does when the cache entry is valid */
+static double bench_load(const Source *source)
+{
+    TokenVector ctokens = {NULL, 0, 0};
+    FlatAST flat = {0};
+
+    double start = bench_now();
+    int hit = cache_load(source, cache_hash(source), &ctokens, &flat);
+    double end = bench_now();
+    if (!hit) {
+        fprintf(stderr, "bench: cache entry was not found after store\n");
+        exit(EXIT_FAILURE);
+    }
+    flat_ast_free(&flat);
+    token_vector_free(&ctokens);
+    cache_release();
+    symbol_table_free();
+    return end - start;
+}
+
+int main(void)
+{
+    char directory[] = "/tmp/cash_cache_benchXXXXXX";
+    if (mkdtemp(directory) == NULL || setenv("CASH_CACHE_DIR", directory, 1) < 0) {
+        fprintf(stderr, "bench: failed to create cache directory\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Parser prints debug output on stdout, keep it out of the report */
+    FILE *report = fdopen(dup(fileno(stdout)), "w");
+    if (report == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        fprintf(stderr, "bench: failed to redirect stdout\n");
+        return EXIT_FAILURE;
+    }
+
+    BenchBuffer script = {NULL, 0, 0};
+    generate_script(&script, BENCH_UNITS);
+    Source source = {.data = script.data, .size = script.size};
+    const uint64_t hash = cache_hash(&source);
+
+    double compile = INFINITY, load = INFINITY;
+    /* Best of several runs filters out scheduler noise */
+    for (size_t repeat = 0; repeat < BENCH_REPEAT; ++repeat) {
+        reset_error_flag();
+        compile = fmin(compile, bench_compile(&source, hash));
+        load = fmin(load, bench_load(&source));
+    }
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%016llx.cashc", directory, (unsigned long long)hash);
+    unlink(path);
+    rmdir(directory);
+
+    fprintf(report, "%-10s %12s %12s %12s\n", "path", "bytes", "seconds", "MB/s");
+    fprintf(report, "%-10s %12zu %12.6f %12.1f\n", "compile", script.size, compile, script.size / compile / 1e6);
+    fprintf(report, "%-10s %12zu %12.6f %12.1f\n", "load", script.size, load, script.size / load / 1e6);
+    fprintf(report, "\ncache hit skips %.1f%% of front-end time (%.1fx faster)\n", 100.0 * (1.0 - load / compile), compile / load);
+    free(script.data);
+    fclose(report);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,300 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* Front-end scaling benchmark: times tokenizer, token_classifier, parser and
+ * source_lexer on generated scripts of growing size and fits growth exponent */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <stdarg.h>
+#include <string.h>
+#include <setjmp.h>
+#include <math.h>
+#include <time.h>
+#include "coretypes.h"
+#include "error.h"
+#include "lexer.h"
+#include "arena.h"
+#include "parser.h"
+#include "symbol.h"
+
+#define BENCH_SIZES 5
+#define BENCH_REPEAT 9
+#define BENCH_MAX_EXPONENT 1.2
+#define BENCH_STRING_LENGTH 256
+#define BENCH_NEST_DEPTH 64
+
+/*@Type BenchBuffer: Growable text buffer for generated scripts */
+typedef struct bench_buffer_s
+{
+    char *data;
+    size_t size;
+    size_t capacity;
+} BenchBuffer;
+
+/*@Type BenchStage: Timings of one front-end stage over all sizes */
+typedef struct bench_stage_s
+{
+    const char *name;
+    double seconds[BENCH_SIZES];
+} BenchStage;
+
+/*@Type BenchShape: Generator of one kind of script */
+typedef struct bench_shape_s
+{
+    const char *name;
+    void (*generate)(BenchBuffer *, const size_t);
+    size_t base_units;
+} BenchShape;
+
+static void bench_append(BenchBuffer *buffer, const char *format, ...);
+static double bench_now(void);
+static double bench_fit_exponent(const size_t *, const double *);
+
+static void bench_append(BenchBuffer *buffer, const char *format, ...)
+{
+    va_list args;
+    for (;;) {
+        va_start(args, format);
+        int written = vsnprintf(buffer->data + buffer->size, buffer->capacity - buffer->size, format, args);
+        va_end(args);
+        if (written < 0) {
+            fprintf(stderr, "bench: failed to format script\n");
+            exit(EXIT_FAILURE);
+        }
+        if (buffer->size + (size_t)written < buffer->capacity) {
+            buffer->size += (size_t)written;
+            return;
+        }
+        buffer->capacity = (buffer->capacity) ? 2 * buffer->capacity : 4096;
+        buffer->data = realloc(buffer->data, buffer->capacity);
+        if (buffer->data == NULL) {
+            fprintf(stderr, "bench: failed to allocate script\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static double bench_now(void)
+{
+    struct timespec time_spec;
+    clock_gettime(CLOCK_MONOTONIC, &time_spec);
+    return time_spec.tv_sec + time_spec.tv_nsec * 1e-9;
+}
+
+/* Least squares slope of log(time) over log(size), 1 is linear and 2 is quadratic */
+static double bench_fit_exponent(const size_t *sizes, const double *seconds)
+{
+    double sum_x = 0, sum_y = 0, sum_xx = 0, sum_xy = 0;
+    for (size_t i = 0; i < BENCH_SIZES; ++i) {
+        double x = log((double)sizes[i]);
+        double y = log(seconds[i]);
+        sum_x += x;
+        sum_y += y;
+        sum_xx += x * x;
+        sum_xy += x * y;
+    }
+    return (BENCH_SIZES * sum_xy - sum_x * sum_y) / (BENCH_SIZES * sum_xx - sum_x * sum_x);
+}
+
+static void generate_declarations(BenchBuffer *buffer, const size_t units)
+{
+    for (size_t i = 0; i < units; ++i)
+        bench_append(buffer, "var v%zu = %zu + v%zu * 2;\n", i, i, i ? i - 1 : 0);
+}
+
+static void generate_nesting(BenchBuffer *buffer, const size_t units)
+{
+    /* Nesting depth is bounded so that recursion in parser stays within stack */
+    for (size_t i = 0; i < units; i += BENCH_NEST_DEPTH) {
+        for (size_t depth = 0; depth < BENCH_NEST_DEPTH; ++depth)
+            bench_append(buffer, "if (d%zu < %zu) {\n", depth, depth);
+        bench_append(buffer, "echo d0;\n");
+        for (size_t depth = 0; depth < BENCH_NEST_DEPTH; ++depth)
+            bench_append(buffer, "}\n");
+    }
+}
+
+static void generate_strings(BenchBuffer *buffer, const size_t units)
+{
+    char text[BENCH_STRING_LENGTH + 1];
+    for (size_t i = 0; i < BENCH_STRING_LENGTH; ++i)
+        text[i] = 'a' + i % 26;
+    text[BENCH_STRING_LENGTH] = '\0';
+
+    for (size_t i = 0; i < units; ++i)
+        bench_append(buffer, "var s%zu = \"%s\";\n", i, text);
+}
+
+static void generate_function(BenchBuffer *buffer, const size_t units)
+{
+    bench_append(buffer, "funct big(a, b) {\n");
+    for (size_t i = 0; i < units; ++i)
+        bench_append(buffer, "    a = a + b * %zu;\n", i);
+    bench_append(buffer, "}\n");
+}
+
+/* Legacy path as used by run_term: tokenizer per line, then token_classifier */
+static void bench_legacy(const BenchBuffer *script, double *tokenizer_time, double *classifier_time, double *parser_time, size_t *token_count, size_t *arena_bytes)
+{
+    char *text = malloc(script->size + 1);
+    memcpy(text, script->data, script->size);
+    text[script->size] = '\0';
+
+    Token *ctokens = NULL;
+    size_t number_of_ctokens = 0;
+    double tokenize = 0, classify = 0;
+
+    for (char *line = text, *next; line && *line; line = next) {
+        next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+
+        size_t number_of_tokens = 0;
+        double start = bench_now();
+        char **tokens = tokenizer(line, &number_of_tokens);
+        double middle = bench_now();
+        if (tokens == NULL)
+            continue;
+        ctokens = token_classifier(tokens, ctokens, number_of_ctokens + number_of_tokens, &number_of_ctokens);
+        double end = bench_now();
+        tokenize += middle - start;
+        classify += end - middle;
+
+        for (size_t i = 0; i < number_of_tokens; ++i)
+            free(tokens[i]);
+        free(tokens);
+    }
+    number_of_ctokens = eof_token(&ctokens, number_of_ctokens);
+
+    size_t number_of_statements = 0;
+    Arena ast_arena = {NULL, 0, 0, NULL};
+    double start = bench_now();
+    AST **ast = parser(ctokens, &number_of_statements, &ast_arena);
+    /* Parser skips function bodies, they are parsed here like on their first call */
+    for (size_t i = 0; i < number_of_statements; ++i)
+        if (ast[i] != NULL && ast[i]->tag == AST_FUNCT_DECL_STMT)
+            parser_function_body(ast[i], &ast_arena);
+    *parser_time = bench_now() - start;
+    *arena_bytes = ast_arena.bytes_used;
+    arena_release(&ast_arena);
+    for (size_t i = 0; i < number_of_ctokens; ++i)
+        free(ctokens[i].lexeme);
+    free(ctokens);
+    free(text);
+
+    *tokenizer_time = tokenize;
+    *classifier_time = classify;
+    *token_count = number_of_ctokens;
+}
+
+/* Fused path as used by run_file */
+static double bench_source_lexer(const BenchBuffer *script)
+{
+    Source source = {.data = script->data, .size = script->size};
+    TokenVector ctokens = {NULL, 0, 0};
+
+    double start = bench_now();
+    if (source_lexer(&source, &ctokens) == NULL) {
+        fprintf(stderr, "bench: source_lexer failed on generated script\n");
+        exit(EXIT_FAILURE);
+    }
+    double end = bench_now();
+    token_vector_free(&ctokens);
+    return end - start;
+}
+
+int main(void)
+{
+    const BenchShape shapes[] = {
+        {"declarations", generate_declarations, 8192},
+        {"nesting", generate_nesting, 16384},
+        {"strings", generate_strings, 16384},
+        {"function", generate_function, 8192}
+    };
+    int failed = 0;
+
+    /* Freed memory stays in the heap, so repeats reuse it and best of several runs times the front end.
+     * Otherwise glibc maps large arrays anew and only the big sizes pay first-touch page faults */
+    if (!mallopt(M_MMAP_MAX, 0) || !mallopt(M_TRIM_THRESHOLD, -1)) {
+        fprintf(stderr, "bench: failed to set allocator options\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%-14s %-16s %12s %12s %12s %10s\n", "shape", "stage", "bytes", "seconds", "MB/s", "exponent");
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); ++s) {
+        BenchStage stages[] = {{"tokenizer"}, {"token_classifier"}, {"parser"}, {"source_lexer"}};
+        const size_t stage_count = sizeof(stages) / sizeof(stages[0]);
+        size_t bytes[BENCH_SIZES];
+        size_t arena_bytes = 0;
+
+        BenchBuffer scripts[BENCH_SIZES];
+        for (size_t n = 0; n < BENCH_SIZES; ++n) {
+            scripts[n] = (BenchBuffer){NULL, 0, 0};
+            shapes[s].generate(&scripts[n], shapes[s].base_units << n);
+            bytes[n] = scripts[n].size;
+            for (size_t i = 0; i < stage_count; ++i)
+                stages[i].seconds[n] = INFINITY;
+        }
+
+        /* Best of several runs filters out scheduler noise, sizes take turns so a slow spell hits all of them */
+        for (size_t repeat = 0; repeat < BENCH_REPEAT; ++repeat) {
+            for (size_t n = 0; n < BENCH_SIZES; ++n) {
+                double tokenize, classify, parse;
+                size_t token_count;
+                reset_error_flag();
+                /* Both paths intern into empty symbol table, like run_file and run_term do */
+                bench_legacy(&scripts[n], &tokenize, &classify, &parse, &token_count, &arena_bytes);
+                symbol_table_free();
+                double lex = bench_source_lexer(&scripts[n]);
+                symbol_table_free();
+                if (error_flag) {
+                    fprintf(stderr, "bench: generated %s script did not parse\n", shapes[s].name);
+                    return EXIT_FAILURE;
+                }
+                stages[0].seconds[n] = fmin(stages[0].seconds[n], tokenize);
+                stages[1].seconds[n] = fmin(stages[1].seconds[n], classify);
+                stages[2].seconds[n] = fmin(stages[2].seconds[n], parse);
+                stages[3].seconds[n] = fmin(stages[3].seconds[n], lex);
+            }
+        }
+        for (size_t n = 0; n < BENCH_SIZES; ++n)
+            free(scripts[n].data);
+
+        for (size_t i = 0; i < stage_count; ++i) {
+            double exponent = bench_fit_exponent(bytes, stages[i].seconds);
+            size_t last = BENCH_SIZES - 1;
+            printf("%-14s %-16s %12zu %12.6f %12.1f %10.2f%s\n", shapes[s].name, stages[i].name,
+                bytes[last], stages[i].seconds[last], bytes[last] / stages[i].seconds[last] / 1e6, exponent,
+                (exponent > BENCH_MAX_EXPONENT) ? "  SUPERLINEAR" : "");
+            if (exponent > BENCH_MAX_EXPONENT)
+                failed = 1;
+        }
+        printf("%-14s %-16s %12zu bytes of AST arena\n", shapes[s].name, "parser", arena_bytes);
+    }
+
+    if (failed)
+        printf("\nbench: growth exponent above %.2f, front end does not scale linearly\n", BENCH_MAX_EXPONENT);
+    return (failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
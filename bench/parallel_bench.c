@@ -0,0 +1,155 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* Parallel front-end benchmark: times frontend_parse on a generated script of independent
+ * top-level declarations with growing number of jobs and checks that statements match */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <setjmp.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "coretypes.h"
+#include "error.h"
+#include "lexer.h"
+#include "arena.h"
+#include "symbol.h"
+#include "frontend.h"
+
+#define BENCH_UNITS 65536
+#define BENCH_REPEAT 5
+
+/*@Type BenchBuffer: Growable text buffer for generated scripts */
+typedef struct bench_buffer_s
+{
+    char *data;
+    size_t size;
+    size_t capacity;
+} BenchBuffer;
+
+static void bench_append(BenchBuffer *buffer, const char *format, ...);
+static double bench_now(void);
+
+static void bench_append(BenchBuffer *buffer, const char *format, ...)
+{
+    va_list args;
+    for (;;) {
+        va_start(args, format);
+        int written = vsnprintf(buffer->data + buffer->size, buffer->capacity - buffer->size, format, args);
+        va_end(args);
+        if (written < 0) {
+            fprintf(stderr, "bench: failed to format script\n");
+            exit(EXIT_FAILURE);
+        }
+        if (buffer->size + (size_t)written < buffer->capacity) {
+            buffer->size += (size_t)written;
+            return;
+        }
+        buffer->capacity = (buffer->capacity) ? 2 * buffer->capacity : 4096;
+        buffer->data = realloc(buffer->data, buffer->capacity);
+        if (buffer->data == NULL) {
+            fprintf(stderr, "bench: failed to allocate script\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static double bench_now(void)
+{
+    struct timespec time_spec;
+    clock_gettime(CLOCK_MONOTONIC, &time_spec);
+    return time_spec.tv_sec + time_spec.tv_nsec * 1e-9;
+}
+
+static void generate_script(BenchBuffer *buffer, const size_t units)
+{
+    for (size_t i = 0; i < units; ++i) {
+        if (i % 2)
+            bench_append(buffer, "var v%zu = %zu * (v%zu + 4) - \"}{;\";\n", i, i, i - 1);
+        else
+            bench_append(buffer, "funct f%zu(a, b) {\n    # ; }\n    if (a > %zu) { return a; }\n    return b * 2;\n}\n", i, i);
+    }
+}
+
+static double bench_parse(const Source *source, const size_t jobs, size_t *statement_num)
+{
+    TokenVector ctokens = {NULL, 0, 0};
+    Arena arena = {NULL, 0, 0, NULL};
+
+    double start = bench_now();
+    AST **ast = frontend_parse(source, &ctokens, statement_num, &arena, jobs);
+    double end = bench_now();
+    if (ast == NULL || error_flag) {
+        fprintf(stderr, "bench: generated script did not parse with %zu jobs\n", jobs);
+        exit(EXIT_FAILURE);
+    }
+    arena_release(&arena);
+    token_vector_free(&ctokens);
+    symbol_table_free();
+    return end - start;
+}
+
+int main(void)
+{
+    /* Parser prints debug output on stdout, keep it out of the report */
+    FILE *report = fdopen(dup(fileno(stdout)), "w");
+    if (report == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        fprintf(stderr, "bench: failed to redirect stdout\n");
+        return EXIT_FAILURE;
+    }
+
+    BenchBuffer script = {NULL, 0, 0};
+    generate_script(&script, BENCH_UNITS);
+    Source source = {.data = script.data, .size = script.size};
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_jobs = (cpus > 2) ? (size_t)cpus : 2;
+    size_t sequential_statements = 0;
+    double sequential = INFINITY;
+    int failed = 0;
+
+    fprintf(report, "%zu bytes, %ld online CPUs\n%-6s %12s %12s %10s\n", script.size, cpus, "jobs", "seconds", "MB/s", "speedup");
+    for (size_t jobs = 1; jobs <= max_jobs && jobs <= FRONTEND_MAX_JOBS; jobs *= 2) {
+        double seconds = INFINITY;
+        size_t statement_num = 0;
+        /* Best of several runs filters out scheduler noise */
+        for (size_t repeat = 0; repeat < BENCH_REPEAT; ++repeat)
+            seconds = fmin(seconds, bench_parse(&source, jobs, &statement_num));
+        if (jobs == 1) {
+            sequential = seconds;
+            sequential_statements = statement_num;
+        }
+        if (statement_num != sequential_statements)
+            failed = 1;
+        fprintf(report, "%-6zu %12.6f %12.1f %9.2fx%s\n", jobs, seconds, script.size / seconds / 1e6, sequential / seconds,
+            (statement_num != sequential_statements) ? "  STATEMENTS DIFFER" : "");
+    }
+
+    free(script.data);
+    fclose(report);
+    return (failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* Engine benchmark: runs loop-heavy, call-heavy, recursion-heavy, string-heavy and concatenation scripts with
+ * tree interpreter, flat interpreter, closure engine and bytecode virtual machine */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <setjmp.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "coretypes.h"
+#include "error.h"
+#include "lexer.h"
+#include "arena.h"
+#include "parser.h"
+#include "symbol.h"
+#include "environment.h"
+#include "interpreter.h"
+#include "flat_ast.h"
+#include "flat_interpreter.h"
+#include "optimizer.h"
+#include "resolver.h"
+#include "frontend.h"
+#include "bytecode.h"
+#include "vm.h"
+#include "closure.h"
+
+#define BENCH_REPEAT 3
+
+/*@Type BenchScript: Script run by every engine */
+typedef struct bench_script_s
+{
+    const char *name;
+    const char *text;
+} BenchScript;
+
+static const BenchScript scripts[] = {
+    {"loop",
+     "{\n"
+     "    var total = 0;\n"
+     "    for (var i = 0; i < 1000000; i = i + 1) {\n"
+     "        total = total + i * 2 - 1;\n"
+     "        if (total > 1000000) total = total - 1000000;\n"
+     "    }\n"
+     "    echo total;\n"
+     "}\n"},
+    {"calls",
+     "funct add(a, b) {\n"
+     "    return a + b;\n"
+     "}\n"
+     "{\n"
+     "    var sum = 0;\n"
+     "    for (var i = 0; i < 200000; i = i + 1) sum = add(sum, i);\n"
+     "    echo sum;\n"
+     "}\n"},
+    {"recursion",
+     "funct fib(n) {\n"
+     "    if (n < 2) return n;\n"
+     "    return fib(n - 1) + fib(n - 2);\n"
+     "}\n"
+     "echo fib(25);\n"},
+    /* Large string is passed and stored many times, copies share its bytes */
+    {"strings",
+     "funct id(x) {\n"
+     "    return x;\n"
+     "}\n"
+     "{\n"
+     "    var s = \"x\";\n"
+     "    for (var i = 0; i < 20; i = i + 1) s = s + s;\n"
+     "    var n = 0;\n"
+     "    for (var i = 0; i < 20000; i = i + 1) {\n"
+     "        var t = id(s);\n"
+     "        n = n + 1;\n"
+     "    }\n"
+     "    echo n;\n"
+     "}\n"},
+    /* 10 MB string is built by appending to it, it grows in place */
+    {"concat",
+     "{\n"
+     "    var s = \"\";\n"
+     "    for (var i = 0; i < 1000000; i = i + 1) s = s + \"0123456789\";\n"
+     "}\n"},
+};
+
+static double bench_now(void)
+{
+    struct timespec time_spec;
+    clock_gettime(CLOCK_MONOTONIC, &time_spec);
+    return time_spec.tv_sec + time_spec.tv_nsec * 1e-9;
+}
+
+/* Runs every statement with engine and returns seconds, global scope is emptied after run like in run_file */
+static double bench_run(const Engine engine, AST **ast, const size_t number_of_statements, FlatAST *flat, const Bytecode *bytecode, Closure **closures)
+{
+    double start = bench_now();
+    for (size_t i = 0; i < number_of_statements; ++i) {
+        if (ast[i] == NULL) continue;
+        if (engine == ENGINE_VM) vm_interpret(bytecode, i);
+        else if (engine == ENGINE_FLAT) flat_interpret(flat, flat->extra[flat->roots + i]);
+        else if (engine == ENGINE_CLOSURE) closure_interpret(closures[i]);
+        else interpret(ast[i]);
+        if (error_flag) {
+            fprintf(stderr, "bench: engine failed on generated script\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    double end = bench_now();
+    env_reset(&env_global);
+    /* env_reset frees the map but leaves it pointing at freed memory */
+    env_global.env = NULL;
+    env_global.env_return = NULL;
+    return end - start;
+}
+
+int main(void)
+{
+    /* Scripts echo their results, keep them out of the report */
+    FILE *report = fdopen(dup(fileno(stdout)), "w");
+    if (report == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        fprintf(stderr, "bench: failed to redirect stdout\n");
+        return EXIT_FAILURE;
+    }
+
+    fprintf(report, "%-10s %12s %12s %12s %12s %12s\n", "script", "tree", "flat", "closure", "vm", "vm speedup");
+    for (size_t s = 0; s < sizeof(scripts) / sizeof(scripts[0]); ++s) {
+        Source source = {.data = (char *)scripts[s].text, .size = strlen(scripts[s].text)};
+        TokenVector ctokens = {NULL, 0, 0};
+        Arena ast_arena = {NULL, 0, 0, NULL};
+        FlatAST flat = {0};
+        Bytecode bytecode = {0};
+        size_t number_of_statements = 0;
+
+        reset_error_flag();
+        if (source_lexer(&source, &ctokens) == NULL) {
+            fprintf(stderr, "bench: source_lexer failed on %s script\n", scripts[s].name);
+            return EXIT_FAILURE;
+        }
+        AST **ast = parser(ctokens.tokens, &number_of_statements, &ast_arena);
+        if (ast == NULL || error_flag) {
+            fprintf(stderr, "bench: %s script did not parse\n", scripts[s].name);
+            return EXIT_FAILURE;
+        }
+        ast_optimize(ast, number_of_statements, &ast_arena);
+        ast_resolve(ast, number_of_statements);
+        flat_ast_build(&flat, ast, number_of_statements, ctokens.tokens, ctokens.size);
+        bytecode_build(&bytecode, &flat);
+        Closure **closures = malloc(sizeof(Closure *) * number_of_statements);
+        for (size_t i = 0; i < number_of_statements; ++i) {
+            closures[i] = (ast[i] == NULL) ? NULL : closure_build(ast[i]);
+        }
+
+        double tree = INFINITY, flat_time = INFINITY, closure = INFINITY, vm = INFINITY;
+        /* Best of several runs filters out scheduler noise */
+        for (size_t repeat = 0; repeat < BENCH_REPEAT; ++repeat) {
+            tree = fmin(tree, bench_run(ENGINE_TREE, ast, number_of_statements, &flat, &bytecode, closures));
+            flat_time = fmin(flat_time, bench_run(ENGINE_FLAT, ast, number_of_statements, &flat, &bytecode, closures));
+            closure = fmin(closure, bench_run(ENGINE_CLOSURE, ast, number_of_statements, &flat, &bytecode, closures));
+            vm = fmin(vm, bench_run(ENGINE_VM, ast, number_of_statements, &flat, &bytecode, closures));
+        }
+        fprintf(report, "%-10s %12.6f %12.6f %12.6f %12.6f %11.2fx\n", scripts[s].name, tree, flat_time, closure, vm, tree / vm);
+
+        free(closures);
+        closure_release();
+        bytecode_free(&bytecode);
+        flat_ast_free(&flat);
+        arena_release(&ast_arena);
+        frontend_release();
+        token_vector_free(&ctokens);
+        symbol_table_free();
+    }
+    vm_release();
+    fclose(report);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,385 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "coretypes.h"
+#include "error.h"
+#include "value.h"
+#include "flat_ast.h"
+#include "bytecode.h"
+
+static uint32_t bytecode_add_chunk(Bytecode *bytecode)
+{
+    if(bytecode->chunk_num >= bytecode->chunk_capacity) {
+        bytecode->chunk_capacity = (bytecode->chunk_capacity) ? bytecode->chunk_capacity * 2 : BYTECODE_FIRST_CAPACITY;
+        bytecode->chunks = realloc(bytecode->chunks, sizeof(Chunk *) * bytecode->chunk_capacity);
+        if(bytecode->chunks == NULL) {
+            INTERNAL_ERROR("Could not reallocate bytecode chunks!");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    uint32_t chunk = bytecode->chunk_num++;
+    bytecode->chunks[chunk] = calloc(1, sizeof(Chunk));
+    if(bytecode->chunks[chunk] == NULL) {
+        INTERNAL_ERROR("Could not allocate bytecode chunk!");
+        exit(EXIT_FAILURE);
+    }
+    bytecode->chunks[chunk]->bytecode = bytecode;
+    bytecode->chunks[chunk]->index = chunk;
+    return chunk;
+}
+
+static uint32_t bytecode_emit(Bytecode *bytecode, const uint32_t chunk, const uint32_t word)
+{
+    Chunk *target = bytecode->chunks[chunk];
+    if(target->code_size >= target->code_capacity) {
+        target->code_capacity = (target->code_capacity) ? target->code_capacity * 2 : BYTECODE_FIRST_CAPACITY;
+        target->code = realloc(target->code, sizeof(uint32_t) * target->code_capacity);
+        if(target->code == NULL) {
+            INTERNAL_ERROR("Could not reallocate bytecode!");
+            exit(EXIT_FAILURE);
+        }
+    }
+    target->code[target->code_size] = word;
+    return (uint32_t)target->code_size++;
+}
+
+static void bytecode_emit_op(Bytecode *bytecode, const uint32_t chunk, const Opcode opcode, const int stack_effect)
+{
+    bytecode_emit(bytecode, chunk, opcode);
+    Chunk *target = bytecode->chunks[chunk];
+    target->stack_depth += stack_effect;
+    if(target->stack_depth > target->stack_max) target->stack_max = target->stack_depth;
+}
+
+static void bytecode_patch(Bytecode *bytecode, const uint32_t chunk, const uint32_t offset)
+{
+    bytecode->chunks[chunk]->code[offset] = (uint32_t)bytecode->chunks[chunk]->code_size;
+}
+
+static uint32_t bytecode_add_constant(Bytecode *bytecode, Token *token)
+{
+    if(bytecode->constant_num >= bytecode->constant_capacity) {
+        bytecode->constant_capacity = (bytecode->constant_capacity) ? bytecode->constant_capacity * 2 : BYTECODE_FIRST_CAPACITY;
+        bytecode->constants = realloc(bytecode->constants, sizeof(ValueTagged) * bytecode->constant_capacity);
+        if(bytecode->constants == NULL) {
+            INTERNAL_ERROR("Could not reallocate bytecode constants!");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* Literal is converted once, running code pushes copies of it */
+    ValueTagged *value = value_from_token(token);
+    bytecode->constants[bytecode->constant_num] = *value;
+    free(value);
+    return (uint32_t)bytecode->constant_num++;
+}
+
+static Opcode bytecode_binary_opcode(const TokenType operator)
+{
+    switch(operator) {
+        case ADD:                                   return OP_ADD;
+        case SUBTRACT:                              return OP_SUBTRACT;
+        case MULTIPLY:                              return OP_MULTIPLY;
+        case DIVIDE:                                return OP_DIVIDE;
+        case DOUBLE_EQUAL:                          return OP_EQUAL;
+        case EXCLAMATION_EQUEAL:                    return OP_NOT_EQUAL;
+        case REDIRECTION_LEFT_LESS_RELATIONAL:      return OP_LESS;
+        case LESS_EQUAL:                            return OP_LESS_EQUAL;
+        case REDIRECTION_RIGHT_GREATER_RELATIONAL:  return OP_GREATER;
+        case GREATER_EQUAL:                         return OP_GREATER_EQUAL;
+        default:                                    return OP_BINARY;
+    }
+}
+
+static void bytecode_compile_expression(Bytecode *bytecode, const uint32_t chunk, const FlatNode node)
+{
+    const FlatAST *flat = bytecode->flat;
+    uint32_t jump;
+
+    switch(flat->tags[node]) {
+        case AST_LITERAL:
+            bytecode_emit_op(bytecode, chunk, OP_CONSTANT, 1);
+            bytecode_emit(bytecode, chunk, bytecode_add_constant(bytecode, flat_ast_token(flat, node)));
+            return;
+        case AST_IDENTIFIER:
+            bytecode_emit_op(bytecode, chunk, OP_GET, 1);
+            bytecode_emit(bytecode, chunk, node);
+            return;
+        case AST_GROUPING_EXPR:
+        case AST_EXPR_STMT:
+            bytecode_compile_expression(bytecode, chunk, flat->lhs[node]);
+            return;
+        case AST_UNARY_EXPR:
+            bytecode_compile_expression(bytecode, chunk, flat->lhs[node]);
+            bytecode_emit_op(bytecode, chunk, OP_UNARY, 0);
+            bytecode_emit(bytecode, chunk, node);
+            return;
+        case AST_BINARY_EXPR:
+            bytecode_compile_expression(bytecode, chunk, flat->lhs[node]);
+            bytecode_compile_expression(bytecode, chunk, flat->rhs[node]);
+            bytecode_emit_op(bytecode, chunk, bytecode_binary_opcode(flat_ast_token(flat, node)->type), -1);
+            bytecode_emit(bytecode, chunk, node);
+            return;
+        case AST_LOGICAL_EXPR:
+            /* Left value is the result if it decides the expression, otherwise it is replaced by right value */
+            bytecode_compile_expression(bytecode, chunk, flat->lhs[node]);
+            bytecode_emit_op(bytecode, chunk, (flat_ast_token(flat, node)->type == DOUBLE_OR) ? OP_JUMP_IF_TRUE_OR_POP 
+                                                                                             : OP_JUMP_IF_FALSE_OR_POP, -1);
+            jump = bytecode_emit(bytecode, chunk, 0);
+            bytecode_compile_expression(bytecode, chunk, flat->rhs[node]);
+            bytecode_patch(bytecode, chunk, jump);
+            return;
+        case AST_ASSIGN_EXPR:
+            /* Value of assignment is NULL like in interpreters */
+            bytecode_compile_expression(bytecode, chunk, flat->lhs[node]);
+            bytecode_emit_op(bytecode, chunk, OP_ASSIGN, -1);
+            bytecode_emit(bytecode, chunk, node);
+            bytecode_emit_op(bytecode, chunk, OP_NIL, 1);
+            return;
+        case AST_CALL_EXPR:
+            for(size_t i = 0; i < flat->rhs[node]; ++i) {
+                bytecode_compile_expression(bytecode, chunk, flat->extra[flat->lhs[node] + i]);
+            }
+            bytecode_emit_op(bytecode, chunk, OP_CALL, 1 - (int)flat->rhs[node]);
+            bytecode_emit(bytecode, chunk, node);
+            bytecode_emit(bytecode, chunk, flat->rhs[node]);
+            return;
+        default:
+            /* Statement used as expression, e.g. initializer of for loop */
+            bytecode_compile_statement(bytecode, chunk, node);
+            bytecode_emit_op(bytecode, chunk, OP_NIL, 1);
+            return;
+    }
+}
+
+static void bytecode_compile_statement(Bytecode *bytecode, const uint32_t chunk, const FlatNode node)
+{
+    const FlatAST *flat = bytecode->flat;
+    const FlatNode *clauses;
+    uint32_t loop, jump, end;
+
+    switch(flat->tags[node]) {
+        case AST_EXPR_STMT:
+            /* Assignment statement does not push its NULL value */
+            if(flat->tags[flat->lhs[node]] == AST_ASSIGN_EXPR) {
+                FlatNode assign = flat->lhs[node];
+                bytecode_compile_expression(bytecode, chunk, flat->lhs[assign]);
+                bytecode_emit_op(bytecode, chunk, OP_ASSIGN, -1);
+                bytecode_emit(bytecode, chunk, assign);
+                return;
+            }
+            bytecode_compile_expression(bytecode, chunk, flat->lhs[node]);
+            bytecode_emit_op(bytecode, chunk, OP_POP, -1);
+            return;
+        case AST_VAR_DECL_STMT:
+            if(flat->lhs[node] != FLAT_NONE) 
+                bytecode_compile_expression(bytecode, chunk, flat->lhs[node]);
+            else
+                bytecode_emit_op(bytecode, chunk, OP_NIL, 1);
+            bytecode_emit_op(bytecode, chunk, OP_DEFINE, -1);
+            bytecode_emit(bytecode, chunk, node);
+            return;
+        case AST_FUNCT_DECL_STMT:
+        {
+            uint32_t function = bytecode_compile_function(bytecode, node);
+            bytecode_emit_op(bytecode, chunk, OP_FUNCTION, 0);
+            bytecode_emit(bytecode, chunk, node);
+            bytecode_emit(bytecode, chunk, function);
+            return;
+        }
+        case AST_BLOCK_STMT:
+            bytecode_emit_op(bytecode, chunk, OP_ENTER, 0);
+            bytecode_emit(bytecode, chunk, flat->extra[flat->lhs[node]]);
+            for(size_t i = 0; i < flat->rhs[node]; ++i) {
+                bytecode_compile_statement(bytecode, chunk, flat->extra[flat->lhs[node] + 1 + i]);
+            }
+            bytecode_emit_op(bytecode, chunk, OP_LEAVE, 0);
+            return;
+        case AST_IF_STMT:
+            bytecode_compile_expression(bytecode, chunk, flat->lhs[node]);
+            bytecode_emit_op(bytecode, chunk, OP_JUMP_IF_FALSE, -1);
+            jump = bytecode_emit(bytecode, chunk, 0);
+            bytecode_compile_statement(bytecode, chunk, flat->extra[flat->rhs[node]]);
+            if(flat->extra[flat->rhs[node] + 1] == FLAT_NONE) {
+                bytecode_patch(bytecode, chunk, jump);
+                return;
+            }
+            bytecode_emit_op(bytecode, chunk, OP_JUMP, 0);
+            end = bytecode_emit(bytecode, chunk, 0);
+            bytecode_patch(bytecode, chunk, jump);
+            bytecode_compile_statement(bytecode, chunk, flat->extra[flat->rhs[node] + 1]);
+            bytecode_patch(bytecode, chunk, end);
+            return;
+        case AST_WHILE_STMT:
+            loop = (uint32_t)bytecode->chunks[chunk]->code_size;
+            bytecode_compile_expression(bytecode, chunk, flat->lhs[node]);
+            bytecode_emit_op(bytecode, chunk, OP_JUMP_IF_FALSE, -1);
+            end = bytecode_emit(bytecode, chunk, 0);
+            bytecode_compile_statement(bytecode, chunk, flat->rhs[node]);
+            bytecode_emit_op(bytecode, chunk, OP_JUMP, 0);
+            bytecode_emit(bytecode, chunk, loop);
+            bytecode_patch(bytecode, chunk, end);
+            return;
+        case AST_FOR_STMT:
+            /* Clauses are stored in extra, which may not be reallocated anymore */
+            clauses = &flat->extra[flat->lhs[node]];
+            bytecode_emit_op(bytecode, chunk, OP_ENTER, 0);
+            bytecode_emit(bytecode, chunk, clauses[3]);
+            if(clauses[0] != FLAT_NONE) bytecode_compile_statement(bytecode, chunk, clauses[0]);
+            loop = (uint32_t)bytecode->chunks[chunk]->code_size;
+            end = 0;
+            if(clauses[1] != FLAT_NONE) {
+                bytecode_compile_expression(bytecode, chunk, clauses[1]);
+                bytecode_emit_op(bytecode, chunk, OP_JUMP_IF_FALSE, -1);
+                end = bytecode_emit(bytecode, chunk, 0);
+            }
+            bytecode_compile_statement(bytecode, chunk, flat->rhs[node]);
+            if(clauses[2] != FLAT_NONE) {
+                bytecode_compile_expression(bytecode, chunk, clauses[2]);
+                bytecode_emit_op(bytecode, chunk, OP_POP, -1);
+            }
+            bytecode_emit_op(bytecode, chunk, OP_JUMP, 0);
+            bytecode_emit(bytecode, chunk, loop);
+            if(clauses[1] != FLAT_NONE) bytecode_patch(bytecode, chunk, end);
+            bytecode_emit_op(bytecode, chunk, OP_LEAVE, 0);
+            return;
+        case AST_ECHO_STMT:
+            bytecode_compile_expression(bytecode, chunk, flat->lhs[node]);
+            bytecode_emit_op(bytecode, chunk, OP_ECHO, -1);
+            return;
+        case AST_RETURN_STMT:
+            if(flat->lhs[node] != FLAT_NONE) 
+                bytecode_compile_expression(bytecode, chunk, flat->lhs[node]);
+            else
+                bytecode_emit_op(bytecode, chunk, OP_NIL, 1);
+            bytecode_emit_op(bytecode, chunk, OP_RETURN, -1);
+            return;
+        case AST_TIME_STMT:
+            bytecode_emit_op(bytecode, chunk, OP_TIME, 0);
+            return;
+        case AST_CLEAR_STMT:
+            bytecode_emit_op(bytecode, chunk, OP_CLEAR, 0);
+            return;
+        case AST_CD_STMT:
+            bytecode_emit_op(bytecode, chunk, OP_CD, 0);
+            bytecode_emit(bytecode, chunk, node);
+            return;
+        case AST_RUN_STMT:
+            for(size_t i = 0; i < flat->rhs[node]; ++i) {
+                bytecode_compile_expression(bytecode, chunk, flat->extra[flat->lhs[node] + i]);
+            }
+            bytecode_emit_op(bytecode, chunk, OP_RUN, -(int)flat->rhs[node]);
+            bytecode_emit(bytecode, chunk, node);
+            bytecode_emit(bytecode, chunk, flat->rhs[node]);
+            return;
+        case AST_LITERAL:
+        case AST_IDENTIFIER:
+        case AST_GROUPING_EXPR:
+        case AST_UNARY_EXPR:
+        case AST_BINARY_EXPR:
+        case AST_LOGICAL_EXPR:
+        case AST_ASSIGN_EXPR:
+        case AST_CALL_EXPR:
+            bytecode_compile_expression(bytecode, chunk, node);
+            bytecode_emit_op(bytecode, chunk, OP_POP, -1);
+            return;
+        default:
+            break;
+    }
+    INTERNAL_ERROR("Tried to compile undefined AST node type.");
+    exit(EXIT_FAILURE);
+}
+
+static uint32_t bytecode_compile_function(Bytecode *bytecode, const FlatNode node)
+{
+    /* Body is compiled by bytecode_compile_body on first call */
+    uint32_t chunk = bytecode_add_chunk(bytecode);
+    bytecode->chunks[chunk]->function = node;
+    return chunk;
+}
+
+extern int bytecode_compile_body(Chunk *body)
+{
+    if(body->code != NULL) return TRUE;
+
+    Bytecode *bytecode = body->bytecode;
+    FlatAST *flat = bytecode->flat;
+    if(!flat_ast_lower_function(flat, body->function)) return FALSE;
+
+    uint32_t definition = flat->lhs[body->function];
+    body->param_num = flat->extra[definition];
+    body->slot_num = flat->extra[definition + 2];
+    body->parameters = definition + 3;
+    for(size_t i = 0; i < flat->extra[definition + 1]; ++i) {
+        bytecode_compile_statement(bytecode, body->index, flat->extra[definition + 3 + body->param_num + i]);
+    }
+    /* Function without return statement returns NULL */
+    bytecode_emit_op(bytecode, body->index, OP_NIL, 1);
+    bytecode_emit_op(bytecode, body->index, OP_RETURN, -1);
+    return TRUE;
+}
+
+extern void bytecode_build(Bytecode *bytecode, FlatAST *flat)
+{
+    memset(bytecode, 0, sizeof(Bytecode));
+    bytecode->flat = flat;
+    bytecode->root_num = flat->root_num;
+
+    /* Chunks of roots are added first, so that root i is chunk i */
+    for(size_t i = 0; i < flat->root_num; ++i) {
+        bytecode_add_chunk(bytecode);
+    }
+    for(size_t i = 0; i < flat->root_num; ++i) {
+        if(flat->extra[flat->roots + i] != FLAT_NONE) bytecode_compile_statement(bytecode, i, flat->extra[flat->roots + i]);
+        bytecode_emit_op(bytecode, i, OP_HALT, 0);
+    }
+}
+
+extern size_t bytecode_bytes(const Bytecode *bytecode)
+{
+    size_t bytes = bytecode->chunk_num * (sizeof(Chunk *) + sizeof(Chunk)) + bytecode->constant_num * sizeof(ValueTagged);
+    for(size_t i = 0; i < bytecode->chunk_num; ++i) {
+        bytes += bytecode->chunks[i]->code_size * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+extern void bytecode_free(Bytecode *bytecode)
+{
+    for(size_t i = 0; i < bytecode->chunk_num; ++i) {
+        free(bytecode->chunks[i]->code);
+        free(bytecode->chunks[i]);
+    }
+    for(size_t i = 0; i < bytecode->constant_num; ++i) {
+        if(bytecode->constants[i].type == STRING) string_free(bytecode->constants[i].literal.char_value);
+    }
+    free(bytecode->chunks);
+    free(bytecode->constants);
+    memset(bytecode, 0, sizeof(Bytecode));
+}
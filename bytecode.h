@@ -0,0 +1,84 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#define BYTECODE_FIRST_CAPACITY 64
+
+/*@Function: bytecode_add_chunk
+*Helper Function: Appends empty chunk and returns its index, chunks are addressed by index while compiling */
+static uint32_t bytecode_add_chunk(Bytecode *);
+
+/*@Function: bytecode_emit
+*Helper Function: Appends code word to chunk and returns its offset */
+static uint32_t bytecode_emit(Bytecode *, const uint32_t, const uint32_t);
+
+/*@Function: bytecode_emit_op
+*Helper Function: Appends opcode to chunk and records its effect on operand stack depth */
+static void bytecode_emit_op(Bytecode *, const uint32_t, const Opcode, const int);
+
+/*@Function: bytecode_patch
+*Helper Function: Sets jump target at offset to the end of chunk code */
+static void bytecode_patch(Bytecode *, const uint32_t, const uint32_t);
+
+/*@Function: bytecode_add_constant
+*Helper Function: Appends value of literal token to constants and returns its index */
+static uint32_t bytecode_add_constant(Bytecode *, Token *);
+
+/*@Function: bytecode_binary_opcode
+*Helper Function: Returns opcode of binary operator, OP_BINARY for operators without their own opcode */
+static Opcode bytecode_binary_opcode(const TokenType);
+
+/*@Function: bytecode_compile_expression
+*Helper Function: Compiles expression node, code leaves one value on operand stack */
+static void bytecode_compile_expression(Bytecode *, const uint32_t, const FlatNode);
+
+/*@Function: bytecode_compile_statement
+*Helper Function: Compiles statement node, code leaves operand stack as it was */
+static void bytecode_compile_statement(Bytecode *, const uint32_t, const FlatNode);
+
+/*@Function: bytecode_compile_function
+*Helper Function: Adds empty chunk for body of function declaration and returns its index */
+static uint32_t bytecode_compile_function(Bytecode *, const FlatNode);
+
+/*@Function: bytecode_compile_body
+*Function that lowers and compiles body of function chunk on its first call, does nothing if chunk is compiled.
+*Returns FALSE and sets error_flag if body does not parse */
+extern int bytecode_compile_body(Chunk *);
+
+/*@Function: bytecode_build
+*Function that compiles every statement of FlatAST roots into its own chunk, FlatAST must outlive Bytecode.
+*Function bodies are compiled by bytecode_compile_body when they are called */
+extern void bytecode_build(Bytecode *, FlatAST *);
+
+/*@Function: bytecode_bytes
+*Function that returns number of bytes used by code and constants of Bytecode */
+extern size_t bytecode_bytes(const Bytecode *);
+
+/*@Function: bytecode_free
+*Function that frees chunks and constants of Bytecode */
+extern void bytecode_free(Bytecode *);
+
+#endif // BYTECODE_H
@@ -0,0 +1,266 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "coretypes.h"
+#include "error.h"
+#include "lexer.h"
+#include "symbol.h"
+#include "trace.h"
+#include "flat_ast.h"
+#include "cache.h"
+
+static void *cache_mapping = NULL;
+static size_t cache_mapping_size = 0;
+
+static int cache_directory(char *path, const size_t size)
+{
+    const char *directory = getenv("CASH_CACHE_DIR");
+    if(directory != NULL && *directory != '\0') 
+        return snprintf(path, size, "%s", directory) < (int)size;
+
+    directory = getenv("XDG_CACHE_HOME");
+    if(directory != NULL && *directory != '\0') 
+        return snprintf(path, size, "%s/cash", directory) < (int)size;
+
+    directory = getenv("HOME");
+    if(directory != NULL && *directory != '\0') 
+        return snprintf(path, size, "%s/.cache/cash", directory) < (int)size;
+    return FALSE;
+}
+
+static int cache_make_directory(char *path)
+{
+    /* Create every parent, existing directories are fine */
+    for(char *slash = strchr(path + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
+        int result = mkdir(path, 0700);
+        *slash = '/';
+        if(result < 0 && errno != EEXIST) return FALSE;
+    }
+    return !(mkdir(path, 0700) < 0 && errno != EEXIST);
+}
+
+static int cache_file_path(char *path, const size_t size, const uint64_t hash)
+{
+    char directory[CACHE_PATH_SIZE];
+    if(!cache_directory(directory, CACHE_PATH_SIZE)) return FALSE;
+    return snprintf(path, size, "%s/%016llx.cashc", directory, (unsigned long long)hash) < (int)size;
+}
+
+static size_t cache_expected_size(const CacheHeader *header)
+{
+    return sizeof(CacheHeader) 
+         + (header->token_num + header->constant_num) * sizeof(CacheToken)
+         + header->node_num * 3 * sizeof(uint32_t)
+         + header->extra_num * sizeof(FlatNode)
+         + header->node_num * sizeof(uint8_t)
+         + header->string_size;
+}
+
+extern uint64_t cache_hash(const Source *source)
+{
+    uint64_t hash = CACHE_FNV_OFFSET;
+    for(size_t i = 0; i < source->size; ++i) {
+        hash ^= (unsigned char)source->data[i];
+        hash *= CACHE_FNV_PRIME;
+    }
+    return hash;
+}
+
+extern int cache_load(const Source *source, const uint64_t hash, TokenVector *ctokens, FlatAST *flat)
+{
+    char path[CACHE_PATH_SIZE];
+    struct stat file_stat;
+    if(!cache_file_path(path, CACHE_PATH_SIZE, hash)) return FALSE;
+
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        TRACE(TRACE_PARSER, "Cache miss %s\n", path);
+        return FALSE;
+    }
+    if(fstat(fd, &file_stat) < 0 || (size_t)file_stat.st_size < sizeof(CacheHeader)) {
+        close(fd);
+        return FALSE;
+    }
+    unsigned char *data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) return FALSE;
+
+    /* Stale entry is detected by version, token numbering, hash and size of the source */
+    const CacheHeader *header = (const CacheHeader *)data;
+    if(memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) || header->version != CACHE_VERSION || 
+       header->token_type_count != TOKEN_TYPE_COUNT || header->source_hash != hash || 
+       header->source_size != source->size || cache_expected_size(header) != (size_t)file_stat.st_size) {
+        TRACE(TRACE_PARSER, "Cache entry %s is stale\n", path);
+        munmap(data, file_stat.st_size);
+        return FALSE;
+    }
+
+    const CacheToken *tokens = (const CacheToken *)(data + sizeof(CacheHeader));
+    const uint32_t *node_tokens = (const uint32_t *)(tokens + header->token_num + header->constant_num);
+    const uint32_t *lhs = node_tokens + header->node_num;
+    const uint32_t *rhs = lhs + header->node_num;
+    const FlatNode *extra = rhs + header->node_num;
+    const uint8_t *tags = (const uint8_t *)(extra + header->extra_num);
+    const char *strings = (const char *)(tags + header->node_num);
+
+    ctokens->tokens = malloc(sizeof(Token) * header->token_num);
+    flat->constants = malloc(sizeof(Token) * header->constant_num);
+    if(ctokens->tokens == NULL || (header->constant_num && flat->constants == NULL)) {
+        INTERNAL_ERROR("Could not allocate tokens loaded from cache!");
+        exit(EXIT_FAILURE);
+    }
+    ctokens->size = ctokens->capacity = header->token_num;
+
+    for(size_t i = 0; i < header->token_num + header->constant_num; ++i) {
+        Token token = {
+            .type = tokens[i].type,
+            .lexeme = NULL,
+            .literal = tokens[i].literal,
+            .line_number = tokens[i].line_number,
+            .offset = tokens[i].offset,
+            .length = tokens[i].length,
+            .symbol = 0
+        };
+        if(i < header->token_num) {
+            /* Lexemes of source tokens are materialized from source, names are interned again */
+            if(token.type == STRING) token.literal.char_value = NULL;
+            if(token.type == IDENTIFIER) token.symbol = symbol_intern(source->data + token.offset, token.length);
+            ctokens->tokens[i] = token;
+        }
+        else {
+            token.lexeme = (char *)strings + tokens[i].string;
+            if(token.type == STRING) token.literal.char_value = token.lexeme;
+            flat->constants[i - header->token_num] = token;
+        }
+    }
+
+    flat->token_base = ctokens->tokens;
+    flat->token_num = header->token_num;
+    flat->constant_num = flat->constant_capacity = header->constant_num;
+    flat->node_num = flat->node_capacity = header->node_num;
+    flat->extra_num = flat->extra_capacity = header->extra_num;
+    flat->tags = malloc(sizeof(uint8_t) * header->node_num);
+    flat->tokens = malloc(sizeof(uint32_t) * header->node_num);
+    flat->lhs = malloc(sizeof(uint32_t) * header->node_num);
+    flat->rhs = malloc(sizeof(uint32_t) * header->node_num);
+    flat->extra = malloc(sizeof(FlatNode) * header->extra_num);
+    if(flat->tags == NULL || flat->tokens == NULL || flat->lhs == NULL || flat->rhs == NULL || (header->extra_num && flat->extra == NULL)) {
+        INTERNAL_ERROR("Could not allocate flat AST loaded from cache!");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(flat->tags, tags, sizeof(uint8_t) * header->node_num);
+    memcpy(flat->tokens, node_tokens, sizeof(uint32_t) * header->node_num);
+    memcpy(flat->lhs, lhs, sizeof(uint32_t) * header->node_num);
+    memcpy(flat->rhs, rhs, sizeof(uint32_t) * header->node_num);
+    memcpy(flat->extra, extra, sizeof(FlatNode) * header->extra_num);
+    flat->roots = header->roots;
+    flat->root_num = header->root_num;
+
+    source_attach(source);
+    flat_ast_make_strings(flat);
+    cache_mapping = data;
+    cache_mapping_size = file_stat.st_size;
+    TRACE(TRACE_PARSER, "Cache hit %s\n", path);
+    return TRUE;
+}
+
+extern void cache_store(const Source *source, const uint64_t hash, TokenVector *ctokens, const FlatAST *flat)
+{
+    char directory[CACHE_PATH_SIZE], path[CACHE_PATH_SIZE], temporary[CACHE_PATH_SIZE];
+    if(!cache_directory(directory, CACHE_PATH_SIZE) || !cache_make_directory(directory)) return;
+    if(!cache_file_path(path, CACHE_PATH_SIZE, hash)) return;
+    if(snprintf(temporary, CACHE_PATH_SIZE, "%s.%d", path, (int)getpid()) >= CACHE_PATH_SIZE) return;
+
+    FILE *file = fopen(temporary, "wb");
+    if(file == NULL) return;
+
+    CacheHeader header = {
+        .magic = CACHE_MAGIC,
+        .version = CACHE_VERSION,
+        .token_type_count = TOKEN_TYPE_COUNT,
+        .source_hash = hash,
+        .source_size = source->size,
+        .token_num = ctokens->size,
+        .constant_num = flat->constant_num,
+        .node_num = flat->node_num,
+        .extra_num = flat->extra_num,
+        .string_size = 0,
+        .roots = flat->roots,
+        .root_num = flat->root_num
+    };
+    for(size_t i = 0; i < flat->constant_num; ++i)
+        header.string_size += strlen(flat->constants[i].lexeme) + 1;
+    fwrite(&header, sizeof(CacheHeader), 1, file);
+
+    uint64_t string = 0;
+    for(size_t i = 0; i < ctokens->size + flat->constant_num; ++i) {
+        const Token *token = (i < ctokens->size) ? &ctokens->tokens[i] : &flat->constants[i - ctokens->size];
+        CacheToken record = {
+            .type = token->type,
+            .length = token->length,
+            .offset = token->offset,
+            .line_number = token->line_number,
+            .string = CACHE_NO_STRING,
+            .literal = token->literal
+        };
+        if(token->type == STRING || token->type == IDENTIFIER) record.literal.char_value = NULL;
+        if(i >= ctokens->size) {
+            record.string = string;
+            string += strlen(token->lexeme) + 1;
+        }
+        fwrite(&record, sizeof(CacheToken), 1, file);
+    }
+
+    fwrite(flat->tokens, sizeof(uint32_t), flat->node_num, file);
+    fwrite(flat->lhs, sizeof(uint32_t), flat->node_num, file);
+    fwrite(flat->rhs, sizeof(uint32_t), flat->node_num, file);
+    fwrite(flat->extra, sizeof(FlatNode), flat->extra_num, file);
+    fwrite(flat->tags, sizeof(uint8_t), flat->node_num, file);
+    for(size_t i = 0; i < flat->constant_num; ++i)
+        fwrite(flat->constants[i].lexeme, 1, strlen(flat->constants[i].lexeme) + 1, file);
+
+    /* Readers only ever see complete entry, it is renamed into place after it was written */
+    if(ferror(file) | fclose(file) || rename(temporary, path) < 0) {
+        unlink(temporary);
+        return;
+    }
+    TRACE(TRACE_PARSER, "Cache stored %s\n", path);
+}
+
+extern void cache_release(void)
+{
+    if(cache_mapping != NULL) munmap(cache_mapping, cache_mapping_size);
+    cache_mapping = NULL;
+    cache_mapping_size = 0;
+}
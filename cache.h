@@ -0,0 +1,68 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef CACHE_H
+#define CACHE_H
+
+/* Bump CACHE_VERSION whenever CacheHeader, CacheToken, FlatAST layout, AST tags or decoding of lexemes change */
+#define CACHE_MAGIC "CASHC"
+#define CACHE_VERSION 4
+#define CACHE_NO_STRING UINT64_MAX
+#define CACHE_PATH_SIZE 4096
+#define CACHE_FNV_OFFSET 0xcbf29ce484222325ULL
+#define CACHE_FNV_PRIME 0x100000001b3ULL
+
+/*@Function: cache_directory
+*Helper Function: Writes cache directory to path, CASH_CACHE_DIR, then $XDG_CACHE_HOME/cash, then $HOME/.cache/cash. Returns FALSE if none is set */
+static int cache_directory(char *, const size_t);
+
+/*@Function: cache_make_directory
+*Helper Function: Creates directory and its parents, returns FALSE on error */
+static int cache_make_directory(char *);
+
+/*@Function: cache_file_path
+*Helper Function: Writes path of cache file for source hash, returns FALSE if it does not fit */
+static int cache_file_path(char *, const size_t, const uint64_t);
+
+/*@Function: cache_expected_size
+*Helper Function: Returns size of cache file described by header */
+static size_t cache_expected_size(const CacheHeader *);
+
+/*@Function: cache_hash
+*Function that returns 64-bit FNV-1a hash of source, used as cache key */
+extern uint64_t cache_hash(const Source *);
+
+/*@Function: cache_load
+*Function that loads tokens and FlatAST compiled from source, returns FALSE if cache entry is missing or stale */
+extern int cache_load(const Source *, const uint64_t, TokenVector *, FlatAST *);
+
+/*@Function: cache_store
+*Function that writes tokens and FlatAST of source into cache, errors only disable caching of this run */
+extern void cache_store(const Source *, const uint64_t, TokenVector *, const FlatAST *);
+
+/*@Function: cache_release
+*Function that unmaps cache file loaded by cache_load, folded constants point into it */
+extern void cache_release(void);
+
+#endif // CACHE_H
@@ -33,19 +33,27 @@ SOFTWARE.
 #include "coretypes.h"
 #include "error.h"
 #include "lexer.h"
+#include "arena.h"
 #include "parser.h"
 #include "environment.h"
+#include "symbol.h"
 #include "interpreter.h"
+#include "flat_ast.h"
+#include "flat_interpreter.h"
+#include "trace.h"
+#include "optimizer.h"
+#include "resolver.h"
+#include "cache.h"
+#include "frontend.h"
+#include "bytecode.h"
+#include "vm.h"
+#include "closure.h"
 #include "cash.h"
 
 char pcmd[MAX_LINE_SIZE];
-
-static char * file_read_line(FILE *file) 
-{
-    if(file == NULL) {perror("Error opening a file"); exit(EXIT_FAILURE);}
-    if(fgets(pcmd, MAX_LINE_SIZE, file) == NULL) return NULL;
-    return strdup(pcmd);
-}
+Engine engine = ENGINE_TREE;
+int cache_enabled = TRUE;
+size_t frontend_jobs = 0;
 
 extern void clear_terminal(void) 
 {
@@ -83,38 +91,52 @@ extern void run_file(char *file_name)
     strcat(cwd, "/");
     strcat(cwd, file_name);
 
-    FILE *file = fopen(file_name, "r");
-    if(file == NULL) {perror("Error opening a file"); exit(EXIT_FAILURE);}
+    Source source;
+    if(source_map(file_name, &source)) {perror("Error opening a file"); exit(EXIT_FAILURE);}
 
-    char **tokens = NULL;
-    Token *ctokens = NULL;
+    TokenVector ctokens = {NULL, 0, 0};
+    Arena ast_arena = {NULL, 0, 0, NULL};
+    FlatAST flat = {0};
+    Bytecode bytecode = {0};
     AST **ast = NULL;
-    size_t line_number = 1;
-    size_t number_of_tokens = 0;
-    size_t number_of_ctokens = 0;
     size_t number_of_statements = 0;
+    uint64_t source_hash = 0;
+    /* Cache entry has no pointer AST, tree and closure engines always run the front end */
+    int use_cache = cache_enabled && (engine == ENGINE_VM || engine == ENGINE_FLAT);
 
-    for(char *line = file_read_line(file); line != NULL; line = (line_number++, file_read_line(file))) {
-        if((tokens = tokenizer(line, &number_of_tokens)) == NULL) continue;
-        if(error_flag) goto DEALLOCATE_TOKENS_LABEL;
-        if((ctokens = token_classifier(tokens, ctokens, number_of_ctokens + number_of_tokens, &number_of_ctokens)) == NULL) TODO("Add error");
-        DEALLOCATE_TOKENS_LABEL:
-        for (size_t i = 0; i < number_of_tokens; ++i) {
-            free(tokens[i]);
+    /* Unchanged script runs straight from the compiled cache entry, front end is skipped */
+    if(use_cache) {
+        source_hash = cache_hash(&source);
+        if(cache_load(&source, source_hash, &ctokens, &flat)) {
+            if(engine == ENGINE_VM) bytecode_build(&bytecode, &flat);
+            for(size_t i = 0; i < flat.root_num; ++i) {
+                if(flat.extra[flat.roots + i] != FLAT_NONE) {
+                    if(engine == ENGINE_VM) vm_interpret(&bytecode, i);
+                    else flat_interpret(&flat, flat.extra[flat.roots + i]);
+                }
+                if(error_flag) break;
+            }
+            env_reset(&env_global);
+            goto DEALLOCATE_AST_LABEL;
         }
-        if(error_flag) goto DEALLOCATE_CTOKENS_LABEL;
-        free(line);
     }
 
-    /* Add EOF token at the end */
-    number_of_ctokens = eof_token(&ctokens, number_of_ctokens);
-    ast = parser(ctokens, &number_of_statements);
+    /* Tokenize, classify and parse whole script, large scripts are split across frontend_jobs threads */
+    ast = frontend_parse(&source, &ctokens, &number_of_statements, &ast_arena, frontend_jobs);
     if(ast == NULL || error_flag) goto DEALLOCATE_AST_LABEL;
+    ast_optimize(ast, number_of_statements, &ast_arena);
+    ast_resolve(ast, number_of_statements);
+    if(engine == ENGINE_VM || engine == ENGINE_FLAT) flat_ast_build(&flat, ast, number_of_statements, ctokens.tokens, ctokens.size);
+    if(use_cache) cache_store(&source, source_hash, &ctokens, &flat);
+    if(engine == ENGINE_VM) bytecode_build(&bytecode, &flat);
  
     for(size_t i = 0; i < number_of_statements; ++i) {
         if(ast[i] != NULL) {
-            ast_print(ast[i]); 
-            interpret(ast[i]);
+            if(TRACE_ON(TRACE_PARSER)) ast_print(ast[i]); 
+            if(engine == ENGINE_VM) vm_interpret(&bytecode, i);
+            else if(engine == ENGINE_FLAT) flat_interpret(&flat, flat.extra[flat.roots + i]);
+            else if(engine == ENGINE_CLOSURE) closure_interpret(closure_build(ast[i]));
+            else interpret(ast[i]);
         }
         if(error_flag) break;
     }
@@ -123,16 +145,20 @@ extern void run_file(char *file_name)
     env_reset(&env_global);
     
     DEALLOCATE_AST_LABEL:
-    for(size_t i = 0; i < number_of_statements; ++i) {
-        if(ast[i] != NULL) 
-            ast_free(ast[i]);
-    }
-    free(ast);
-    DEALLOCATE_CTOKENS_LABEL:
-    for (size_t i = 0; ctokens[i].type != EOF_TOKEN; ++i) {
-        free(ctokens[i].lexeme);
-    }
-    free(ctokens);
+    TRACE(TRACE_PARSER, "AST arena used %zu of %zu bytes\n", ast_arena.bytes_used, ast_arena.bytes_reserved);
+    if(flat.node_num) TRACE(TRACE_PARSER, "Flat AST used %zu bytes for %zu nodes\n", flat_ast_bytes(&flat), flat.node_num);
+    if(bytecode.chunk_num) TRACE(TRACE_PARSER, "Bytecode used %zu bytes for %zu chunks\n", bytecode_bytes(&bytecode), bytecode.chunk_num);
+    bytecode_free(&bytecode);
+    flat_ast_free(&flat);
+    closure_release();
+    arena_release(&ast_arena);
+    frontend_release();
+    token_vector_free(&ctokens);
+    cache_release();
+    vm_release();
+    env_pool_release();
+    symbol_table_free();
+    source_unmap(&source);
     exit(EXIT_SUCCESS); 
 }
 
@@ -144,6 +170,9 @@ extern void run_term(void)
         size_t number_of_ctokens = 0;
         size_t number_of_statements = 0;
         AST **ast = NULL;
+        Arena ast_arena = {NULL, 0, 0, NULL};
+        FlatAST flat = {0};
+        Bytecode bytecode = {0};
         Token *ctokens = NULL;
         reset_error_flag();
         
@@ -156,22 +185,30 @@ extern void run_term(void)
         /* Add EOF token at the end */
         number_of_ctokens = eof_token(&ctokens, number_of_ctokens);
 
-        ast = parser(ctokens, &number_of_statements);
+        ast = parser(ctokens, &number_of_statements, &ast_arena);
         if(ast == NULL || error_flag) goto DEALLOCATE_AST_LABEL;
+        ast_optimize(ast, number_of_statements, &ast_arena);
+        ast_resolve(ast, number_of_statements);
+        if(engine == ENGINE_VM || engine == ENGINE_FLAT) flat_ast_build(&flat, ast, number_of_statements, ctokens, number_of_ctokens);
+        if(engine == ENGINE_VM) bytecode_build(&bytecode, &flat);
 
         for(size_t i = 0; i < number_of_statements; ++i) 
             if(ast[i] != NULL) {
-                ast_print(ast[i]);
-                interpret(ast[i]);
+                if(TRACE_ON(TRACE_PARSER)) ast_print(ast[i]);
+                if(engine == ENGINE_VM) vm_interpret(&bytecode, i);
+                else if(engine == ENGINE_FLAT) flat_interpret(&flat, flat.extra[flat.roots + i]);
+                else if(engine == ENGINE_CLOSURE) closure_interpret(closure_build(ast[i]));
+                else interpret(ast[i]);
             }
         //Deallocate Heap memory 
         env_reset(&env_global);
 
         DEALLOCATE_AST_LABEL:
-        for(size_t i = 0; i < number_of_statements; ++i)
-            if(ast[i] != NULL)
-                ast_free(ast[i]);
-        free(ast);
+        bytecode_free(&bytecode);
+        flat_ast_free(&flat);
+        closure_release();
+        arena_release(&ast_arena);
+        frontend_release();
 
         DEALLOCATE_CTOKENS_LABEL:
         for (size_t i = 0; i < number_of_ctokens; ++i) {
@@ -184,6 +221,7 @@ extern void run_term(void)
             free(tokens[i]);
         }
         free(tokens);
+        trace_flush();
         wait(NULL);
     } 
 }
@@ -194,10 +232,27 @@ extern void cash(int argc,char **argv)
     
     getcwd(cwd, FILE_PATH_SIZE); 
 
-    if(argc > 2) {fprintf(stderr, "Can't interpret multiple files at once!"); exit(EXIT_FAILURE);}
-    if(argc > 1) {
+    char *file_name = NULL;
+    if(trace_init(getenv("CASH_TRACE"))) exit(EXIT_FAILURE);
+    for(int i = 1; i < argc; ++i) {
+        if(!strncmp(argv[i], "--trace=", 8)) {if(trace_init(argv[i] + 8)) exit(EXIT_FAILURE);}
+        else if(!strcmp(argv[i], "--engine=vm")) engine = ENGINE_VM;
+        else if(!strcmp(argv[i], "--engine=closure")) engine = ENGINE_CLOSURE;
+        else if(!strcmp(argv[i], "--engine=flat")) engine = ENGINE_FLAT;
+        else if(!strcmp(argv[i], "--engine=tree")) engine = ENGINE_TREE;
+        else if(!strcmp(argv[i], "--no-cache")) cache_enabled = FALSE;
+        else if(!strncmp(argv[i], "--jobs=", 7)) {
+            char *end = NULL;
+            frontend_jobs = strtoul(argv[i] + 7, &end, 10);
+            if(end == argv[i] + 7 || *end != '\0') {fprintf(stderr, "Invalid number of jobs %s!", argv[i] + 7); exit(EXIT_FAILURE);}
+        }
+        else if(!strncmp(argv[i], "--engine=", 9)) {fprintf(stderr, "Unknown engine %s, expected vm, closure, flat or tree!", argv[i] + 9); exit(EXIT_FAILURE);}
+        else if(file_name != NULL) {fprintf(stderr, "Can't interpret multiple files at once!"); exit(EXIT_FAILURE);}
+        else file_name = argv[i];
+    }
+    if(file_name != NULL) {
         /* Run cash from file */
-        run_file(argv[1]);
+        run_file(file_name);
     }
     /* run cash from terminal */
     run_term();
@@ -27,6 +27,15 @@ SOFTWARE.
 
 extern char pcmd[MAX_LINE_SIZE];
 
+/* Engine that runs statements, bytecode virtual machine unless --engine=closure, --engine=flat or --engine=tree is given */
+extern Engine engine;
+
+/* Load and store compiled scripts in cache directory, cleared by --no-cache */
+extern int cache_enabled;
+
+/* Threads used to lex and parse large scripts, set by --jobs=, 0 uses every online CPU */
+extern size_t frontend_jobs;
+
 extern void clear_terminal(void);
 
 extern int print_term(char *);
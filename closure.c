@@ -0,0 +1,557 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <string.h>
+#include "coretypes.h"
+#include "error.h"
+#include "lexer.h"
+#include "arena.h"
+#include "environment.h"
+#include "value.h"
+#include "flat_ast.h"
+#include "frontend.h"
+#include "trace.h"
+#include "interpreter.h"
+#include "closure.h"
+
+static jmp_buf sync_env;
+static Arena closure_arena = {NULL, 0, 0, NULL};
+
+/* Return statement stores its value here, statement lists stop while closure_returning is set */
+static int closure_returning = FALSE;
+static ValueTagged closure_return_value = VALUE_NONE;
+
+static void closure_runtime_error_mode(void) 
+{
+    error_flag = TRUE;
+    longjmp(sync_env, TRUE);
+}
+
+static Closure *closure_new(ClosureFunction function, Token *token)
+{
+    Closure *closure = arena_alloc(&closure_arena, sizeof(Closure));
+    memset(closure, 0, sizeof(Closure));
+    closure->function = function;
+    closure->token = token;
+    return closure;
+}
+
+static Closure **closure_compile_list(AST **list, const size_t count)
+{
+    if(count == 0) return NULL;
+    Closure **closures = arena_alloc(&closure_arena, sizeof(Closure *) * count);
+    for(size_t i = 0; i < count; ++i) {
+        closures[i] = closure_compile(list[i]);
+    }
+    return closures;
+}
+
+static Closure *closure_compile(AST *ast)
+{
+    if(ast == NULL) return NULL;
+
+    Closure *closure = NULL;
+    switch(ast->tag) {
+        case AST_LITERAL:
+            closure = closure_new(closure_literal, ast->data.token);
+            closure->ast = ast;
+            return closure;
+        case AST_IDENTIFIER:
+            closure = closure_new(closure_identifier, ast->data.AST_IDENTIFIER.token);
+            closure->depth = ast->data.AST_IDENTIFIER.depth;
+            closure->slot = ast->data.AST_IDENTIFIER.slot;
+            return closure;
+        case AST_UNARY_EXPR:
+            closure = closure_new(closure_unary, ast->data.AST_UNARY_EXPR.token);
+            closure->child[0] = closure_compile(ast->data.AST_UNARY_EXPR.right);
+            return closure;
+        case AST_BINARY_EXPR:
+        {
+            /* Operator is looked up once here instead of on every evaluation */
+            ClosureFunction function;
+            switch(ast->data.AST_BINARY_EXPR.token->type) {
+                case ADD:                                   function = closure_add; break;
+                case SUBTRACT:                              function = closure_subtract; break;
+                case MULTIPLY:                              function = closure_multiply; break;
+                case DIVIDE:                                function = closure_divide; break;
+                case DOUBLE_EQUAL:                          function = closure_equal; break;
+                case EXCLAMATION_EQUEAL:                    function = closure_not_equal; break;
+                case REDIRECTION_LEFT_LESS_RELATIONAL:      function = closure_less; break;
+                case LESS_EQUAL:                            function = closure_less_equal; break;
+                case REDIRECTION_RIGHT_GREATER_RELATIONAL:  function = closure_greater; break;
+                case GREATER_EQUAL:                         function = closure_greater_equal; break;
+                default:                                    function = closure_binary; break;
+            }
+            closure = closure_new(function, ast->data.AST_BINARY_EXPR.token);
+            closure->child[0] = closure_compile(ast->data.AST_BINARY_EXPR.left);
+            closure->child[1] = closure_compile(ast->data.AST_BINARY_EXPR.right);
+            return closure;
+        }
+        case AST_LOGICAL_EXPR:
+            closure = closure_new((ast->data.AST_LOGICAL_EXPR.token->type == DOUBLE_OR) ? closure_or : closure_and, ast->data.AST_LOGICAL_EXPR.token);
+            closure->child[0] = closure_compile(ast->data.AST_LOGICAL_EXPR.left);
+            closure->child[1] = closure_compile(ast->data.AST_LOGICAL_EXPR.right);
+            return closure;
+        case AST_GROUPING_EXPR:
+            /* Grouping only returns value of its expression, so it is linked out */
+            return closure_compile(ast->data.AST_GROUPING_EXPR.left);
+        case AST_ASSIGN_EXPR:
+        {
+            /* Assignment of addition keeps compiled addition as child, its operands are evaluated by closure_assign_add */
+            AST *expr = ast->data.AST_ASSIGN_EXPR.expr;
+            int add = expr->tag == AST_BINARY_EXPR && expr->data.AST_BINARY_EXPR.token->type == ADD;
+            closure = closure_new(add ? closure_assign_add : closure_assign, ast->data.AST_ASSIGN_EXPR.token);
+            closure->child[0] = closure_compile(expr);
+            closure->depth = ast->data.AST_ASSIGN_EXPR.depth;
+            closure->slot = ast->data.AST_ASSIGN_EXPR.slot;
+            return closure;
+        }
+        case AST_CALL_EXPR:
+            closure = closure_new(closure_call, ast->data.AST_CALL_EXPR.callee->data.token);
+            closure->list = closure_compile_list(ast->data.AST_CALL_EXPR.stmt_list, ast->data.AST_CALL_EXPR.stmt_num);
+            closure->list_num = ast->data.AST_CALL_EXPR.stmt_num;
+            return closure;
+        case AST_EXPR_STMT:
+            closure = closure_new(closure_expression_statement, NULL);
+            closure->child[0] = closure_compile(ast->data.AST_EXPR_STMT.expr);
+            return closure;
+        case AST_BLOCK_STMT:
+            closure = closure_new(closure_block, NULL);
+            closure->list = closure_compile_list(ast->data.AST_BLOCK_STMT.stmt_list, ast->data.AST_BLOCK_STMT.stmt_num);
+            closure->list_num = ast->data.AST_BLOCK_STMT.stmt_num;
+            closure->slot = ast->data.AST_BLOCK_STMT.slot_num;
+            return closure;
+        case AST_IF_STMT:
+            closure = closure_new(closure_if, NULL);
+            closure->child[0] = closure_compile(ast->data.AST_IF_STMT.condition);
+            closure->child[1] = closure_compile(ast->data.AST_IF_STMT.true_branch);
+            closure->child[2] = closure_compile(ast->data.AST_IF_STMT.else_branch);
+            return closure;
+        case AST_WHILE_STMT:
+            closure = closure_new(closure_while, NULL);
+            closure->child[0] = closure_compile(ast->data.AST_WHILE_STMT.condition);
+            closure->child[1] = closure_compile(ast->data.AST_WHILE_STMT.body);
+            return closure;
+        case AST_FOR_STMT:
+            closure = closure_new(closure_for, NULL);
+            closure->child[0] = closure_compile(ast->data.AST_FOR_STMT.initializer);
+            closure->child[1] = closure_compile(ast->data.AST_FOR_STMT.condition);
+            closure->child[2] = closure_compile(ast->data.AST_FOR_STMT.increment);
+            closure->child[3] = closure_compile(ast->data.AST_FOR_STMT.body);
+            closure->slot = ast->data.AST_FOR_STMT.slot_num;
+            return closure;
+        case AST_ECHO_STMT:
+            closure = closure_new(closure_echo, NULL);
+            closure->child[0] = closure_compile(ast->data.AST_ECHO_STMT.expr);
+            return closure;
+        case AST_VAR_DECL_STMT:
+            closure = closure_new(closure_variable, ast->data.AST_VAR_DECL_STMT.name);
+            closure->child[0] = closure_compile(ast->data.AST_VAR_DECL_STMT.init);
+            closure->slot = ast->data.AST_VAR_DECL_STMT.slot;
+            return closure;
+        case AST_FUNCT_DECL_STMT:
+            /* Body may not be parsed yet, it is compiled by closure_call */
+            closure = closure_new(closure_function, ast->data.AST_FUNCT_DECL_STMT.name);
+            closure->ast = ast;
+            return closure;
+        case AST_RETURN_STMT:
+            closure = closure_new(closure_return, NULL);
+            closure->child[0] = closure_compile(ast->data.AST_RETURN_STMT.expr);
+            return closure;
+        case AST_TIME_STMT:
+            return closure_new(closure_time, NULL);
+        case AST_CLEAR_STMT:
+            return closure_new(closure_clear, NULL);
+        case AST_CD_STMT:
+            return closure_new(closure_cd, (ast->data.AST_CD_STMT.expr == NULL) ? NULL : ast->data.AST_CD_STMT.expr->data.token);
+        case AST_RUN_STMT:
+            closure = closure_new(closure_run, ast->data.AST_RUN_STMT.program_name);
+            closure->list = closure_compile_list(ast->data.AST_RUN_STMT.args_list, ast->data.AST_RUN_STMT.arg_num);
+            closure->list_num = ast->data.AST_RUN_STMT.arg_num;
+            return closure;
+        default:
+            break;
+    }
+    INTERNAL_ERROR("Tried to compile undefined AST node type.");
+    exit(EXIT_FAILURE);
+}
+
+static void closure_run_list(Closure **list, const size_t count, EnvironmentMap *env_host)
+{
+    for(size_t i = 0; i < count && !closure_returning; ++i) {
+        ValueTagged value = list[i]->function(list[i], env_host);
+        value_release(&value);
+    }
+}
+
+static ValueTagged closure_literal(Closure *closure, EnvironmentMap *env_host)
+{
+    /* String made by optimizer is shared, its bytes are not copied */
+    if(closure->ast->data.AST_LITERAL.string != NULL) 
+        return (ValueTagged){.type = STRING, .literal.char_value = string_copy(closure->ast->data.AST_LITERAL.string)};
+    return value_literal(closure->token);
+}
+
+static ValueTagged closure_identifier(Closure *closure, EnvironmentMap *env_host)
+{
+    ValueTagged *found = env_get_slot(closure->token, closure->depth, closure->slot, env_host);
+    if(found == NULL) return VALUE_NONE;
+    return value_clone(found);
+}
+
+static ValueTagged closure_unary(Closure *closure, EnvironmentMap *env_host)
+{
+    ValueTagged right = closure->child[0]->function(closure->child[0], env_host);
+    ValueTagged result;
+    if(!value_unary_into(closure->token, &right, &result)) closure_runtime_error_mode();
+    return result;
+}
+
+static ValueTagged closure_add(Closure *closure, EnvironmentMap *env_host)
+{
+    CLOSURE_BINARY_OPERATION(BINARY_ADD_SUB_MULTIPLY_OPERATION, +, closure, env_host);
+}
+
+static ValueTagged closure_subtract(Closure *closure, EnvironmentMap *env_host)
+{
+    CLOSURE_BINARY_OPERATION(BINARY_ADD_SUB_MULTIPLY_OPERATION, -, closure, env_host);
+}
+
+static ValueTagged closure_multiply(Closure *closure, EnvironmentMap *env_host)
+{
+    CLOSURE_BINARY_OPERATION(BINARY_ADD_SUB_MULTIPLY_OPERATION, *, closure, env_host);
+}
+
+static ValueTagged closure_divide(Closure *closure, EnvironmentMap *env_host)
+{
+    CLOSURE_BINARY_OPERATION(BINARY_DIVIDE_OPERATION, /, closure, env_host);
+}
+
+static ValueTagged closure_equal(Closure *closure, EnvironmentMap *env_host)
+{
+    CLOSURE_BINARY_OPERATION(BINARY_COMPARISON_OPERATION, ==, closure, env_host);
+}
+
+static ValueTagged closure_not_equal(Closure *closure, EnvironmentMap *env_host)
+{
+    CLOSURE_BINARY_OPERATION(BINARY_COMPARISON_OPERATION, !=, closure, env_host);
+}
+
+static ValueTagged closure_less(Closure *closure, EnvironmentMap *env_host)
+{
+    CLOSURE_BINARY_OPERATION(BINARY_COMPARISON_OPERATION, <, closure, env_host);
+}
+
+static ValueTagged closure_less_equal(Closure *closure, EnvironmentMap *env_host)
+{
+    CLOSURE_BINARY_OPERATION(BINARY_COMPARISON_OPERATION, <=, closure, env_host);
+}
+
+static ValueTagged closure_greater(Closure *closure, EnvironmentMap *env_host)
+{
+    CLOSURE_BINARY_OPERATION(BINARY_COMPARISON_OPERATION, >, closure, env_host);
+}
+
+static ValueTagged closure_greater_equal(Closure *closure, EnvironmentMap *env_host)
+{
+    CLOSURE_BINARY_OPERATION(BINARY_COMPARISON_OPERATION, >=, closure, env_host);
+}
+
+static ValueTagged closure_binary(Closure *closure, EnvironmentMap *env_host)
+{
+    ValueTagged left = closure->child[0]->function(closure->child[0], env_host);
+    ValueTagged right = closure->child[1]->function(closure->child[1], env_host);
+    ValueTagged result;
+    if(!value_binary_into(closure->token, &left, &right, &result)) closure_runtime_error_mode();
+    return result;
+}
+
+static ValueTagged closure_or(Closure *closure, EnvironmentMap *env_host)
+{
+    ValueTagged left = closure->child[0]->function(closure->child[0], env_host);
+    if(value_is_truth(&left)) return left;
+    value_release(&left);
+    return closure->child[1]->function(closure->child[1], env_host);
+}
+
+static ValueTagged closure_and(Closure *closure, EnvironmentMap *env_host)
+{
+    ValueTagged left = closure->child[0]->function(closure->child[0], env_host);
+    if(!value_is_truth(&left)) return left;
+    value_release(&left);
+    return closure->child[1]->function(closure->child[1], env_host);
+}
+
+static ValueTagged closure_assign(Closure *closure, EnvironmentMap *env_host)
+{
+    ValueTagged value = closure->child[0]->function(closure->child[0], env_host);
+    env_assign_slot(closure->token, closure->depth, closure->slot, &value, env_host);
+    return (value_release(&value), VALUE_NONE);
+}
+
+static ValueTagged closure_assign_add(Closure *closure, EnvironmentMap *env_host)
+{
+    /* s = s + x: variable drops its string after both operands are evaluated, so it is appended in place */
+    Closure *add = closure->child[0];
+    ValueTagged left = add->child[0]->function(add->child[0], env_host);
+    ValueTagged right = add->child[1]->function(add->child[1], env_host);
+    ValueTagged value;
+    if(value_can_append(&left, &right))
+        env_release_string(closure->token, closure->depth, closure->slot, left.literal.char_value, env_host);
+    if(!value_binary_into(add->token, &left, &right, &value)) closure_runtime_error_mode();
+    env_assign_slot(closure->token, closure->depth, closure->slot, &value, env_host);
+    return (value_release(&value), VALUE_NONE);
+}
+
+static ValueTagged closure_call(Closure *closure, EnvironmentMap *env_host)
+{
+    /* Arguments are kept on C stack, one more slot keeps array size above zero */
+    ValueTagged args[closure->list_num + 1];
+    for(size_t i = 0; i < closure->list_num; ++i) {
+        args[i] = closure->list[i]->function(closure->list[i], env_host);
+    }
+
+    Environment *function = env_get_function(closure->token, env_host);
+    if(function == NULL) closure_runtime_error_mode();
+    Closure *definition = function->data.ENV_FUNCTION.closure;
+    if(definition == NULL) {
+        INTERNAL_ERROR("Function was not defined by closure engine!");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Body is parsed on first call and compiled right after it */
+    AST *ast = definition->ast;
+    frontend_function_body(ast);
+    if(error_flag) closure_runtime_error_mode();
+    if(definition->list == NULL) {
+        definition->list = closure_compile_list(ast->data.AST_FUNCT_DECL_STMT.stmt_list, ast->data.AST_FUNCT_DECL_STMT.stmt_num);
+        definition->list_num = ast->data.AST_FUNCT_DECL_STMT.stmt_num;
+    }
+
+    size_t param_num = ast->data.AST_FUNCT_DECL_STMT.param_num;
+    TRACE(TRACE_EVAL, "Call %s with %zu arguments\n", token_lexeme(closure->token), closure->list_num);
+    if(closure->list_num != param_num) {
+        fprintf(stderr, "Error when calling %s, number of arguments given %zu but expected %zu\n", token_lexeme(closure->token), closure->list_num, param_num);
+        closure_runtime_error_mode();
+    }
+
+    EnvironmentMap env_child = {.env = NULL, .env_enclosing = env_host, .env_return = NULL, .env_size = 0};
+    env_reserve_slots(&env_child, ast->data.AST_FUNCT_DECL_STMT.slot_num);
+    for(size_t i = 0; i < param_num; ++i) {
+        AST *parameter = ast->data.AST_FUNCT_DECL_STMT.parameters[i];
+        env_define_slot(parameter->data.AST_IDENTIFIER.token, parameter->data.AST_IDENTIFIER.slot, &args[i], &env_child);
+        value_release(&args[i]);
+    }
+
+    closure_run_list(definition->list, definition->list_num, &env_child);
+    /* Function that ended without return gives no value */
+    ValueTagged result = closure_return_value;
+    closure_return_value = VALUE_NONE;
+    closure_returning = FALSE;
+    env_reset(&env_child);
+    return result;
+}
+
+static ValueTagged closure_expression_statement(Closure *closure, EnvironmentMap *env_host)
+{
+    return closure->child[0]->function(closure->child[0], env_host);
+}
+
+static ValueTagged closure_block(Closure *closure, EnvironmentMap *env_host)
+{
+    EnvironmentMap env_child = {.env = NULL, .env_enclosing = env_host, .env_return = NULL, .env_size = 0};
+    env_reserve_slots(&env_child, closure->slot);
+    closure_run_list(closure->list, closure->list_num, &env_child);
+    /* Free memory of Local Environment */
+    env_reset(&env_child);
+    return VALUE_NONE;
+}
+
+static ValueTagged closure_if(Closure *closure, EnvironmentMap *env_host)
+{
+    ValueTagged condition = closure->child[0]->function(closure->child[0], env_host);
+    int truth = value_is_truth(&condition);
+    value_release(&condition);
+
+    Closure *branch = truth ? closure->child[1] : closure->child[2];
+    if(branch == NULL) return VALUE_NONE;
+    ValueTagged value = branch->function(branch, env_host);
+    return (value_release(&value), VALUE_NONE);
+}
+
+static ValueTagged closure_while(Closure *closure, EnvironmentMap *env_host)
+{
+    Closure *condition = closure->child[0];
+    Closure *body = closure->child[1];
+    while(!closure_returning) {
+        ValueTagged value = condition->function(condition, env_host);
+        int truth = value_is_truth(&value);
+        value_release(&value);
+        if(!truth) break;
+        value = body->function(body, env_host);
+        value_release(&value);
+    }
+    return VALUE_NONE;
+}
+
+static ValueTagged closure_for(Closure *closure, EnvironmentMap *env_host)
+{
+    Closure *condition = closure->child[1];
+    Closure *increment = closure->child[2];
+    Closure *body = closure->child[3];
+    ValueTagged value;
+
+    EnvironmentMap env_child = {.env = NULL, .env_enclosing = env_host, .env_return = NULL, .env_size = 0};
+    env_reserve_slots(&env_child, closure->slot);
+    if(closure->child[0] != NULL) {
+        value = closure->child[0]->function(closure->child[0], &env_child);
+        value_release(&value);
+    }
+
+    while(!closure_returning) {
+        if(condition != NULL) {
+            value = condition->function(condition, &env_child);
+            int truth = value_is_truth(&value);
+            value_release(&value);
+            if(!truth) break;
+        }
+        value = body->function(body, &env_child);
+        value_release(&value);
+        if(closure_returning) break;
+        if(increment != NULL) {
+            value = increment->function(increment, &env_child);
+            value_release(&value);
+        }
+    }
+    
+    env_reset(&env_child);
+    return VALUE_NONE;
+}
+
+static ValueTagged closure_echo(Closure *closure, EnvironmentMap *env_host)
+{
+    ValueTagged result = closure->child[0]->function(closure->child[0], env_host);
+    if(!error_flag) value_echo(&result);
+    return (value_release(&result), VALUE_NONE);
+}
+
+static ValueTagged closure_variable(Closure *closure, EnvironmentMap *env_host)
+{
+    ValueTagged value = VALUE_NONE;
+    if(closure->child[0] != NULL) value = closure->child[0]->function(closure->child[0], env_host);
+
+    env_define_slot(closure->token, closure->slot, &value, env_host);
+    return (value_release(&value), VALUE_NONE);
+}
+
+static ValueTagged closure_function(Closure *closure, EnvironmentMap *env_host)
+{
+    env_define_function(closure->token, env_host, closure->ast, NULL, FLAT_NONE, NULL, closure);
+    return VALUE_NONE;
+}
+
+static ValueTagged closure_return(Closure *closure, EnvironmentMap *env_host)
+{
+    closure_return_value = (closure->child[0] == NULL) ? VALUE_NONE : closure->child[0]->function(closure->child[0], env_host);
+    closure_returning = TRUE;
+    return VALUE_NONE;
+}
+
+static ValueTagged closure_time(Closure *closure, EnvironmentMap *env_host)
+{
+    builtin_time();
+    return VALUE_NONE;
+}
+
+static ValueTagged closure_clear(Closure *closure, EnvironmentMap *env_host)
+{
+    builtin_clear();
+    return VALUE_NONE;
+}
+
+static ValueTagged closure_cd(Closure *closure, EnvironmentMap *env_host)
+{
+    builtin_cd((closure->token == NULL) ? NULL : token_lexeme(closure->token));
+    return VALUE_NONE;
+}
+
+static ValueTagged closure_run(Closure *closure, EnvironmentMap *env_host)
+{
+    if(closure->token == NULL) {
+        fprintf(stdout, "Runtime warning: run command requires a program name to run!\n");
+        closure_runtime_error_mode();
+    }
+
+    char **argv = malloc(sizeof(char *) * (closure->list_num + 2));
+    argv[0] = strdup(token_lexeme(closure->token));
+    argv[1] = NULL;
+    for(size_t i = 0; i < closure->list_num; ++i) {
+        ValueTagged arg = closure->list[i]->function(closure->list[i], env_host);
+        argv[i+1] = value_string(&arg);
+        value_release(&arg);
+        if(error_flag || argv[i+1] == NULL) {
+            /* Error of the argument itself was already reported */
+            if(!error_flag) operator_error(closure->token, "Arguments of run must be strings, numbers or booleans!");
+            for(size_t j = 0; j <= i + 1; ++j) free(argv[j]);
+            free(argv);
+            closure_runtime_error_mode();
+        }
+        argv[i+2] = NULL;
+    }
+    builtin_run(closure->token, argv);
+    
+    for(size_t i = 0; i < closure->list_num + 1; ++i) {
+        free(argv[i]);
+    }
+    free(argv);
+    return VALUE_NONE;
+}
+
+extern Closure *closure_build(AST *ast)
+{
+    return closure_compile(ast);
+}
+
+extern void closure_interpret(Closure *closure)
+{
+    ValueTagged value = VALUE_NONE;
+    if(setjmp(sync_env));
+    else {
+        TRACE(TRACE_EVAL, "Setjmp for closure engine!\n");
+        value = closure->function(closure, &env_global);
+    }
+    value_release(&value);
+    /* Parser rejects return outside of function, drop any stale value anyway */
+    value_release(&closure_return_value);
+    closure_return_value = VALUE_NONE;
+    closure_returning = FALSE;
+}
+
+extern void closure_release(void)
+{
+    arena_release(&closure_arena);
+}
@@ -0,0 +1,176 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef CLOSURE_H
+#define CLOSURE_H
+
+/* Numbers and booleans are computed in place of left operand like value_binary_into would compute them,
+ * strings go through value_binary_into which reports the error */
+#define CLOSURE_BINARY_OPERATION(operation, op, closure, env_host) do {                 \
+        ValueTagged left = (closure)->child[0]->function((closure)->child[0], env_host);    \
+        ValueTagged right = (closure)->child[1]->function((closure)->child[1], env_host);   \
+        if(left.type != STRING && right.type != STRING) {                               \
+            operation(op, &left, &right, &left);                                        \
+            return left;                                                                \
+        }                                                                               \
+        ValueTagged result;                                                             \
+        if(!value_binary_into((closure)->token, &left, &right, &result))                \
+            closure_runtime_error_mode();                                               \
+        return result;                                                                  \
+    } while(0)
+
+/*@Function: closure_runtime_error_mode
+*Function that deals with runtime error by jumping to next stmt */
+static void closure_runtime_error_mode(void);
+
+/*@Function: closure_new
+*Helper Function: Allocates Closure with evaluator function in closure arena */
+static Closure *closure_new(ClosureFunction, Token *);
+
+/*@Function: closure_compile_list
+*Helper Function: Compiles list of AST nodes into array of closures */
+static Closure **closure_compile_list(AST **, const size_t);
+
+/*@Function: closure_compile
+*Helper Function: Compiles AST node and its children, picks evaluator by node tag and operator once */
+static Closure *closure_compile(AST *);
+
+/*@Function: closure_run_list
+*Helper Function: Evaluates statements until the last one or until return statement is executed */
+static void closure_run_list(Closure **, const size_t, EnvironmentMap *);
+
+/*@Function: closure_literal
+*Function that returns value of literal */
+static ValueTagged closure_literal(Closure *, EnvironmentMap *);
+
+/*@Function: closure_identifier
+*Function that returns value of identifier found in Environment */
+static ValueTagged closure_identifier(Closure *, EnvironmentMap *);
+
+/*@Function: closure_unary
+*Function that evaluates unary expression */
+static ValueTagged closure_unary(Closure *, EnvironmentMap *);
+
+/*@Function: closure_add
+*Function that evaluates addition, the same goes for the rest of arithmetic and comparison operators */
+static ValueTagged closure_add(Closure *, EnvironmentMap *);
+static ValueTagged closure_subtract(Closure *, EnvironmentMap *);
+static ValueTagged closure_multiply(Closure *, EnvironmentMap *);
+static ValueTagged closure_divide(Closure *, EnvironmentMap *);
+static ValueTagged closure_equal(Closure *, EnvironmentMap *);
+static ValueTagged closure_not_equal(Closure *, EnvironmentMap *);
+static ValueTagged closure_less(Closure *, EnvironmentMap *);
+static ValueTagged closure_less_equal(Closure *, EnvironmentMap *);
+static ValueTagged closure_greater(Closure *, EnvironmentMap *);
+static ValueTagged closure_greater_equal(Closure *, EnvironmentMap *);
+
+/*@Function: closure_binary
+*Function that evaluates binary expression with operator that has no evaluator of its own */
+static ValueTagged closure_binary(Closure *, EnvironmentMap *);
+
+/*@Function: closure_or
+*Function that evaluates logical or, returns left value if it is true */
+static ValueTagged closure_or(Closure *, EnvironmentMap *);
+
+/*@Function: closure_and
+*Function that evaluates logical and, returns left value if it is false */
+static ValueTagged closure_and(Closure *, EnvironmentMap *);
+
+/*@Function: closure_assign
+*Function that evaluates assign expression */
+static ValueTagged closure_assign(Closure *, EnvironmentMap *);
+
+/*@Function: closure_assign_add
+*Function that evaluates assignment of addition, string of variable that is added to itself grows in place */
+static ValueTagged closure_assign_add(Closure *, EnvironmentMap *);
+
+/*@Function: closure_call
+*Function that evaluates call expression, body of function is parsed and compiled on first call */
+static ValueTagged closure_call(Closure *, EnvironmentMap *);
+
+/*@Function: closure_expression_statement
+*Function that evaluates expression statement */
+static ValueTagged closure_expression_statement(Closure *, EnvironmentMap *);
+
+/*@Function: closure_block
+*Function that evaluates block statement */
+static ValueTagged closure_block(Closure *, EnvironmentMap *);
+
+/*@Function: closure_if
+*Function that evaluates if statement */
+static ValueTagged closure_if(Closure *, EnvironmentMap *);
+
+/*@Function: closure_while
+*Function that evaluates while statement */
+static ValueTagged closure_while(Closure *, EnvironmentMap *);
+
+/*@Function: closure_for
+*Function that evaluates for statement */
+static ValueTagged closure_for(Closure *, EnvironmentMap *);
+
+/*@Function: closure_echo
+*Function that evaluates echo statement */
+static ValueTagged closure_echo(Closure *, EnvironmentMap *);
+
+/*@Function: closure_variable
+*Function that evaluates variable statement */
+static ValueTagged closure_variable(Closure *, EnvironmentMap *);
+
+/*@Function: closure_function
+*Function that evaluates function declaration statement */
+static ValueTagged closure_function(Closure *, EnvironmentMap *);
+
+/*@Function: closure_return
+*Function that evaluates return statement, statements of function stop after it */
+static ValueTagged closure_return(Closure *, EnvironmentMap *);
+
+/*@Function: closure_time
+*Function that evaluates time statement */
+static ValueTagged closure_time(Closure *, EnvironmentMap *);
+
+/*@Function: closure_clear
+*Function that evaluates clear statement */
+static ValueTagged closure_clear(Closure *, EnvironmentMap *);
+
+/*@Function: closure_cd
+*Function that evaluates cd statement */
+static ValueTagged closure_cd(Closure *, EnvironmentMap *);
+
+/*@Function: closure_run
+*Function that evaluates run statement */
+static ValueTagged closure_run(Closure *, EnvironmentMap *);
+
+/*@Function: closure_build
+*Function that compiles statement into closures, closures live until closure_release */
+extern Closure *closure_build(AST *);
+
+/*@Function: closure_interpret
+*Function that interprets statement compiled by closure_build */
+extern void closure_interpret(Closure *);
+
+/*@Function: closure_release
+*Function that frees every closure */
+extern void closure_release(void);
+
+#endif // CLOSURE_H
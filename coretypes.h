@@ -24,11 +24,15 @@ SOFTWARE.
 #ifndef CORETYPES_H
 #define CORETYPES_H
 
+#include <stdint.h>
+
 #define TRUE 1
 #define FALSE 0
 #define MAX_LINE_SIZE 1000
 #define FILE_PATH_SIZE 100
 #define MAX_ARG_CNT 127
+#define MAX_NUMBER_SIZE 64
+#define RESOLVE_BY_NAME UINT32_MAX    // Variable is looked up by name, set by resolver for globals and names not declared in function
 
 
 // TsodingDaily <3
@@ -161,76 +165,27 @@ SOFTWARE.
             (result)->literal.boolean_value  = (left)->literal.boolean_value op (right)->literal.float_value;   \
         else                                                                                                    \
             (result)->literal.boolean_value = (left)->literal.boolean_value op (right)->literal.boolean_value;  \
-        (result)->type = (result->literal.boolean_value) ? TRUE_TOKEN : FALSE_TOKEN;                            \
+        (result)->type = ((result)->literal.boolean_value) ? TRUE_TOKEN : FALSE_TOKEN;                          \
     } while (0)
 
-/*@Type TokenType: Enumerating type for defining token type */
+/* Token flags used in tokens.def */
+#define TOKEN_SYNC      1
+#define TOKEN_IN_WORD   2
+
+/*@Type TokenType: Enumerating type for defining token type, generated from tokens.def */
 typedef enum value_t
 {
     /* Used to indicate failure: */
     FAILED_TO_CLASSIFY = 1, 
-   
-    /* Single character special token: */
-    EXCLAMATION                             = '!',
-    COMMENT                                 = '#',
-    MODULUS                                 = '%',
-    AND                                     = '&',
-    LEFT_PARENTHESIS                        = '(',
-    RIGHT_PARENTHESIS                       = ')',
-    MULTIPLY                                = '*',
-    ADD                                     = '+',
-    COMMA                                   = ',',
-    SUBTRACT                                = '-',
-    DOT                                     = '.',
-    DIVIDE                                  = '/',
-    SEMICOLON                               = ';',
-    REDIRECTION_LEFT_LESS_RELATIONAL        = '<',
-    EQUAL                                   = '=',
-    REDIRECTION_RIGHT_GREATER_RELATIONAL    = '>',
-    LEFT_BRACE                              = '{',
-    PIPE                                    = '|',
-    RIGHT_BRACE                             = '}',
-    XOR                                     = '~',
-
-    /* Two character special token: */
-    EXCLAMATION_EQUEAL, 
-    DOUBLE_EQUAL,       
-    GREATER_EQUAL,       
-    LESS_EQUAL,          
-    SHIFT_LEFT,          
-    SHIFT_RIGHT,
-    DOUBLE_AND,
-    DOUBLE_OR,       
-
-    /* Literals: */
-    IDENTIFIER,          
-    STRING,
-    NUMBER_INT,
-    NUMBER_FLOAT,
-
-    /* Commands: */
-    RUN,
-    EXEC, 
-    CD,
-    CLEAR,  
-    TIME,
-
-    /* Reserved Words: */
-    IF,           
-    ELSE,         
-    FALSE_TOKEN,  
-    TRUE_TOKEN,   
-    FOR,          
-    WHILE,        
-    NULL_TOKEN,   
-    ENUM_TOKEN,   
-    VAR,
-    ECHO,
-    FUNCT,
-    STRUCT,
-    CLASS,        
-    RETURN,
-    EOF_TOKEN     
+
+#define SPECIAL_TOKEN(type, character, flags) type = character,
+#define OPERATOR_TOKEN(type, first, second, flags) type,
+#define TOKEN(type, flags) type,
+#define RESERVED_WORD(type, word, flags) type,
+#include "tokens.def"
+
+    /* Number of token types, used to size tables indexed by TokenType */
+    TOKEN_TYPE_COUNT
 } TokenType;
 
 /*@Type CharacterType:  Enumerating type used for defining character type */
@@ -244,6 +199,49 @@ typedef enum character_t
     UNUSED_CHARACTERS
 } CharacterType;
 
+/*@Type NumberStatus: Result of parsing number literal */
+typedef enum number_status_t
+{
+    NUMBER_OK,
+    NUMBER_MALFORMED,
+    NUMBER_OVERFLOW
+} NumberStatus;
+
+/*@Type BindingPower: Precedence levels of Pratt expression parser, higher level binds tighter */
+typedef enum binding_power_t
+{
+    BP_NONE,
+    BP_ASSIGNMENT,      // =, parsed by expression() because it is right associative
+    BP_OR,              // ||
+    BP_AND,             // &&
+    BP_BITWISE_OR,      // |
+    BP_BITWISE_AND,     // &
+    BP_EQUALITY,        // == !=
+    BP_COMPARISON,      // < <= > >=
+    BP_SHIFT,           // << >>
+    BP_TERM,            // + -
+    BP_FACTOR,          // * / %
+    BP_UNARY,           // - ! ~
+    BP_CALL             // ()
+} BindingPower;
+
+/*@Type OperatorRule: Pratt parser rule of TokenType, zero binding power means token is not such operator */
+typedef struct operator_rule_s
+{
+    unsigned char prefix;   // BindingPower of operand of prefix operator
+    unsigned char infix;    // BindingPower of infix operator
+    unsigned char tag;      // AST tag of infix node, binary and logical nodes share layout
+} OperatorRule;
+
+/*@Type TraceCategory: Bit mask of trace categories enabled by --trace= or CASH_TRACE */
+typedef enum trace_category_t
+{
+    TRACE_LEXER = 1,
+    TRACE_PARSER = 2,
+    TRACE_EVAL = 4,
+    TRACE_ALL = TRACE_LEXER | TRACE_PARSER | TRACE_EVAL
+} TraceCategory;
+
 /*@Type Value: Abstract the type for tokenizer, classifier and parser*/
 typedef union value_u
 {
@@ -263,31 +261,91 @@ typedef struct value_tag_s
     Value literal;
 } ValueTagged;
 
+/*@Type StringHeader: Header in front of bytes of STRING values, char_value points right after it. Bytes are not 
+ * changed while string is shared, so copies of value share them and only count references. String with single
+ * reference may grow in place by string_append */
+typedef struct string_header_s
+{
+    size_t length;          // Bytes without terminating null
+    size_t capacity;        // Bytes that fit before terminating null without reallocation
+    uint32_t references;    // Values sharing the bytes, STRING_STATIC for literals owned by AST arena
+} StringHeader;
+
+/*@Type Symbol: Integer ID of an interned identifier, 0 means no symbol */
+typedef uint32_t Symbol;
+
 /*@Type Token: Used for tokenization*/
 typedef struct token_s  
 {
     TokenType type;
-    char *lexeme;
+    uint32_t line_number;   // Add this after implementing error correction
+    char *lexeme;           // NULL until materialized by token_lexeme for source tokens
     Value literal;
-    size_t line_number; // Add this after implementing error correction
+    uint32_t offset;        // Offset of the lexeme in the mapped Source, scripts are limited to LEXER_MAX_SOURCE bytes
+    uint32_t length;        // Length of the lexeme in the mapped Source
+    Symbol symbol;          // Interned name of IDENTIFIER tokens
 } Token;
 
+/*@Type CacheHeader: Header of compiled script cache file, followed by CacheToken records, FlatAST arrays and string pool */
+typedef struct cache_header_s
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t token_type_count;      // TokenType and AST tag numbering must match
+    uint64_t source_hash;
+    uint64_t source_size;
+    uint64_t token_num;
+    uint64_t constant_num;
+    uint64_t node_num;
+    uint64_t extra_num;
+    uint64_t string_size;
+    uint32_t roots;
+    uint32_t root_num;
+} CacheHeader;
+
+/*@Type CacheToken: Token stored in cache, lexeme is span of source or string in pool for folded constants */
+typedef struct cache_token_s
+{
+    uint32_t type;
+    uint32_t length;
+    uint64_t offset;
+    uint64_t line_number;
+    uint64_t string;                // Offset in string pool, CACHE_NO_STRING for source tokens
+    Value literal;                  // Pointers are not stored
+} CacheToken;
+
+/*@Type TokenVector: Growable array of classified tokens, grows geometrically */
+typedef struct token_vector_s
+{
+    Token *tokens;
+    size_t size;
+    size_t capacity;
+} TokenVector;
+
+/*@Type Source: Read-only mapping of a script used by the source lexer */
+typedef struct source_s
+{
+    const char *data;
+    size_t size;
+} Source;
+
 /*@Type Environment: used for runtime environment */
 typedef struct environment_s
 {
     enum type
     {
         ENV_VARIABLE,
-        ENV_FUNCTION
+        ENV_FUNCTION,
+        ENV_EMPTY           // Slot reserved by resolver, variable is not defined yet
     } type;
     
     union 
     {
         ValueTagged value;
-        struct ENV_FUNCTION {AST *definition;} ENV_FUNCTION;
+        struct ENV_FUNCTION {AST *definition; struct flat_ast_s *flat; uint32_t node; struct chunk_s *chunk; struct closure_s *closure;} ENV_FUNCTION;
     } data;
 
-    char *name;
+    Symbol name;
 } Environment;
 
 /*@Type EnvironmentMap: Environment map with pointer to allocated Environment and its size */
@@ -303,11 +361,79 @@ struct EnvironmentMap
     size_t env_size;
 };
 
+/*@Type ResolverScope: Names declared in one block, for loop or function, index of name is its slot */
+typedef struct resolver_scope_s
+{
+    Symbol *names;
+    size_t slot_num;
+    size_t capacity;
+    int function;           // Function scope, names outside of it are looked up by name at runtime
+} ResolverScope;
+
+/*@Type ArenaBlock: Block of memory owned by Arena, blocks are linked from newest to oldest */
+typedef struct arena_block_s
+{
+    struct arena_block_s *next;
+    size_t capacity;
+    size_t used;
+    unsigned char *data;
+} ArenaBlock;
+
+/*@Type Arena: Bump allocator that owns all AST nodes of one compilation unit */
+typedef struct arena_s
+{
+    ArenaBlock *block;
+    size_t bytes_used;
+    size_t bytes_reserved;
+    void *last;             // Last allocation, it can grow in place
+} Arena;
+
+/*@Type SymbolEntry: Interned identifier stored in the symbol table */
+typedef struct symbol_entry_s
+{
+    char *name;             // Null terminated copy in names arena of SymbolTable
+    size_t length;
+} SymbolEntry;
+
+/*@Type SymbolSlot: Slot of symbol table, hash is kept next to Symbol ID so probing does not read entries */
+typedef struct symbol_slot_s
+{
+    uint32_t hash;
+    Symbol symbol;          // 0 marks empty slot
+} SymbolSlot;
+
+/*@Type SymbolTable: Open addressing table of interned identifiers */
+typedef struct symbol_table_s
+{
+    SymbolEntry *entries;   // Indexed by Symbol, entry 0 is unused
+    size_t size;
+    size_t capacity;
+    SymbolSlot *slots;
+    size_t slot_capacity;   // Always power of two
+    Arena names;            // Names of all symbols, released together
+} SymbolTable;
+
+/*@Type FrontendChunk: Top-level statements of one part of script, lexed and parsed by its own thread */
+typedef struct frontend_chunk_s
+{
+    const Source *source;
+    size_t begin;           // Byte range of script, begins at var or funct
+    size_t end;
+    size_t line_number;     // Line of first byte
+    TokenVector tokens;     // Tokens of chunk, moved into merged TokenVector after lexing
+    Token *token_list;      // First token of chunk in merged TokenVector, ends with EOF
+    Arena arena;
+    AST **ast;
+    size_t statement_num;
+    int error;
+} FrontendChunk;
+
 /*@Type ReservedWordMapType: Structure used for classifying reserved words */
 typedef struct reserved_word_map_t
 {
     const char *reserved_word;
     TokenType type;
+    size_t length;
 } ReservedWordMapType;
 
 /*@Type AST: Structure, previously forward referenced */
@@ -342,18 +468,23 @@ struct AST
     union 
     {
         Token *token;
-        struct AST_VAR_DECL_STMT {Token *name; AST *init;} AST_VAR_DECL_STMT;
-        struct AST_FUNCT_DECL_STMT {Token *name; AST **parameters; AST **stmt_list; size_t param_num; size_t stmt_num;} AST_FUNCT_DECL_STMT;
+        /* depth counts environments between use and declaration, slot indexes Environment of declaration */
+        /* string is shared value of STRING literal made by optimizer, NULL until then */
+        struct AST_LITERAL {Token *token; char *string;} AST_LITERAL;
+        struct AST_IDENTIFIER {Token *token; uint32_t depth; uint32_t slot;} AST_IDENTIFIER;
+        struct AST_VAR_DECL_STMT {Token *name; AST *init; uint32_t slot;} AST_VAR_DECL_STMT;
+        /* body points to first token of body until it is parsed, then it is NULL. body_end is '}' that closes the body */
+        struct AST_FUNCT_DECL_STMT {Token *name; Token *body; Token *body_end; AST **parameters; AST **stmt_list; uint32_t param_num; uint32_t slot_num; size_t stmt_num;} AST_FUNCT_DECL_STMT;
         struct AST_EXPR_STMT {AST *expr;} AST_EXPR_STMT;
-        struct AST_BLOCK_STMT {AST **stmt_list; size_t stmt_num;} AST_BLOCK_STMT;
+        struct AST_BLOCK_STMT {AST **stmt_list; size_t stmt_num; size_t slot_num;} AST_BLOCK_STMT;
         struct AST_IF_STMT {AST *condition; AST *true_branch; AST *else_branch;} AST_IF_STMT;
         struct AST_WHILE_STMT {AST *condition; AST *body;} AST_WHILE_STMT;
-        struct AST_FOR_STMT {AST *initializer; AST *condition; AST *increment; AST *body;} AST_FOR_STMT;
+        struct AST_FOR_STMT {AST *initializer; AST *condition; AST *increment; AST *body; size_t slot_num;} AST_FOR_STMT;
         struct AST_ECHO_STMT {AST *expr;} AST_ECHO_STMT;
         struct AST_CD_STMT {AST *expr;} AST_CD_STMT;
         struct AST_RUN_STMT {Token *program_name; AST **args_list; size_t arg_num;} AST_RUN_STMT;
         struct AST_RETURN_STMT {AST *expr;} AST_RETURN_STMT;
-        struct AST_ASSIGN_EXPR {Token *token; AST *expr;} AST_ASSIGN_EXPR;
+        struct AST_ASSIGN_EXPR {Token *token; AST *expr; uint32_t depth; uint32_t slot;} AST_ASSIGN_EXPR;
         struct AST_LOGICAL_EXPR {AST *left; Token *token; AST *right;} AST_LOGICAL_EXPR;
         struct AST_BINARY_EXPR {AST *left; Token *token; AST *right;} AST_BINARY_EXPR;
         struct AST_GROUPING_EXPR {AST *left; Token *token;} AST_GROUPING_EXPR;
@@ -362,4 +493,123 @@ struct AST
     } data;
 };  
 
+/*@Type FlatNode: 32-bit index of FlatAST node, 0 is reserved as no node */
+typedef uint32_t FlatNode;
+
+/*@Type FlatAST: AST stored as parallel arrays indexed by FlatNode, child lists are ranges in extra
+* LITERAL                         token, lhs = index of static string for string literals
+* IDENTIFIER                      token, lhs = depth, rhs = slot
+* VAR_DECL                        token = name, lhs = init, rhs = slot
+* FUNCT_DECL                      token = name, lhs = extra[param_num, stmt_num, slot_num, params..., stmts...]
+*                                 lhs is FLAT_NONE until body is parsed and lowered on first call
+* EXPR, ECHO, RETURN, CD, GROUPING lhs = expr
+* BLOCK                           lhs = extra[slot_num, stmts...], rhs = count
+* RUN, CALL                       lhs = extra start, rhs = count, token = program or callee name
+* IF                              lhs = condition, rhs = extra[true_branch, else_branch]
+* WHILE                           lhs = condition, rhs = body
+* FOR                             lhs = extra[initializer, condition, increment, slot_num], rhs = body
+* ASSIGN                          token, lhs = expr, rhs = extra[depth, slot]
+* UNARY                           token, lhs = expr
+* LOGICAL, BINARY                 token = operator, lhs = left, rhs = right */
+typedef struct flat_ast_s
+{
+    uint8_t *tags;          // enum tag of AST node
+    uint32_t *tokens;       // Index into token_base, indices from token_num index into constants
+    uint32_t *lhs;
+    uint32_t *rhs;
+    size_t node_num;
+    size_t node_capacity;
+    FlatNode *extra;        // Child lists and fixed size children that do not fit in lhs and rhs
+    size_t extra_num;
+    size_t extra_capacity;
+    Token *token_base;      // Tokens of compilation unit, must outlive FlatAST
+    size_t token_num;
+    Token *constants;       // Copies of tokens made by optimizer, they are not in token_base
+    size_t constant_num;
+    size_t constant_capacity;
+    char **strings;         // Static string of every string literal, shared by its evaluations
+    size_t string_num;
+    size_t string_capacity;
+    Arena string_arena;     // Owns bytes of strings
+    uint32_t roots;         // Range of statements in extra
+    uint32_t root_num;
+} FlatAST;
+
+/*@Type Opcode: Instruction of virtual machine, generated from opcodes.def */
+typedef enum opcode_e
+{
+#define OPCODE(name, operands) name,
+#include "opcodes.def"
+
+    /* Number of opcodes, used to size tables indexed by Opcode */
+    OPCODE_COUNT
+} Opcode;
+
+/*@Type Chunk: Bytecode of one top level statement or function body, operands follow their opcode in code */
+typedef struct chunk_s
+{
+    uint32_t *code;
+    size_t code_size;
+    size_t code_capacity;
+    struct bytecode_s *bytecode;        // Constants and FlatAST that operands index into
+    uint32_t index;                     // Position of chunk in chunks of its bytecode
+    FlatNode function;                  // Declaration of function body, code is empty until its first call
+    uint32_t parameters;                // Range of parameter nodes in extra, only for function bodies
+    uint32_t param_num;
+    uint32_t slot_num;
+    uint32_t stack_depth;               // Values on operand stack at the end of code, used while compiling
+    uint32_t stack_max;                 // Operand stack reserved before chunk runs
+} Chunk;
+
+/*@Type Bytecode: Chunks compiled from FlatAST, chunk i < root_num is statement i of roots */
+typedef struct bytecode_s
+{
+    FlatAST *flat;
+    Chunk **chunks;                     // Chunks are allocated one by one, pointers to them stay valid while compiling
+    size_t chunk_num;
+    size_t chunk_capacity;
+    ValueTagged *constants;             // Values of literals, pushed as copies
+    size_t constant_num;
+    size_t constant_capacity;
+    size_t root_num;
+} Bytecode;
+
+/*@Type CallFrame: State of caller saved by virtual machine on call and restored on return */
+typedef struct call_frame_s
+{
+    const Chunk *chunk;
+    const uint32_t *ip;
+    EnvironmentMap *env;
+    size_t env_depth;
+    size_t stack_base;
+} CallFrame;
+
+/*@Type Closure: AST node compiled once into function pointer and resolved operands, run by closure engine */
+typedef struct closure_s Closure;
+
+/*@Type ClosureFunction: Evaluator of Closure, returns value like evaluate of tree interpreter */
+typedef ValueTagged (*ClosureFunction)(Closure *, EnvironmentMap *);
+
+/*@Type Closure: Structure, previously forward referenced */
+struct closure_s
+{
+    ClosureFunction function;
+    Token *token;           // Literal, name, operator, callee or program
+    Closure *child[4];      // Children in order of AST fields, e.g. for initializer, condition, increment and body
+    Closure **list;         // Statements of block and function, arguments of call and run
+    size_t list_num;
+    uint32_t depth;
+    uint32_t slot;          // Slot of variable or number of slots of block and for loop
+    AST *ast;               // Function declaration, its body is compiled on first call, or literal with shared string
+};
+
+/*@Type Engine: Interpreter that runs parsed statements, selected by --engine= */
+typedef enum engine_e
+{
+    ENGINE_TREE,
+    ENGINE_FLAT,
+    ENGINE_VM,
+    ENGINE_CLOSURE
+} Engine;
+
 #endif // CORETYPES_H
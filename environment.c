@@ -28,13 +28,39 @@ SOFTWARE.
 #include <setjmp.h>
 #include "coretypes.h"
 #include "error.h"
+#include "lexer.h"
+#include "symbol.h"
+#include "value.h"
 #include "environment.h"
 
 EnvironmentMap env_global = {.env = NULL, .env_enclosing = NULL, .env_size = 0};
 
+/* Slot arrays freed by env_reset are kept by their size and handed out again by env_reserve_slots,
+ * free arrays are linked through their first slot */
+static Environment *env_pool[ENV_POOL_SIZES];
+
+static Environment *env_pool_take(const size_t slot_num)
+{
+    Environment *slots = env_pool[slot_num];
+    if(slots != NULL) memcpy(&env_pool[slot_num], slots, sizeof(Environment *));
+    return slots;
+}
+
+static void env_pool_give(Environment *slots, const size_t slot_num)
+{
+    /* Array holds at least slot_num slots, larger and empty arrays are freed */
+    if(slot_num == 0 || slot_num >= ENV_POOL_SIZES) {
+        free(slots);
+        return;
+    }
+    memcpy(slots, &env_pool[slot_num], sizeof(Environment *));
+    env_pool[slot_num] = slots;
+}
+
 static void env_copy_value(ValueTagged *value, Environment *env_value) 
 {
-    if(value == NULL) {
+    /* Missing value and VALUE_NONE are both stored as 0 */
+    if(value == NULL || value->type == NULL_TOKEN) {
         env_value->data.value.type = NUMBER_INT;
         env_value->data.value.literal.integer_value = 0;
         return;
@@ -49,7 +75,7 @@ static void env_copy_value(ValueTagged *value, Environment *env_value)
             env_value->data.value.literal.float_value = value->literal.float_value;
             return; 
         case STRING:
-            env_value->data.value.literal.char_value = strdup(value->literal.char_value);
+            env_value->data.value.literal.char_value = string_copy(value->literal.char_value);
             return;
         case TRUE_TOKEN:
         case FALSE_TOKEN:
@@ -60,14 +86,13 @@ static void env_copy_value(ValueTagged *value, Environment *env_value)
     }
 }
 
-extern int env_delete_var(char *name, EnvironmentMap *env_map) 
+extern int env_delete_var(Symbol name, EnvironmentMap *env_map) 
 {
     for(size_t i = 0; i < env_map->env_size; ++i) {
-        if(!strcmp(name, env_map->env[i].name) && env_map->env[i].type == ENV_VARIABLE) {
-            free(env_map->env[i].name);
-            if(env_map->env[i].data.value.type == STRING) free(env_map->env[i].data.value.literal.char_value);
+        if(name == env_map->env[i].name && env_map->env[i].type == ENV_VARIABLE) {
+            if(env_map->env[i].data.value.type == STRING) string_free(env_map->env[i].data.value.literal.char_value);
             env_map->env_size--;
-            env_map->env = realloc(env_map->env, env_map->env_size);
+            env_map->env = realloc(env_map->env, sizeof(Environment) * env_map->env_size);
             return 0;
         }
     }
@@ -77,11 +102,10 @@ extern int env_delete_var(char *name, EnvironmentMap *env_map)
 extern void env_reset(EnvironmentMap *env_map) 
 {
     for(size_t i = 0; i < env_map->env_size; ++i) {
-      free(env_map->env[i].name);
       switch (env_map->env[i].type) 
       {
           case ENV_VARIABLE:
-              if(env_map->env[i].data.value.type == STRING) free(env_map->env[i].data.value.literal.char_value);
+              if(env_map->env[i].data.value.type == STRING) string_free(env_map->env[i].data.value.literal.char_value);
               break;
           case ENV_FUNCTION:
               // AST is later freed
@@ -90,10 +114,12 @@ extern void env_reset(EnvironmentMap *env_map)
               break;
       }
     }
-    if(env_map->env != NULL) free(env_map->env);
+    if(env_map->env != NULL) env_pool_give(env_map->env, env_map->env_size);
+    env_map->env = NULL;
     if(env_map->env_return != NULL) {
-        if(env_map->env_return->type == STRING) free(env_map->env_return->literal.char_value);
+        if(env_map->env_return->type == STRING) string_free(env_map->env_return->literal.char_value);
         free(env_map->env_return);
+        env_map->env_return = NULL;
     } 
     env_map->env_size = 0;
 }
@@ -104,9 +130,9 @@ extern void env_assign_var(Token *name, ValueTagged *value, EnvironmentMap *env_
 
     /* Search Environment for the same variable */
     for(size_t i = 0; i < env_map->env_size; ++i) {
-      if(!strcmp(name->lexeme, env_map->env[i].name) && env_map->env[i].type == ENV_VARIABLE) {
+      if(name->symbol == env_map->env[i].name && env_map->env[i].type == ENV_VARIABLE) {
          if(env_map->env[i].data.value.type == STRING)
-            free(env_map->env[i].data.value.literal.char_value);
+            string_free(env_map->env[i].data.value.literal.char_value);
          env_copy_value(value, &env_map->env[i]); 
          return;
       }
@@ -123,9 +149,9 @@ extern void env_define_var(Token *name, ValueTagged *value, EnvironmentMap *env_
     if(name == NULL) INTERNAL_ERROR("Passed null name argument.");
     /* Search Environment for the same variable */
     for(size_t i = 0; i < env_map->env_size; ++i) {
-      if(!strcmp(name->lexeme, env_map->env[i].name) && env_map->env[i].type == ENV_VARIABLE) {
+      if(name->symbol == env_map->env[i].name && env_map->env[i].type == ENV_VARIABLE) {
          if(env_map->env[i].data.value.type == STRING)
-            free(env_map->env[i].data.value.literal.char_value);
+            string_free(env_map->env[i].data.value.literal.char_value);
          env_copy_value(value, &env_map->env[i]); 
          return;
       }
@@ -134,7 +160,7 @@ extern void env_define_var(Token *name, ValueTagged *value, EnvironmentMap *env_
     env_map->env = realloc(env_map->env, sizeof(Environment) * (env_map->env_size + 1));
     if(env_map->env == NULL) INTERNAL_ERROR("Could not reallocate environment size!");
 
-    env_map->env[env_map->env_size].name = strdup(name->lexeme);
+    env_map->env[env_map->env_size].name = name->symbol;
     env_map->env[env_map->env_size].type = ENV_VARIABLE;
     env_copy_value(value, &env_map->env[env_map->env_size]); 
     env_map->env_size++;
@@ -143,7 +169,7 @@ extern void env_define_var(Token *name, ValueTagged *value, EnvironmentMap *env_
 extern ValueTagged *env_get_var(Token *name, EnvironmentMap *env_map) 
 {
     for(size_t i = 0; i < env_map->env_size; ++i) { 
-      if(!strcmp(env_map->env[i].name, name->lexeme) && env_map->env[i].type == ENV_VARIABLE) return &env_map->env[i].data.value;
+      if(env_map->env[i].name == name->symbol && env_map->env[i].type == ENV_VARIABLE) return &env_map->env[i].data.value;
     }
 
     if(env_map->env_enclosing != NULL) return env_get_var(name, env_map->env_enclosing);
@@ -153,13 +179,102 @@ extern ValueTagged *env_get_var(Token *name, EnvironmentMap *env_map)
     return NULL;
 }
 
-extern void env_define_function(Token *name, EnvironmentMap *env_map, AST *ast_definition)
+extern void env_reserve_slots(EnvironmentMap *env_map, const size_t slot_num)
+{
+    if(slot_num == 0) return;
+    env_map->env = (slot_num < ENV_POOL_SIZES) ? env_pool_take(slot_num) : NULL;
+    if(env_map->env == NULL) env_map->env = malloc(sizeof(Environment) * slot_num);
+    if(env_map->env == NULL) {
+        INTERNAL_ERROR("Could not allocate environment slots!");
+        exit(EXIT_FAILURE);
+    }
+    for(size_t i = 0; i < slot_num; ++i) {
+        env_map->env[i].type = ENV_EMPTY;
+        env_map->env[i].name = 0;
+    }
+    env_map->env_size = slot_num;
+}
+
+static EnvironmentMap *env_slot_map(const uint32_t depth, const uint32_t slot, EnvironmentMap *env_map)
+{
+    for(uint32_t i = 0; i < depth && env_map != NULL; ++i)
+        env_map = env_map->env_enclosing;
+    if(env_map == NULL || slot >= env_map->env_size) return NULL;
+    return env_map;
+}
+
+extern void env_define_slot(Token *name, const uint32_t slot, ValueTagged *value, EnvironmentMap *env_map)
+{
+    if(slot == RESOLVE_BY_NAME || slot >= env_map->env_size) return env_define_var(name, value, env_map);
+
+    Environment *entry = &env_map->env[slot];
+    if(entry->type == ENV_VARIABLE && entry->data.value.type == STRING)
+        string_free(entry->data.value.literal.char_value);
+    /* Name is kept, so that functions called from this scope still find the variable by name */
+    entry->name = name->symbol;
+    entry->type = ENV_VARIABLE;
+    env_copy_value(value, entry);
+}
+
+extern ValueTagged *env_get_slot(Token *name, const uint32_t depth, const uint32_t slot, EnvironmentMap *env_map)
+{
+    if(slot != RESOLVE_BY_NAME) {
+        EnvironmentMap *slot_map = env_slot_map(depth, slot, env_map);
+        if(slot_map != NULL && slot_map->env[slot].type == ENV_VARIABLE) return &slot_map->env[slot].data.value;
+    }
+    /* Declaration was not executed yet, name may still be defined in enclosing scope */
+    return env_get_var(name, env_map);
+}
+
+extern void env_assign_slot(Token *name, const uint32_t depth, const uint32_t slot, ValueTagged *value, EnvironmentMap *env_map)
+{
+    if(slot != RESOLVE_BY_NAME) {
+        EnvironmentMap *slot_map = env_slot_map(depth, slot, env_map);
+        if(slot_map != NULL && slot_map->env[slot].type == ENV_VARIABLE) {
+            Environment *entry = &slot_map->env[slot];
+            if(entry->data.value.type == STRING)
+                string_free(entry->data.value.literal.char_value);
+            env_copy_value(value, entry);
+            return;
+        }
+    }
+    env_assign_var(name, value, env_map);
+}
+
+extern void env_release_string(Token *name, const uint32_t depth, const uint32_t slot, const char *chars, EnvironmentMap *env_map)
+{
+    ValueTagged *value = NULL;
+    /* Variable is found the same way env_assign_slot finds it, other variables sharing the string keep it */
+    if(slot != RESOLVE_BY_NAME) {
+        EnvironmentMap *slot_map = env_slot_map(depth, slot, env_map);
+        if(slot_map != NULL && slot_map->env[slot].type == ENV_VARIABLE) value = &slot_map->env[slot].data.value;
+    }
+    for(; value == NULL && env_map != NULL; env_map = env_map->env_enclosing) {
+        for(size_t i = 0; i < env_map->env_size; ++i) {
+            if(env_map->env[i].name == name->symbol && env_map->env[i].type == ENV_VARIABLE) {
+                value = &env_map->env[i].data.value;
+                break;
+            }
+        }
+    }
+    if(value == NULL || value->type != STRING || value->literal.char_value != chars) return;
+
+    string_free(value->literal.char_value);
+    value->type = NUMBER_INT;
+    value->literal.integer_value = 0;
+}
+
+extern void env_define_function(Token *name, EnvironmentMap *env_map, AST *ast_definition, FlatAST *flat, FlatNode node, Chunk *chunk, Closure *closure)
 {
     if(name == NULL) INTERNAL_ERROR("Passed null name argument");
     /* Search Environment for the same variable */
     for(size_t i = 0; i < env_map->env_size; ++i) {
-        if(!strcmp(name->lexeme, env_map->env[i].name) && env_map->env[i].type == ENV_FUNCTION) {
+        if(name->symbol == env_map->env[i].name && env_map->env[i].type == ENV_FUNCTION) {
             env_map->env[i].data.ENV_FUNCTION.definition = ast_definition;
+            env_map->env[i].data.ENV_FUNCTION.flat = flat;
+            env_map->env[i].data.ENV_FUNCTION.node = node;
+            env_map->env[i].data.ENV_FUNCTION.chunk = chunk;
+            env_map->env[i].data.ENV_FUNCTION.closure = closure;
             return;
         }
     }
@@ -167,8 +282,12 @@ extern void env_define_function(Token *name, EnvironmentMap *env_map, AST *ast_d
     env_map->env = realloc(env_map->env, sizeof(Environment) * (env_map->env_size + 1));
     if(env_map->env == NULL) INTERNAL_ERROR("Could not reallocate environment size!");
 
-    env_map->env[env_map->env_size].name = strdup(name->lexeme);
+    env_map->env[env_map->env_size].name = name->symbol;
     env_map->env[env_map->env_size].data.ENV_FUNCTION.definition = ast_definition;
+    env_map->env[env_map->env_size].data.ENV_FUNCTION.flat = flat;
+    env_map->env[env_map->env_size].data.ENV_FUNCTION.node = node;
+    env_map->env[env_map->env_size].data.ENV_FUNCTION.chunk = chunk;
+    env_map->env[env_map->env_size].data.ENV_FUNCTION.closure = closure;
     env_map->env[env_map->env_size].type = ENV_FUNCTION;
     env_map->env_size++;
 }
@@ -178,7 +297,7 @@ extern Environment *env_get_function(Token *name, EnvironmentMap *env_map)
     if(name == NULL) INTERNAL_ERROR("Passed null name argument");
     
     for(size_t i = 0; i < env_map->env_size; ++i) { 
-      if(!strcmp(env_map->env[i].name, name->lexeme) && env_map->env[i].type == ENV_FUNCTION) return &env_map->env[i];
+      if(env_map->env[i].name == name->symbol && env_map->env[i].type == ENV_FUNCTION) return &env_map->env[i];
     }
 
     if(env_map->env_enclosing != NULL) return env_get_function(name, env_map->env_enclosing);
@@ -187,3 +306,10 @@ extern Environment *env_get_function(Token *name, EnvironmentMap *env_map)
     environment_error(name, "Undefined function");
     return NULL;
 }
+
+extern void env_pool_release(void)
+{
+    for(size_t i = 0; i < ENV_POOL_SIZES; ++i) {
+        while(env_pool[i] != NULL) free(env_pool_take(i));
+    }
+}
@@ -25,6 +25,8 @@ SOFTWARE.
 #ifndef ENVIRONMENT_H
 #define ENVIRONMENT_H
 
+#define ENV_POOL_SIZES 32
+
 /*@Variable: env_global
 *Global EnvironmentMap variable */
 extern EnvironmentMap env_global;
@@ -33,9 +35,17 @@ extern EnvironmentMap env_global;
 *Helper function that copies a variable value into particular Environment node */
 static void env_copy_value(ValueTagged *, Environment *);
 
+/*@Function: env_pool_take
+*Helper Function: Returns free slot array of given size from pool or NULL if there is none */
+static Environment *env_pool_take(const size_t);
+
+/*@Function: env_pool_give
+*Helper Function: Keeps slot array freed by env_reset in pool of its size, so that next call or block reuses it */
+static void env_pool_give(Environment *, const size_t);
+
 /*@Function: env_delete_var
 *Function that deletes particular local variable in Environment and returns 0 if deleted*/
-extern int env_delete_var(char *, EnvironmentMap *);
+extern int env_delete_var(Symbol, EnvironmentMap *);
 
 /*@Function: env_reset
 *Function that resets (free) local Environment */
@@ -53,12 +63,43 @@ extern void env_define_var(Token *, ValueTagged *, EnvironmentMap *);
 *Function that tries to find variable name in Environment map*/
 extern ValueTagged *env_get_var(Token *, EnvironmentMap *);
 
+/*@Function: env_reserve_slots
+*Function that allocates slots of Environment map computed by resolver, every slot starts as ENV_EMPTY.
+*Arrays of fewer than ENV_POOL_SIZES slots are reused from the pool */
+extern void env_reserve_slots(EnvironmentMap *, const size_t);
+
+/*@Function: env_slot_map
+*Helper function that returns Environment map depth levels up, NULL if slot is not reserved there */
+static EnvironmentMap *env_slot_map(const uint32_t, const uint32_t, EnvironmentMap *);
+
+/*@Function: env_define_slot
+*Function that defines variable in resolved slot, defines it by name if slot is RESOLVE_BY_NAME */
+extern void env_define_slot(Token *, const uint32_t, ValueTagged *, EnvironmentMap *);
+
+/*@Function: env_get_slot
+*Function that returns variable from resolved slot, falls back to env_get_var if slot is not defined yet */
+extern ValueTagged *env_get_slot(Token *, const uint32_t, const uint32_t, EnvironmentMap *);
+
+/*@Function: env_assign_slot
+*Function that assigns variable in resolved slot, falls back to env_assign_var if slot is not defined yet */
+extern void env_assign_slot(Token *, const uint32_t, const uint32_t, ValueTagged *, EnvironmentMap *);
+
+/*@Function: env_release_string
+*Function that drops reference of variable that is about to be assigned to given string, variable is 0 until the
+*assignment. Used for s = s + x, so that string on the left of + has single reference and grows in place */
+extern void env_release_string(Token *, const uint32_t, const uint32_t, const char *, EnvironmentMap *);
+
 /*@Function: env_define_function
-*Function that defines new Function definition in Environment map*/
-extern void env_define_function(Token *name, EnvironmentMap *env_map, AST *ast_definition);
+*Function that defines new Function definition in Environment map, flat definition is used by flat interpreter, chunk by virtual machine 
+*and closure by closure engine*/
+extern void env_define_function(Token *name, EnvironmentMap *env_map, AST *ast_definition, FlatAST *flat, FlatNode node, Chunk *chunk, Closure *closure);
 
 /*@Function: env_get_function
 *Function that tries to find a function name in Environment map*/
 extern Environment *env_get_function(Token *name, EnvironmentMap *env_map);
 
+/*@Function: env_pool_release
+*Function that frees slot arrays kept in the pool */
+extern void env_pool_release(void);
+
 #endif // ENVIRONMENT_H
@@ -27,8 +27,9 @@ SOFTWARE.
 #include <setjmp.h>
 #include "coretypes.h"
 #include "error.h"
+#include "lexer.h"
 
-int error_flag = FALSE;
+_Thread_local int error_flag = FALSE;
 
 extern void set_error_flag(void) 
 {
@@ -54,23 +55,28 @@ extern void lexer_error(int line, char *token, char *msg)
     fprintf(stdout, "\033[;31mError:\033[37m %d at %s, %s\n", line, token, msg);
 }
 
-extern void parser_error(Token token, char *msg) 
+extern void parser_error(Token *token, char *msg) 
 {
     set_error_flag();
-    if(token.type == EOF_TOKEN)
-        fprintf(stderr, "Error line: %d at end %s\n", token.line_number, msg);
+    if(token->type == EOF_TOKEN)
+        fprintf(stderr, "Error line: %d at end %s\n", token->line_number, msg);
     else
-        fprintf(stderr, "Error line: %d at '%s', %s\n", token.line_number, token.lexeme, msg);
+        fprintf(stderr, "Error line: %d at '%s', %s\n", token->line_number, token_lexeme(token), msg);
 }
 
 extern void runtime_error(AST *node, char *msg)  
 {
-    fprintf(stderr, "Runtime error line: %d at '%s', %s\n", node->data.token->line_number, node->data.token->lexeme, msg);
+    fprintf(stderr, "Runtime error line: %d at '%s', %s\n", node->data.token->line_number, token_lexeme(node->data.token), msg);
+}
+
+extern void operator_error(Token *token, char *msg) 
+{
+    fprintf(stderr, "Runtime error line: %d at '%s', %s\n", token->line_number, token_lexeme(token), msg);
 }
 
 extern void environment_error(Token *token, char *msg) 
 {
-    fprintf(stderr, "Runtime error line: %d at '%s', %s\n", token->line_number, token->lexeme, msg);
+    fprintf(stderr, "Runtime error line: %d at '%s', %s\n", token->line_number, token_lexeme(token), msg);
 }
 
 extern int error(char *msg, char *file, int line)  
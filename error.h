@@ -28,15 +28,15 @@ SOFTWARE.
 #define ERROR -1
 #define USER_ERROR 300
 #define INTERNAL_ERROR(msg) do {                                            \
-        fprintf(stderr, "%s:%d Internal Error: %s\n", __FILE__, __LINE__);  \
+        fprintf(stderr, "%s:%d Internal Error: %s\n", __FILE__, __LINE__, msg); \
     } while(0);
 
 #define ERR_WHITE 0
 #define ERR_YELLOW 1
 #define ERR_RED 2
 
-/* Global flag variable that indicates if error happened with error code */
-extern int error_flag;
+/* Flag variable that indicates if error happened with error code, every thread has its own */
+extern _Thread_local int error_flag;
 
 /*@Function: set_error_flag
 *Sets error_flag variable to specific error code */
@@ -56,12 +56,16 @@ extern void lexer_error(int , char *, char *);
 
 /*@Function: parser_error
 *Helper Function for printing parser errors */
-extern void parser_error(Token, char *);
+extern void parser_error(Token *, char *);
 
 /*@Function: runtime_error
 *Function that prints an error during runtime*/
 extern void runtime_error(AST *, char *);
 
+/*@Function: operator_error
+*Function that prints an error of operator applied during runtime*/
+extern void operator_error(Token *, char *);
+
 /*@Function: environment_error
 *Function that prints an environment error during runtime*/
 extern void environment_error(Token *, char *);
@@ -0,0 +1,313 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "coretypes.h"
+#include "error.h"
+#include "lexer.h"
+#include "arena.h"
+#include "value.h"
+#include "frontend.h"
+#include "flat_ast.h"
+
+static FlatNode flat_add_node(FlatAST *flat, const uint8_t tag, const Token *token)
+{
+    if(flat->node_num >= flat->node_capacity) {
+        size_t capacity = (flat->node_capacity) ? flat->node_capacity * 2 : FLAT_FIRST_CAPACITY;
+        flat->tags = realloc(flat->tags, sizeof(uint8_t) * capacity);
+        flat->tokens = realloc(flat->tokens, sizeof(uint32_t) * capacity);
+        flat->lhs = realloc(flat->lhs, sizeof(uint32_t) * capacity);
+        flat->rhs = realloc(flat->rhs, sizeof(uint32_t) * capacity);
+        if(flat->tags == NULL || flat->tokens == NULL || flat->lhs == NULL || flat->rhs == NULL) {
+            INTERNAL_ERROR("Could not reallocate flat AST nodes!");
+            exit(EXIT_FAILURE);
+        }
+        flat->node_capacity = capacity;
+    }
+
+    FlatNode node = flat->node_num++;
+    flat->tags[node] = tag;
+    flat->tokens[node] = (token == NULL) ? FLAT_NO_TOKEN : flat_token_index(flat, token);
+    flat->lhs[node] = FLAT_NONE;
+    flat->rhs[node] = FLAT_NONE;
+    return node;
+}
+
+static uint32_t flat_token_index(FlatAST *flat, const Token *token)
+{
+    if(token >= flat->token_base && token < flat->token_base + flat->token_num)
+        return (uint32_t)(token - flat->token_base);
+
+    /* Token folded by optimizer lives in AST arena, it is copied next to FlatAST */
+    if(flat->constant_num >= flat->constant_capacity) {
+        flat->constant_capacity = (flat->constant_capacity) ? flat->constant_capacity * 2 : FLAT_FIRST_CAPACITY;
+        flat->constants = realloc(flat->constants, sizeof(Token) * flat->constant_capacity);
+        if(flat->constants == NULL) {
+            INTERNAL_ERROR("Could not reallocate flat AST constants!");
+            exit(EXIT_FAILURE);
+        }
+    }
+    flat->constants[flat->constant_num] = *token;
+    return (uint32_t)(flat->token_num + flat->constant_num++);
+}
+
+static uint32_t flat_add_string(FlatAST *flat, Token *token)
+{
+    if(flat->string_num >= flat->string_capacity) {
+        flat->string_capacity = (flat->string_capacity) ? flat->string_capacity * 2 : FLAT_FIRST_CAPACITY;
+        flat->strings = realloc(flat->strings, sizeof(char *) * flat->string_capacity);
+        if(flat->strings == NULL) {
+            INTERNAL_ERROR("Could not reallocate flat AST strings!");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    char *lexeme = token_lexeme(token);
+    flat->strings[flat->string_num] = string_static(&flat->string_arena, lexeme, strlen(lexeme));
+    return (uint32_t)flat->string_num++;
+}
+
+static uint32_t flat_reserve_extra(FlatAST *flat, const size_t count)
+{
+    if(flat->extra_num + count > flat->extra_capacity) {
+        size_t capacity = (flat->extra_capacity) ? flat->extra_capacity : FLAT_FIRST_CAPACITY;
+        while(capacity < flat->extra_num + count) capacity *= 2;
+        flat->extra = realloc(flat->extra, sizeof(FlatNode) * capacity);
+        if(flat->extra == NULL) {
+            INTERNAL_ERROR("Could not reallocate flat AST extra data!");
+            exit(EXIT_FAILURE);
+        }
+        flat->extra_capacity = capacity;
+    }
+
+    uint32_t start = flat->extra_num;
+    flat->extra_num += count;
+    return start;
+}
+
+static void flat_lower_list(FlatAST *flat, AST **list, const size_t count, const uint32_t start)
+{
+    /* Extra may be reallocated while lowering, so index is stored instead of pointer */
+    for(size_t i = 0; i < count; ++i) {
+        FlatNode child = flat_lower(flat, list[i]);
+        flat->extra[start + i] = child;
+    }
+}
+
+static uint32_t flat_lower_definition(FlatAST *flat, AST *funct)
+{
+    size_t param_num = funct->data.AST_FUNCT_DECL_STMT.param_num;
+    size_t stmt_num = funct->data.AST_FUNCT_DECL_STMT.stmt_num;
+    uint32_t start = flat_reserve_extra(flat, 3 + param_num + stmt_num);
+    flat->extra[start] = param_num;
+    flat->extra[start + 1] = stmt_num;
+    flat->extra[start + 2] = funct->data.AST_FUNCT_DECL_STMT.slot_num;
+    flat_lower_list(flat, funct->data.AST_FUNCT_DECL_STMT.parameters, param_num, start + 3);
+    flat_lower_list(flat, funct->data.AST_FUNCT_DECL_STMT.stmt_list, stmt_num, start + 3 + param_num);
+    return start;
+}
+
+static FlatNode flat_lower(FlatAST *flat, AST *ast)
+{
+    if(ast == NULL) return FLAT_NONE;
+
+    FlatNode node, child;
+    uint32_t start;
+
+    switch(ast->tag) {
+        case AST_LITERAL:
+            node = flat_add_node(flat, ast->tag, ast->data.token);
+            /* String literal is made once like in pointer AST, evaluation only copies its reference */
+            if(ast->data.token->type == STRING) flat->lhs[node] = flat_add_string(flat, ast->data.token);
+            return node;
+        case AST_IDENTIFIER:
+            node = flat_add_node(flat, ast->tag, ast->data.AST_IDENTIFIER.token);
+            flat->lhs[node] = ast->data.AST_IDENTIFIER.depth;
+            flat->rhs[node] = ast->data.AST_IDENTIFIER.slot;
+            return node;
+        case AST_VAR_DECL_STMT:
+            node = flat_add_node(flat, ast->tag, ast->data.AST_VAR_DECL_STMT.name);
+            child = flat_lower(flat, ast->data.AST_VAR_DECL_STMT.init);
+            flat->lhs[node] = child;
+            return (flat->rhs[node] = ast->data.AST_VAR_DECL_STMT.slot, node);
+        case AST_FUNCT_DECL_STMT:
+            node = flat_add_node(flat, ast->tag, ast->data.AST_FUNCT_DECL_STMT.name);
+            /* Body skipped by parser is lowered by flat_ast_lower_function on first call */
+            if(ast->data.AST_FUNCT_DECL_STMT.body == NULL) flat->lhs[node] = flat_lower_definition(flat, ast);
+            return node;
+        case AST_EXPR_STMT:
+        case AST_ECHO_STMT:
+        case AST_RETURN_STMT:
+        case AST_CD_STMT:
+            /* Expression of these statements is first member of their structures */
+            node = flat_add_node(flat, ast->tag, NULL);
+            child = flat_lower(flat, ast->data.AST_EXPR_STMT.expr);
+            return (flat->lhs[node] = child, node);
+        case AST_GROUPING_EXPR:
+            node = flat_add_node(flat, ast->tag, ast->data.AST_GROUPING_EXPR.token);
+            child = flat_lower(flat, ast->data.AST_GROUPING_EXPR.left);
+            return (flat->lhs[node] = child, node);
+        case AST_BLOCK_STMT:
+            node = flat_add_node(flat, ast->tag, NULL);
+            start = flat_reserve_extra(flat, 1 + ast->data.AST_BLOCK_STMT.stmt_num);
+            flat->extra[start] = ast->data.AST_BLOCK_STMT.slot_num;
+            flat_lower_list(flat, ast->data.AST_BLOCK_STMT.stmt_list, ast->data.AST_BLOCK_STMT.stmt_num, start + 1);
+            flat->lhs[node] = start;
+            flat->rhs[node] = ast->data.AST_BLOCK_STMT.stmt_num;
+            return node;
+        case AST_RUN_STMT:
+            node = flat_add_node(flat, ast->tag, ast->data.AST_RUN_STMT.program_name);
+            start = flat_reserve_extra(flat, ast->data.AST_RUN_STMT.arg_num);
+            flat_lower_list(flat, ast->data.AST_RUN_STMT.args_list, ast->data.AST_RUN_STMT.arg_num, start);
+            flat->lhs[node] = start;
+            flat->rhs[node] = ast->data.AST_RUN_STMT.arg_num;
+            return node;
+        case AST_CALL_EXPR:
+            node = flat_add_node(flat, ast->tag, ast->data.AST_CALL_EXPR.callee->data.token);
+            start = flat_reserve_extra(flat, ast->data.AST_CALL_EXPR.stmt_num);
+            flat_lower_list(flat, ast->data.AST_CALL_EXPR.stmt_list, ast->data.AST_CALL_EXPR.stmt_num, start);
+            flat->lhs[node] = start;
+            flat->rhs[node] = ast->data.AST_CALL_EXPR.stmt_num;
+            return node;
+        case AST_IF_STMT:
+            node = flat_add_node(flat, ast->tag, NULL);
+            start = flat_reserve_extra(flat, 2);
+            child = flat_lower(flat, ast->data.AST_IF_STMT.condition);
+            flat->lhs[node] = child;
+            child = flat_lower(flat, ast->data.AST_IF_STMT.true_branch);
+            flat->extra[start] = child;
+            child = flat_lower(flat, ast->data.AST_IF_STMT.else_branch);
+            flat->extra[start + 1] = child;
+            return (flat->rhs[node] = start, node);
+        case AST_WHILE_STMT:
+            node = flat_add_node(flat, ast->tag, NULL);
+            child = flat_lower(flat, ast->data.AST_WHILE_STMT.condition);
+            flat->lhs[node] = child;
+            child = flat_lower(flat, ast->data.AST_WHILE_STMT.body);
+            return (flat->rhs[node] = child, node);
+        case AST_FOR_STMT:
+            node = flat_add_node(flat, ast->tag, NULL);
+            start = flat_reserve_extra(flat, 4);
+            flat->extra[start + 3] = ast->data.AST_FOR_STMT.slot_num;
+            child = flat_lower(flat, ast->data.AST_FOR_STMT.initializer);
+            flat->extra[start] = child;
+            child = flat_lower(flat, ast->data.AST_FOR_STMT.condition);
+            flat->extra[start + 1] = child;
+            child = flat_lower(flat, ast->data.AST_FOR_STMT.increment);
+            flat->extra[start + 2] = child;
+            flat->lhs[node] = start;
+            child = flat_lower(flat, ast->data.AST_FOR_STMT.body);
+            return (flat->rhs[node] = child, node);
+        case AST_TIME_STMT:
+        case AST_CLEAR_STMT:
+            return flat_add_node(flat, ast->tag, NULL);
+        case AST_ASSIGN_EXPR:
+            node = flat_add_node(flat, ast->tag, ast->data.AST_ASSIGN_EXPR.token);
+            start = flat_reserve_extra(flat, 2);
+            flat->extra[start] = ast->data.AST_ASSIGN_EXPR.depth;
+            flat->extra[start + 1] = ast->data.AST_ASSIGN_EXPR.slot;
+            child = flat_lower(flat, ast->data.AST_ASSIGN_EXPR.expr);
+            flat->lhs[node] = child;
+            return (flat->rhs[node] = start, node);
+        case AST_UNARY_EXPR:
+            node = flat_add_node(flat, ast->tag, ast->data.AST_UNARY_EXPR.token);
+            child = flat_lower(flat, ast->data.AST_UNARY_EXPR.right);
+            return (flat->lhs[node] = child, node);
+        case AST_LOGICAL_EXPR:
+        case AST_BINARY_EXPR:
+            /* Logical and binary expressions share the same layout */
+            node = flat_add_node(flat, ast->tag, ast->data.AST_BINARY_EXPR.token);
+            child = flat_lower(flat, ast->data.AST_BINARY_EXPR.left);
+            flat->lhs[node] = child;
+            child = flat_lower(flat, ast->data.AST_BINARY_EXPR.right);
+            return (flat->rhs[node] = child, node);
+        default:
+            break;
+    }
+    INTERNAL_ERROR("Tried to lower undefined AST node type.");
+    exit(EXIT_FAILURE);
+}
+
+extern void flat_ast_build(FlatAST *flat, AST **roots, const size_t root_num, Token *token_base, const size_t token_num)
+{
+    memset(flat, 0, sizeof(FlatAST));
+    flat->token_base = token_base;
+    flat->token_num = token_num;
+    /* Node 0 is reserved so that FLAT_NONE can mark missing children */
+    flat_add_node(flat, AST_LITERAL, NULL);
+
+    flat->root_num = root_num;
+    flat->roots = flat_reserve_extra(flat, root_num);
+    flat_lower_list(flat, roots, root_num, flat->roots);
+}
+
+extern int flat_ast_lower_function(FlatAST *flat, const FlatNode node)
+{
+    if(flat->lhs[node] != FLAT_NONE) return TRUE;
+
+    /* Name token is in token_base, declaration is parsed again from it together with its body */
+    AST *funct = frontend_function(flat_ast_token(flat, node));
+    if(funct == NULL) return FALSE;
+    uint32_t start = flat_lower_definition(flat, funct);
+    flat->lhs[node] = start;
+    return TRUE;
+}
+
+extern void flat_ast_make_strings(FlatAST *flat)
+{
+    for(FlatNode node = 1; node < flat->node_num; ++node) {
+        if(flat->tags[node] == AST_LITERAL && flat_ast_token(flat, node)->type == STRING)
+            flat->lhs[node] = flat_add_string(flat, flat_ast_token(flat, node));
+    }
+}
+
+extern Token *flat_ast_token(const FlatAST *flat, const FlatNode node)
+{
+    uint32_t token = flat->tokens[node];
+    if(token == FLAT_NO_TOKEN) return NULL;
+    return (token < flat->token_num) ? &flat->token_base[token] : &flat->constants[token - flat->token_num];
+}
+
+extern size_t flat_ast_bytes(const FlatAST *flat)
+{
+    size_t node_size = sizeof(uint8_t) + 3 * sizeof(uint32_t);
+    return flat->node_num * node_size + flat->extra_num * sizeof(FlatNode) + flat->constant_num * sizeof(Token)
+         + flat->string_num * sizeof(char *) + flat->string_arena.bytes_used;
+}
+
+extern void flat_ast_free(FlatAST *flat)
+{
+    free(flat->tags);
+    free(flat->tokens);
+    free(flat->lhs);
+    free(flat->rhs);
+    free(flat->extra);
+    free(flat->constants);
+    free(flat->strings);
+    arena_release(&flat->string_arena);
+    memset(flat, 0, sizeof(FlatAST));
+}
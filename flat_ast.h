@@ -0,0 +1,85 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#define FLAT_NONE 0
+#define FLAT_NO_TOKEN UINT32_MAX
+#define FLAT_FIRST_CAPACITY 64
+
+/*@Function: flat_add_node
+*Helper Function: Appends node with tag and token, grows node arrays geometrically */
+static FlatNode flat_add_node(FlatAST *, const uint8_t, const Token *);
+
+/*@Function: flat_token_index
+*Helper Function: Returns index of token, tokens outside of token_base are copied into constants */
+static uint32_t flat_token_index(FlatAST *, const Token *);
+
+/*@Function: flat_add_string
+*Helper Function: Makes static string of string literal token in string arena and returns its index */
+static uint32_t flat_add_string(FlatAST *, Token *);
+
+/*@Function: flat_reserve_extra
+*Helper Function: Reserves count slots in extra and returns index of the first one */
+static uint32_t flat_reserve_extra(FlatAST *, const size_t);
+
+/*@Function: flat_lower_list
+*Helper Function: Lowers list of nodes into reserved range of extra */
+static void flat_lower_list(FlatAST *, AST **, const size_t, const uint32_t);
+
+/*@Function: flat_lower_definition
+*Helper Function: Lowers parameters and statements of parsed function into extra and returns index of definition */
+static uint32_t flat_lower_definition(FlatAST *, AST *);
+
+/*@Function: flat_lower
+*Helper Function: Lowers pointer AST node and its children, parent is stored before children */
+static FlatNode flat_lower(FlatAST *, AST *);
+
+/*@Function: flat_ast_build
+*Function that builds FlatAST from statements returned by parser, tokens must outlive FlatAST */
+extern void flat_ast_build(FlatAST *, AST **, const size_t, Token *, const size_t);
+
+/*@Function: flat_ast_lower_function
+*Function that parses and lowers body of FUNCT_DECL node that was left unlowered, does nothing if body is lowered.
+*Nodes and extra may be reallocated, so callers hold indices instead of pointers. Returns FALSE on parse error */
+extern int flat_ast_lower_function(FlatAST *, const FlatNode);
+
+/*@Function: flat_ast_make_strings
+*Function that makes static strings of string literals of FlatAST loaded from cache, source must be attached */
+extern void flat_ast_make_strings(FlatAST *);
+
+/*@Function: flat_ast_token
+*Function that returns token of node or NULL if node has no token */
+extern Token *flat_ast_token(const FlatAST *, const FlatNode);
+
+/*@Function: flat_ast_bytes
+*Function that returns number of bytes used by nodes and extra of FlatAST */
+extern size_t flat_ast_bytes(const FlatAST *);
+
+/*@Function: flat_ast_free
+*Function that frees all arrays of FlatAST */
+extern void flat_ast_free(FlatAST *);
+
+#endif // FLAT_AST_H
@@ -0,0 +1,393 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <string.h>
+#include "coretypes.h"
+#include "error.h"
+#include "lexer.h"
+#include "environment.h"
+#include "value.h"
+#include "flat_ast.h"
+#include "trace.h"
+#include "interpreter.h"
+#include "flat_interpreter.h"
+
+static jmp_buf sync_env;
+/* Return statement stores its value here, function call takes it after jumping out of its statements */
+static ValueTagged flat_return_value = VALUE_NONE;
+/* Mark of function that is running, return jumps to it from any scope nested in function */
+static jmp_buf *flat_return_mark = NULL;
+
+static void flat_runtime_error_mode(void) 
+{
+    error_flag = TRUE;
+    longjmp(sync_env, TRUE);
+}
+
+static Token *flat_token(const FlatAST *flat, const FlatNode node)
+{
+    uint32_t token = flat->tokens[node];
+    if(token == FLAT_NO_TOKEN) return NULL;
+    return (token < flat->token_num) ? &flat->token_base[token] : &flat->constants[token - flat->token_num];
+}
+
+static ValueTagged flat_function_interpret(Token *callee, ValueTagged *args, const size_t arg_num, EnvironmentMap *env_parrent) 
+{
+    if(callee == NULL) INTERNAL_ERROR("Passed null callee argument");
+   
+    EnvironmentMap env_child = {.env = NULL, .env_enclosing = env_parrent, .env_return = NULL, .env_size = 0};
+    Environment *function = env_get_function(callee, env_parrent);
+    if(function == NULL) flat_runtime_error_mode();
+
+    FlatAST *flat = function->data.ENV_FUNCTION.flat;
+    if(flat == NULL) {
+        INTERNAL_ERROR("Function was not defined by flat interpreter!");
+        exit(EXIT_FAILURE);
+    }
+    /* Body is parsed and lowered on first call, parse error stops the statement like runtime error */
+    if(!flat_ast_lower_function(flat, function->data.ENV_FUNCTION.node)) flat_runtime_error_mode();
+    /* Nested functions lowered by statements grow extra, so definition is addressed by index */
+    uint32_t definition = flat->lhs[function->data.ENV_FUNCTION.node];
+    size_t param_num = flat->extra[definition];
+    size_t stmt_num = flat->extra[definition + 1];
+    uint32_t parameters = definition + 3;
+    uint32_t stmt_list = definition + 3 + param_num;
+    
+    TRACE(TRACE_EVAL, "Call %s with %zu arguments\n", token_lexeme(callee), arg_num);
+    if(arg_num != param_num) {
+        fprintf(stderr, "Error when calling %s, number of arguments given %zu but expected %zu\n", token_lexeme(callee), arg_num, param_num);
+        flat_runtime_error_mode();
+    }
+
+    env_reserve_slots(&env_child, flat->extra[definition + 2]);
+    for(size_t i = 0; i < param_num; ++i) {
+        FlatNode parameter = flat->extra[parameters + i];
+        env_define_slot(flat_token(flat, parameter), flat->rhs[parameter], &args[i], &env_child);
+    }
+    
+    jmp_buf *caller_mark = flat_return_mark;
+    flat_return_mark = &env_child.env_jmp_mark;
+    if(!setjmp(*flat_return_mark)) {
+        for(size_t i = 0; i < stmt_num; ++i) {
+            ValueTagged value = flat_evaluate(flat, flat->extra[stmt_list + i], &env_child);
+            value_release(&value);
+        }
+    }
+    flat_return_mark = caller_mark;
+    env_reset(&env_child);
+    /* Function that ended without return gives no value */
+    ValueTagged result = flat_return_value;
+    flat_return_value = VALUE_NONE;
+    return result; 
+}
+
+static ValueTagged flat_evaluate_identifier(FlatAST *flat, const FlatNode node, EnvironmentMap *env_host) 
+{
+    ValueTagged *found = env_get_slot(flat_token(flat, node), flat->lhs[node], flat->rhs[node], env_host);
+    if(found == NULL) return VALUE_NONE;
+    return value_clone(found);
+}
+
+static ValueTagged flat_evaluate_unary_expression(FlatAST *flat, const FlatNode node, EnvironmentMap *env_host) 
+{
+    ValueTagged right = flat_evaluate(flat, flat->lhs[node], env_host);
+    ValueTagged result;
+    if(!value_unary_into(flat_token(flat, node), &right, &result)) flat_runtime_error_mode();
+    return result;
+}
+
+static ValueTagged flat_evaluate_binary_expression(FlatAST *flat, const FlatNode node, EnvironmentMap *env_host) 
+{
+    ValueTagged left = flat_evaluate(flat, flat->lhs[node], env_host);
+    ValueTagged right = flat_evaluate(flat, flat->rhs[node], env_host);
+    ValueTagged result;
+    if(!value_binary_into(flat_token(flat, node), &left, &right, &result)) flat_runtime_error_mode();
+    return result;
+}
+
+static ValueTagged flat_evaluate_call_expression(FlatAST *flat, const FlatNode node, EnvironmentMap *env_host)
+{
+    uint32_t arg_list = flat->lhs[node];
+    size_t arg_num = flat->rhs[node];
+    /* Arguments are kept on C stack, one more slot keeps array size above zero */
+    ValueTagged args[arg_num + 1];
+    
+    for(size_t i = 0; i < arg_num; ++i) {
+        args[i] = flat_evaluate(flat, flat->extra[arg_list + i], env_host);
+    }
+
+    ValueTagged result = flat_function_interpret(flat_token(flat, node), args, arg_num, env_host);
+
+    for(size_t i = 0; i < arg_num; ++i) {
+        value_release(&args[i]);
+    }
+    return result;
+}
+
+static ValueTagged flat_evaluate_logical_expression(FlatAST *flat, const FlatNode node, EnvironmentMap *env_host) 
+{
+    ValueTagged left = flat_evaluate(flat, flat->lhs[node], env_host);
+
+    if(flat_token(flat, node)->type == DOUBLE_OR) {
+        if(value_is_truth(&left)) return left;
+    }
+    else {
+        if(!value_is_truth(&left)) return left;
+    }
+
+    value_release(&left);
+    return flat_evaluate(flat, flat->rhs[node], env_host);
+}
+
+static ValueTagged flat_evaluate_assign_expression(FlatAST *flat, const FlatNode node, EnvironmentMap *env_host) 
+{
+    const FlatNode expr = flat->lhs[node];
+    const uint32_t binding = flat->rhs[node];
+    ValueTagged value;
+
+    if(flat->tags[expr] == AST_BINARY_EXPR && flat_token(flat, expr)->type == ADD) {
+        /* s = s + x: variable drops its string after both operands are evaluated, so it is appended in place */
+        ValueTagged left = flat_evaluate(flat, flat->lhs[expr], env_host);
+        ValueTagged right = flat_evaluate(flat, flat->rhs[expr], env_host);
+        if(value_can_append(&left, &right))
+            env_release_string(flat_token(flat, node), flat->extra[binding], flat->extra[binding + 1], left.literal.char_value, env_host);
+        if(!value_binary_into(flat_token(flat, expr), &left, &right, &value)) flat_runtime_error_mode();
+    }
+    else
+        value = flat_evaluate(flat, expr, env_host);
+    
+    env_assign_slot(flat_token(flat, node), flat->extra[binding], flat->extra[binding + 1], &value, env_host);
+    return (value_release(&value), VALUE_NONE);
+}
+
+static ValueTagged flat_evaluate_if_statement(FlatAST *flat, const FlatNode node, EnvironmentMap *env_host) 
+{
+    ValueTagged condition = flat_evaluate(flat, flat->lhs[node], env_host);
+    int truth = value_is_truth(&condition);
+    value_release(&condition);
+
+    FlatNode branch = flat->extra[flat->rhs[node] + !truth];
+    if(branch == FLAT_NONE) return VALUE_NONE;
+    ValueTagged value = flat_evaluate(flat, branch, env_host);
+    return (value_release(&value), VALUE_NONE);
+}
+
+static ValueTagged flat_evaluate_while_statement(FlatAST *flat, const FlatNode node, EnvironmentMap *env_host) 
+{
+    ValueTagged condition = flat_evaluate(flat, flat->lhs[node], env_host);
+    while(value_is_truth(&condition)) {
+        value_release(&condition);
+        ValueTagged value = flat_evaluate(flat, flat->rhs[node], env_host);
+        value_release(&value);
+        condition = flat_evaluate(flat, flat->lhs[node], env_host); 
+    }
+    return (value_release(&condition), VALUE_NONE);
+}
+
+static ValueTagged flat_evaluate_for_statement(FlatAST *flat, const FlatNode node, EnvironmentMap *env_host) 
+{
+    const uint32_t clauses = flat->lhs[node];
+    ValueTagged value;
+
+    EnvironmentMap env_child = {.env = NULL, .env_enclosing = env_host, .env_return = NULL, .env_size = 0};
+    env_reserve_slots(&env_child, flat->extra[clauses + 3]);
+    if(flat->extra[clauses] != FLAT_NONE) {
+        value = flat_evaluate(flat, flat->extra[clauses], &env_child);
+        value_release(&value);
+    }
+    
+    /* Missing condition loops forever, like in bytecode compiler */
+    while(TRUE) {
+        if(flat->extra[clauses + 1] != FLAT_NONE) {
+            value = flat_evaluate(flat, flat->extra[clauses + 1], &env_child);
+            int truth = value_is_truth(&value);
+            value_release(&value);
+            if(!truth) break;
+        }
+        value = flat_evaluate(flat, flat->rhs[node], &env_child);
+        value_release(&value);
+        if(flat->extra[clauses + 2] != FLAT_NONE) {
+            value = flat_evaluate(flat, flat->extra[clauses + 2], &env_child);
+            value_release(&value);
+        }
+    }
+    
+    env_reset(&env_child);
+    return VALUE_NONE;
+}
+
+static ValueTagged flat_evaluate_block_statement(FlatAST *flat, const FlatNode node, EnvironmentMap *env_parrent, EnvironmentMap *env_host) 
+{
+    const uint32_t stmt_list = flat->lhs[node] + 1;
+    env_host->env_enclosing = env_parrent;
+    env_reserve_slots(env_host, flat->extra[flat->lhs[node]]);
+
+    for(size_t i = 0; i < flat->rhs[node]; ++i) {
+        ValueTagged value = flat_evaluate(flat, flat->extra[stmt_list + i], env_host);
+        value_release(&value);
+    }
+    /* Free memory of Local Environment */
+    env_reset(env_host);
+    return VALUE_NONE;
+}
+
+static ValueTagged flat_evaluate_variable_statement(FlatAST *flat, const FlatNode node, EnvironmentMap *env_host) 
+{   
+    ValueTagged value = VALUE_NONE;
+    if(flat->lhs[node] != FLAT_NONE) 
+        value = flat_evaluate(flat, flat->lhs[node], env_host);
+
+    env_define_slot(flat_token(flat, node), flat->rhs[node], &value, env_host);
+    return (value_release(&value), VALUE_NONE);
+}
+
+static ValueTagged flat_evaluate_return_statement(FlatAST *flat, const FlatNode node, EnvironmentMap *env_host)
+{
+    if(flat_return_mark == NULL) {
+        fprintf(stderr, "Runtime error: Can't return outside of function!\n");
+        flat_runtime_error_mode();
+    }
+    if(flat->lhs[node] == FLAT_NONE) 
+        flat_return_value = VALUE_NONE;
+    else
+        flat_return_value = flat_evaluate(flat, flat->lhs[node], env_host);
+    /* Scopes nested in function are left by the jump, so they are freed here */
+    for(EnvironmentMap *env = env_host; &env->env_jmp_mark != flat_return_mark; env = env->env_enclosing) 
+        env_reset(env);
+    longjmp(*flat_return_mark, TRUE);
+}
+
+static ValueTagged flat_evaluate_run_statement(FlatAST *flat, const FlatNode node, EnvironmentMap *env_host)
+{
+    Token *program_token = flat_token(flat, node);
+    if(program_token == NULL) {
+        fprintf(stdout, "Runtime warning: run command requires a program name to run!\n");
+        flat_runtime_error_mode();
+    }
+
+    const uint32_t args_list = flat->lhs[node];
+    size_t arg_num = flat->rhs[node];
+    char **argv = malloc(sizeof(char *) * (arg_num + 2));
+    
+    argv[0] = strdup(token_lexeme(program_token));
+    argv[1] = NULL;
+    for(size_t i = 0; i < arg_num; ++i) {
+        ValueTagged arg = flat_evaluate(flat, flat->extra[args_list + i], env_host);
+        argv[i+1] = value_string(&arg);
+        value_release(&arg);
+        if(error_flag || argv[i+1] == NULL) {
+            /* Error of the argument itself was already reported */
+            if(!error_flag) operator_error(program_token, "Arguments of run must be strings, numbers or booleans!");
+            for(size_t j = 0; j <= i + 1; ++j) free(argv[j]);
+            free(argv);
+            flat_runtime_error_mode();
+        }
+        argv[i+2] = NULL;
+    }
+    builtin_run(program_token, argv);
+    
+    for(size_t i = 0; i < arg_num + 1; ++i) {
+        free(argv[i]);
+    }
+    free(argv);
+    return VALUE_NONE;
+}
+
+static ValueTagged flat_evaluate(FlatAST *flat, const FlatNode node, EnvironmentMap *env_host) 
+{  
+    TRACE(TRACE_EVAL, "Evaluate %s\n", trace_ast_name(flat->tags[node]));
+    switch (flat->tags[node]) {
+    case AST_LITERAL:
+        /* String made by flat lowering is shared, its bytes are not copied */
+        if(flat_token(flat, node)->type == STRING)
+            return (ValueTagged){.type = STRING, .literal.char_value = string_copy(flat->strings[flat->lhs[node]])};
+        return value_literal(flat_token(flat, node));
+    case AST_IDENTIFIER:
+        return flat_evaluate_identifier(flat, node, env_host);    
+    case AST_UNARY_EXPR:
+        return flat_evaluate_unary_expression(flat, node, env_host);
+    case AST_CALL_EXPR:
+        return flat_evaluate_call_expression(flat, node, env_host);
+    case AST_BINARY_EXPR:
+        return flat_evaluate_binary_expression(flat, node, env_host);
+    case AST_GROUPING_EXPR:
+    case AST_EXPR_STMT:
+        return flat_evaluate(flat, flat->lhs[node], env_host);
+    case AST_LOGICAL_EXPR:
+        return flat_evaluate_logical_expression(flat, node, env_host);
+    case AST_ASSIGN_EXPR:
+        return flat_evaluate_assign_expression(flat, node, env_host);
+    case AST_BLOCK_STMT:
+        EnvironmentMap env_child = {.env = NULL, .env_enclosing = NULL, .env_return = NULL, .env_size = 0};
+        return flat_evaluate_block_statement(flat, node, env_host, &env_child);
+    case AST_IF_STMT:
+        return flat_evaluate_if_statement(flat, node, env_host);
+    case AST_WHILE_STMT:
+        return flat_evaluate_while_statement(flat, node, env_host);
+    case AST_FOR_STMT:
+        return flat_evaluate_for_statement(flat, node, env_host);
+    case AST_ECHO_STMT:
+        ValueTagged result = flat_evaluate(flat, flat->lhs[node], env_host);
+        if(!error_flag) value_echo(&result);
+        return (value_release(&result), VALUE_NONE);
+    case AST_VAR_DECL_STMT:
+        return flat_evaluate_variable_statement(flat, node, env_host);
+    case AST_FUNCT_DECL_STMT:
+        env_define_function(flat_token(flat, node), env_host, NULL, flat, node, NULL, NULL);
+        return VALUE_NONE;
+    case AST_RETURN_STMT:
+        return flat_evaluate_return_statement(flat, node, env_host);
+    case AST_TIME_STMT:
+        builtin_time();
+        return VALUE_NONE;
+    case AST_CLEAR_STMT:
+        builtin_clear();
+        return VALUE_NONE;
+    case AST_CD_STMT:
+        builtin_cd((flat->lhs[node] == FLAT_NONE) ? NULL : token_lexeme(flat_token(flat, flat->lhs[node])));
+        return VALUE_NONE;
+    case AST_RUN_STMT:
+        return flat_evaluate_run_statement(flat, node, env_host);
+    default:
+        break;
+    }
+    error("Tried to evaluate undefined AST node type.", __FILE__, __LINE__);
+    return VALUE_NONE;
+}
+
+extern void flat_interpret(FlatAST *flat, const FlatNode node) 
+{
+    ValueTagged value = VALUE_NONE;
+    /* Runtime error may have jumped out of function before its mark was restored */
+    flat_return_mark = NULL;
+    if(setjmp(sync_env));
+    else {
+        TRACE(TRACE_EVAL, "Setjmp for interpreter!\n");
+        value = flat_evaluate(flat, node, &env_global);
+    }
+    value_release(&value);
+}
@@ -0,0 +1,100 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef FLAT_INTERPRETER_H
+#define FLAT_INTERPRETER_H
+
+/*@Function: flat_runtime_error_mode
+*Function that deals with runtime error by jumping to next stmt */
+static void flat_runtime_error_mode(void);
+
+/*@Function: flat_token
+*Helper Function: Returns token of node or NULL if node has no token */
+static Token *flat_token(const FlatAST *, const FlatNode);
+
+/*@Function: flat_function_interpret
+*Function that interprets function definition stored in FlatAST that was called from environment */
+static ValueTagged flat_function_interpret(Token *, ValueTagged *, const size_t, EnvironmentMap *);
+
+/*@Function: flat_evaluate_identifier
+*Function that returns value of identifier found in Environment */
+static ValueTagged flat_evaluate_identifier(FlatAST *, const FlatNode, EnvironmentMap *);
+
+/*@Function: flat_evaluate_unary_expression
+*Function that evaluates unary expression */
+static ValueTagged flat_evaluate_unary_expression(FlatAST *, const FlatNode, EnvironmentMap *);
+
+/*@Function: flat_evaluate_binary_expression
+*Function that evaluates binary expression */
+static ValueTagged flat_evaluate_binary_expression(FlatAST *, const FlatNode, EnvironmentMap *);
+
+/*@Function: flat_evaluate_call_expression
+*Function that evaluates call expression */
+static ValueTagged flat_evaluate_call_expression(FlatAST *, const FlatNode, EnvironmentMap *);
+
+/*@Function: flat_evaluate_logical_expression
+*Function that evaluates logical expression */
+static ValueTagged flat_evaluate_logical_expression(FlatAST *, const FlatNode, EnvironmentMap *);
+
+/*@Function: flat_evaluate_assign_expression
+*Function that evaluates assign expression */
+static ValueTagged flat_evaluate_assign_expression(FlatAST *, const FlatNode, EnvironmentMap *);
+
+/*@Function: flat_evaluate_if_statement
+*Function that evaluates if statement */
+static ValueTagged flat_evaluate_if_statement(FlatAST *, const FlatNode, EnvironmentMap *);
+
+/*@Function: flat_evaluate_while_statement
+*Function that evaluates while statement */
+static ValueTagged flat_evaluate_while_statement(FlatAST *, const FlatNode, EnvironmentMap *);
+
+/*@Function: flat_evaluate_for_statement
+*Function that evaluates for statement */
+static ValueTagged flat_evaluate_for_statement(FlatAST *, const FlatNode, EnvironmentMap *);
+
+/*@Function: flat_evaluate_block_statement
+*Function that evaluates block statement */
+static ValueTagged flat_evaluate_block_statement(FlatAST *, const FlatNode, EnvironmentMap *, EnvironmentMap *);
+
+/*@Function: flat_evaluate_variable_statement
+*Function that evaluates variable statement */
+static ValueTagged flat_evaluate_variable_statement(FlatAST *, const FlatNode, EnvironmentMap *);
+
+/*@Function: flat_evaluate_return_statement
+*Function that evaluates return statement */
+static ValueTagged flat_evaluate_return_statement(FlatAST *, const FlatNode, EnvironmentMap *);
+
+/*@Function: flat_evaluate_run_statement
+*Function that evaluates run statement */
+static ValueTagged flat_evaluate_run_statement(FlatAST *, const FlatNode, EnvironmentMap *);
+
+/*@Function: flat_evaluate
+*Function that calls evaluation of specific node type */
+static ValueTagged flat_evaluate(FlatAST *, const FlatNode, EnvironmentMap *);
+
+/*@Function: flat_interpret
+*Function that interprets statement stored in FlatAST */
+extern void flat_interpret(FlatAST *, const FlatNode);
+
+#endif // FLAT_INTERPRETER_H
@@ -0,0 +1,271 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "coretypes.h"
+#include "error.h"
+#include "lexer.h"
+#include "arena.h"
+#include "parser.h"
+#include "symbol.h"
+#include "optimizer.h"
+#include "resolver.h"
+#include "trace.h"
+#include "frontend.h"
+
+/* Function bodies parsed by frontend_function_body live until frontend_release, they outlive the arena of one statement */
+static Arena body_arena = {NULL, 0, 0, NULL};
+
+static int is_chunk_start(const char *span, const size_t length)
+{
+    /* Whitespace after keyword is required, so that identifiers like variable are not taken for var */
+    if (length > 3 && !memcmp(span, "var", 3) && (span[3] == ' ' || span[3] == '\t' || span[3] == '\n' || span[3] == '\r'))
+        return TRUE;
+    if (length > 5 && !memcmp(span, "funct", 5) && (span[5] == ' ' || span[5] == '\t' || span[5] == '\n' || span[5] == '\r'))
+        return TRUE;
+    return FALSE;
+}
+
+static size_t frontend_split(const Source *source, FrontendChunk *chunks, const size_t chunk_max)
+{
+    const char *data = source->data;
+    const size_t size = source->size;
+    const size_t chunk_size = size / chunk_max;
+    size_t chunk_num = 0, line_number = 1, depth = 0;
+
+    chunks[0] = (FrontendChunk){.source = source, .begin = 0, .line_number = 1};
+    for (size_t i = 0; i < size && chunk_num + 1 < chunk_max; ++i) {
+        switch (data[i]) {
+        case '\n':
+            line_number++;
+            continue;
+        case '#':
+            /* Comment lasts until the end of the line, new line is counted by the loop */
+            while (i + 1 < size && data[i + 1] != '\n')
+                i++;
+            continue;
+        case '"':
+            /* Strings end at unescaped quotes or at the end of the line like in the lexer */
+            while (i + 1 < size && data[i + 1] != '"' && data[i + 1] != '\n')
+                i += (data[i + 1] == '\\' && i + 2 < size && data[i + 2] != '\n') ? 2 : 1;
+            if (i + 1 < size && data[i + 1] == '"')
+                i++;
+            continue;
+        case '{':
+        case '(':
+            depth++;
+            continue;
+        case '}':
+        case ')':
+            /* Unbalanced script is not split, parser reports the error */
+            if (depth == 0)
+                goto SPLIT_DONE_LABEL;
+            depth--;
+            if (data[i] == ')')
+                continue;
+            break;
+        case ';':
+            break;
+        default:
+            continue;
+        }
+
+        /* Statement ended at top level, chunk may end if the next statement is a declaration */
+        if (depth != 0 || i + 1 < chunks[chunk_num].begin + chunk_size)
+            continue;
+        size_t next = i + 1, next_line = line_number;
+        while (next < size && (data[next] == ' ' || data[next] == '\t' || data[next] == '\r' || data[next] == '\n' || data[next] == '#')) {
+            if (data[next] == '#')
+                while (next + 1 < size && data[next + 1] != '\n')
+                    next++;
+            else if (data[next] == '\n')
+                next_line++;
+            next++;
+        }
+        if (!is_chunk_start(&data[next], size - next))
+            continue;
+
+        chunks[chunk_num].end = next;
+        chunk_num++;
+        chunks[chunk_num] = (FrontendChunk){.source = source, .begin = next, .line_number = next_line};
+    }
+
+    SPLIT_DONE_LABEL:
+    chunks[chunk_num].end = size;
+    return chunk_num + 1;
+}
+
+static void *frontend_lex_chunk(void *argument)
+{
+    FrontendChunk *chunk = argument;
+    if (source_lexer_range(chunk->source, chunk->begin, chunk->end, chunk->line_number, &chunk->tokens) == NULL || error_flag)
+        chunk->error = TRUE;
+    return NULL;
+}
+
+static void *frontend_parse_chunk(void *argument)
+{
+    FrontendChunk *chunk = argument;
+    chunk->ast = parser(chunk->token_list, &chunk->statement_num, &chunk->arena);
+    chunk->error = error_flag;
+    return NULL;
+}
+
+static int frontend_run(FrontendChunk *chunks, const size_t chunk_num, void *(*routine)(void *))
+{
+    pthread_t threads[FRONTEND_MAX_JOBS];
+    int started[FRONTEND_MAX_JOBS] = {FALSE};
+    int failed = FALSE;
+
+    /* Chunk that could not get a thread runs on calling thread */
+    for (size_t i = 1; i < chunk_num; ++i) {
+        started[i] = !pthread_create(&threads[i], NULL, routine, &chunks[i]);
+        if (!started[i])
+            routine(&chunks[i]);
+    }
+    routine(&chunks[0]);
+    for (size_t i = 0; i < chunk_num; ++i) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        failed |= chunks[i].error;
+    }
+    return failed;
+}
+
+static void frontend_merge_tokens(const Source *source, FrontendChunk *chunks, const size_t chunk_num, TokenVector *ctokens)
+{
+    size_t token_num = ctokens->size;
+    for (size_t i = 0; i < chunk_num; ++i)
+        token_num += chunks[i].tokens.size;
+
+    if (token_num > ctokens->capacity) {
+        Token *tokens = realloc(ctokens->tokens, sizeof(Token) * token_num);
+        if (tokens == NULL) {
+            INTERNAL_ERROR("Failed to allocate merged tokens!");
+            exit(EXIT_FAILURE);
+        }
+        ctokens->tokens = tokens;
+        ctokens->capacity = token_num;
+    }
+
+    /* Identifiers are interned in source order, so symbols are numbered as by source_lexer */
+    for (size_t i = 0; i < chunk_num; ++i) {
+        Token *tokens = &ctokens->tokens[ctokens->size];
+        memcpy(tokens, chunks[i].tokens.tokens, sizeof(Token) * chunks[i].tokens.size);
+        for (size_t j = 0; j < chunks[i].tokens.size; ++j)
+            if (tokens[j].type == IDENTIFIER)
+                tokens[j].symbol = symbol_intern(source->data + tokens[j].offset, tokens[j].length);
+        chunks[i].token_list = tokens;
+        ctokens->size += chunks[i].tokens.size;
+
+        free(chunks[i].tokens.tokens);
+        chunks[i].tokens = (TokenVector){NULL, 0, 0};
+    }
+}
+
+extern AST **frontend_parse(const Source *source, TokenVector *ctokens, size_t *statement_number, Arena *arena, size_t jobs)
+{
+    FrontendChunk chunks[FRONTEND_MAX_JOBS];
+    size_t chunk_num = 0;
+    *statement_number = 0;
+
+    if (jobs == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = (cpus > 0) ? (size_t)cpus : 1;
+    }
+    if (jobs > FRONTEND_MAX_JOBS)
+        jobs = FRONTEND_MAX_JOBS;
+    if (jobs > source->size / FRONTEND_MIN_CHUNK)
+        jobs = source->size / FRONTEND_MIN_CHUNK;
+
+    /* Small scripts and traced runs take the sequential path, trace sink is not thread safe */
+    if (jobs > 1 && !TRACE_ON(TRACE_LEXER | TRACE_PARSER))
+        chunk_num = frontend_split(source, chunks, jobs);
+    if (chunk_num < 2) {
+        if (source_lexer(source, ctokens) == NULL || error_flag)
+            return NULL;
+        return parser(ctokens->tokens, statement_number, arena);
+    }
+
+    source_attach(source);
+    if (frontend_run(chunks, chunk_num, frontend_lex_chunk)) {
+        set_error_flag();
+        goto DEALLOCATE_CHUNKS_LABEL;
+    }
+    frontend_merge_tokens(source, chunks, chunk_num, ctokens);
+    if (frontend_run(chunks, chunk_num, frontend_parse_chunk))
+        set_error_flag();
+
+    /* Statements are merged in source order, chunk arenas become part of arena of compilation unit */
+    size_t statement_num = 0;
+    for (size_t i = 0; i < chunk_num; ++i)
+        statement_num += chunks[i].statement_num;
+    AST **ast = (statement_num) ? arena_alloc(arena, sizeof(AST *) * statement_num) : NULL;
+    for (size_t i = 0, position = 0; i < chunk_num; ++i) {
+        if (chunks[i].statement_num)
+            memcpy(&ast[position], chunks[i].ast, sizeof(AST *) * chunks[i].statement_num);
+        position += chunks[i].statement_num;
+        arena_merge(arena, &chunks[i].arena);
+    }
+    *statement_number = statement_num;
+    return ast;
+
+    DEALLOCATE_CHUNKS_LABEL:
+    for (size_t i = 0; i < chunk_num; ++i)
+        token_vector_free(&chunks[i].tokens);
+    return NULL;
+}
+
+extern void frontend_function_body(AST *funct)
+{
+    if (funct->data.AST_FUNCT_DECL_STMT.body == NULL)
+        return;
+
+    TRACE(TRACE_PARSER, "Parse body of function %s\n", token_lexeme(funct->data.AST_FUNCT_DECL_STMT.name));
+    parser_function_body(funct, &body_arena);
+    if (error_flag)
+        return;
+
+    /* Body goes through the same passes as eagerly parsed statements, function scope makes it resolvable alone */
+    AST *statement = funct;
+    ast_optimize(&statement, 1, &body_arena);
+    ast_resolve(&statement, 1);
+}
+
+extern AST *frontend_function(Token *name)
+{
+    AST *funct = parser_function_declaration(name, &body_arena);
+    frontend_function_body(funct);
+    return (error_flag) ? NULL : funct;
+}
+
+extern void frontend_release(void)
+{
+    arena_release(&body_arena);
+}
@@ -0,0 +1,76 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef FRONTEND_H
+#define FRONTEND_H
+
+#define FRONTEND_MAX_JOBS 64
+#define FRONTEND_MIN_CHUNK (64 * 1024)
+
+/*@Function: is_chunk_start
+*Helper Function: Returns TRUE if top-level var or funct declaration starts at span, script can be split before it */
+static int is_chunk_start(const char *, const size_t);
+
+/*@Function: frontend_split
+*Helper Function: Splits script into at most chunk_max chunks of similar size at top-level statement boundaries, 
+*tracks braces, parentheses, strings and comments. Returns number of chunks */
+static size_t frontend_split(const Source *, FrontendChunk *, const size_t);
+
+/*@Function: frontend_lex_chunk
+*Helper Function: Thread routine that lexes one chunk into its own TokenVector */
+static void *frontend_lex_chunk(void *);
+
+/*@Function: frontend_parse_chunk
+*Helper Function: Thread routine that parses tokens of one chunk into its own arena */
+static void *frontend_parse_chunk(void *);
+
+/*@Function: frontend_run
+*Helper Function: Runs routine for every chunk, first chunk runs on calling thread. Returns TRUE if any chunk failed */
+static int frontend_run(FrontendChunk *, const size_t, void *(*)(void *));
+
+/*@Function: frontend_merge_tokens
+*Helper Function: Appends tokens of every chunk to TokenVector in source order and interns identifiers */
+static void frontend_merge_tokens(const Source *, FrontendChunk *, const size_t, TokenVector *);
+
+/*@Function: frontend_parse
+*Function that lexes and parses script, large scripts are split at top-level declarations and every chunk is
+*lexed and parsed by its own thread. Statements, symbols and errors are the same as with source_lexer and parser,
+*merged TokenVector keeps EOF of every chunk. jobs 0 uses every online CPU. Returns NULL on error like parser */
+extern AST **frontend_parse(const Source *, TokenVector *, size_t *, Arena *, size_t);
+
+/*@Function: frontend_function_body
+*Function that parses, folds and resolves body of FUNCT_DECL node that was skipped by parser, does nothing if body
+*is already parsed. Tokens of function must still be alive, error_flag is set on parse error */
+extern void frontend_function_body(AST *);
+
+/*@Function: frontend_function
+*Function that parses declaration of function from its name token together with its body, flat AST and bytecode
+*keep only the name until function is first called. Returns NULL and sets error_flag on parse error */
+extern AST *frontend_function(Token *);
+
+/*@Function: frontend_release
+*Function that frees every function body parsed by frontend_function_body */
+extern void frontend_release(void);
+
+#endif // FRONTEND_H
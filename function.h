@@ -26,8 +26,9 @@ SOFTWARE.
 #define FUNCTION_H
 
 /*@Function: function_interpret
- * A function used to interpret a function definition of a function that was called from environment */
-extern ValueTagged *function_interpret(Token *, ValueTagged **, const size_t, EnvironmentMap *);
+ * A function used to interpret a function definition of a function that was called from environment,
+ * arguments are copied into its scope and returned value is owned by caller */
+extern ValueTagged function_interpret(Token *, ValueTagged *, const size_t, EnvironmentMap *);
 
 #endif // FUNCTION_H
 
@@ -0,0 +1,111 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+/* gen_keywords: build time generator of the reserved word perfect hash.
+ * Searches for a hash over length, first, second and last character that is
+ * collision free for every word in tokens.def and prints keyword_hash.h */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_HASH_SIZE 256
+#define MAX_MULTIPLIER 64
+
+typedef struct reserved_word_s
+{
+    const char *reserved_word;
+    const char *type;
+} ReservedWord;
+
+static const ReservedWord reserved_words[] = {
+#define RESERVED_WORD(type, word, flags) {word, #type},
+#include "tokens.def"
+#undef RESERVED_WORD
+};
+
+#define RESERVED_WORD_CNT (sizeof(reserved_words) / sizeof(reserved_words[0]))
+
+/* Must be kept in sync with KEYWORD_HASH printed below */
+static unsigned keyword_hash(const char *word, size_t length, unsigned a, unsigned b, unsigned c, unsigned size)
+{
+    return ((unsigned)length + (unsigned char)word[0] * a + (unsigned char)word[1] * b + (unsigned char)word[length - 1] * c) & (size - 1);
+}
+
+static int is_perfect(unsigned a, unsigned b, unsigned c, unsigned size)
+{
+    unsigned char used[MAX_HASH_SIZE] = {0};
+    for (size_t i = 0; i < RESERVED_WORD_CNT; ++i) {
+        unsigned h = keyword_hash(reserved_words[i].reserved_word, strlen(reserved_words[i].reserved_word), a, b, c, size);
+        if (used[h])
+            return 0;
+        used[h] = 1;
+    }
+    return 1;
+}
+
+int main(void)
+{
+    size_t min_length = (size_t)-1, max_length = 0;
+    for (size_t i = 0; i < RESERVED_WORD_CNT; ++i) {
+        size_t length = strlen(reserved_words[i].reserved_word);
+        if (length < 2) {
+            fprintf(stderr, "gen_keywords: reserved word %s is shorter than two characters\n", reserved_words[i].reserved_word);
+            return EXIT_FAILURE;
+        }
+        min_length = (length < min_length) ? length : min_length;
+        max_length = (length > max_length) ? length : max_length;
+    }
+
+    /* Smallest power of two table first, then smallest multipliers */
+    for (unsigned size = 1; size <= MAX_HASH_SIZE; size *= 2) {
+        if (size < RESERVED_WORD_CNT)
+            continue;
+        for (unsigned a = 1; a < MAX_MULTIPLIER; ++a)
+        for (unsigned b = 0; b < MAX_MULTIPLIER; ++b)
+        for (unsigned c = 0; c < MAX_MULTIPLIER; ++c) {
+            if (!is_perfect(a, b, c, size))
+                continue;
+
+            printf("/* Generated by gen_keywords from tokens.def, do not edit */\n\n");
+            printf("#ifndef KEYWORD_HASH_H\n#define KEYWORD_HASH_H\n\n");
+            printf("#define KEYWORD_HASH_SIZE %u\n", size);
+            printf("#define KEYWORD_MIN_LENGTH %zu\n", min_length);
+            printf("#define KEYWORD_MAX_LENGTH %zu\n\n", max_length);
+            printf("/* Perfect hash of reserved word, span has to be at least KEYWORD_MIN_LENGTH long */\n");
+            printf("#define KEYWORD_HASH(span, length) \\\n");
+            printf("    (((unsigned)(length) + (unsigned char)(span)[0] * %uu + (unsigned char)(span)[1] * %uu + (unsigned char)(span)[(length) - 1] * %uu) & (KEYWORD_HASH_SIZE - 1))\n\n", a, b, c);
+            printf("/* Hash Map used for reserved words */\n");
+            printf("static const ReservedWordMapType keyword_hash_table[KEYWORD_HASH_SIZE] = {\n");
+            for (size_t i = 0; i < RESERVED_WORD_CNT; ++i) {
+                size_t length = strlen(reserved_words[i].reserved_word);
+                printf("    [%u] = {\"%s\", %s, %zu},\n", keyword_hash(reserved_words[i].reserved_word, length, a, b, c, size),
+                       reserved_words[i].reserved_word, reserved_words[i].type, length);
+            }
+            printf("};\n\n#endif // KEYWORD_HASH_H\n");
+            return EXIT_SUCCESS;
+        }
+    }
+    fprintf(stderr, "gen_keywords: could not find perfect hash for tokens.def\n");
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,147 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* gen_pow5: build time generator of the power of five table used by the
+ * Eisel-Lemire float parser. For every decimal exponent q in the supported
+ * range it prints the 128 most significant bits of 5^q, normalized so that
+ * the top bit is set. Negative powers are reciprocals 2^b / 5^-q rounded up. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define POW5_MIN_EXPONENT -342
+#define POW5_MAX_EXPONENT 308
+#define BIG_LIMBS 128
+
+/* Little endian arbitrary precision unsigned integer with 32 bit limbs */
+typedef struct big_s
+{
+    uint32_t limb[BIG_LIMBS];
+    size_t size;
+} Big;
+
+static void big_set(Big *big, uint32_t value)
+{
+    memset(big, 0, sizeof(*big));
+    big->limb[0] = value;
+    big->size = 1;
+}
+
+static void big_mul_small(Big *big, uint32_t factor)
+{
+    uint64_t carry = 0;
+    for (size_t i = 0; i < big->size; ++i) {
+        uint64_t product = (uint64_t)big->limb[i] * factor + carry;
+        big->limb[i] = (uint32_t)product;
+        carry = product >> 32;
+    }
+    if (carry)
+        big->limb[big->size++] = (uint32_t)carry;
+}
+
+static void big_div_small(Big *big, uint32_t divisor)
+{
+    uint64_t remainder = 0;
+    for (size_t i = big->size; i-- > 0;) {
+        uint64_t current = (remainder << 32) | big->limb[i];
+        big->limb[i] = (uint32_t)(current / divisor);
+        remainder = current % divisor;
+    }
+    while (big->size > 1 && big->limb[big->size - 1] == 0)
+        big->size--;
+}
+
+static size_t big_bits(const Big *big)
+{
+    uint32_t top = big->limb[big->size - 1];
+    return (big->size - 1) * 32 + (top ? 32 - __builtin_clz(top) : 0);
+}
+
+static int big_bit(const Big *big, size_t bit)
+{
+    return (big->limb[bit / 32] >> (bit % 32)) & 1;
+}
+
+/* Top 128 bits of big, truncated */
+static void big_top128(const Big *big, uint64_t *high, uint64_t *low)
+{
+    size_t bits = big_bits(big);
+    *high = *low = 0;
+    for (size_t i = 0; i < 128; ++i) {
+        int bit = (i < bits) ? big_bit(big, bits - 1 - i) : 0;
+        if (i < 64) *high |= (uint64_t)bit << (63 - i);
+        else        *low  |= (uint64_t)bit << (127 - i);
+    }
+}
+
+int main(void)
+{
+    Big big;
+    printf("/* Generated by gen_pow5, do not edit */\n\n");
+    printf("#ifndef POW5_TABLE_H\n#define POW5_TABLE_H\n\n");
+    printf("#define POW5_MIN_EXPONENT %d\n", POW5_MIN_EXPONENT);
+    printf("#define POW5_MAX_EXPONENT %d\n\n", POW5_MAX_EXPONENT);
+    printf("/* 128 bit normalized approximations of 5^q, entry i holds q = POW5_MIN_EXPONENT + i as {high, low} */\n");
+    printf("static const uint64_t pow5_table[][2] = {\n");
+
+    for (int q = POW5_MIN_EXPONENT; q <= POW5_MAX_EXPONENT; ++q) {
+        uint64_t high, low;
+        if (q >= 0) {
+            big_set(&big, 1);
+            for (int i = 0; i < q; ++i)
+                big_mul_small(&big, 5);
+            big_top128(&big, &high, &low);
+        }
+        else {
+            /* z is number of bits of 5^-q */
+            big_set(&big, 1);
+            for (int i = 0; i < -q; ++i)
+                big_mul_small(&big, 5);
+            size_t z = big_bits(&big);
+
+            /* floor(2^b / 5^-q) + 1 computed by dividing by five -q times */
+            size_t b = (q >= -27) ? z + 127 : 2 * z + 128;
+            if (b / 32 + 1 > BIG_LIMBS) {
+                fprintf(stderr, "gen_pow5: BIG_LIMBS too small for q = %d\n", q);
+                return EXIT_FAILURE;
+            }
+            memset(&big, 0, sizeof(big));
+            big.limb[b / 32] = 1u << (b % 32);
+            big.size = b / 32 + 1;
+            for (int i = 0; i < -q; ++i)
+                big_div_small(&big, 5);
+            /* Add one */
+            for (size_t i = 0; ; ++i) {
+                if (i == big.size) { big.limb[big.size++] = 1; break; }
+                if (++big.limb[i] != 0) break;
+            }
+            big_top128(&big, &high, &low);
+        }
+        printf("    {0x%016llxull, 0x%016llxull}, /* %d */\n", (unsigned long long)high, (unsigned long long)low, q);
+    }
+    printf("};\n\n#endif // POW5_TABLE_H\n");
+    return EXIT_SUCCESS;
+}
@@ -33,13 +33,23 @@ SOFTWARE.
 #include <time.h>
 #include "coretypes.h"
 #include "error.h"
+#include "lexer.h"
 #include "environment.h"
 #include "function.h"
+#include "value.h"
+#include "flat_ast.h"
+#include "frontend.h"
+#include "trace.h"
 #include "interpreter.h"
 
 static jmp_buf sync_env;
 
-static ValueTagged *evaluate(AST *, EnvironmentMap *);
+/* Return statement stores its value here and jumps to function_interpret, which moves it out */
+static ValueTagged return_value = VALUE_NONE;
+/* Mark of function that is running, return jumps to it from any scope nested in function */
+static jmp_buf *return_mark = NULL;
+
+static ValueTagged evaluate(AST *, EnvironmentMap *);
 
 char cwd[FILE_PATH_SIZE];
 
@@ -49,402 +59,252 @@ static void runtime_error_mode(void)
     longjmp(sync_env, TRUE);
 }
 
-static void eval_print(ValueTagged *result) 
-{ 
-    if(result == NULL) return;
-    switch (result->type) {
-    case NUMBER_INT:
-        fprintf(stdout, "Value INT = %d\n", result->literal.integer_value);
-        break;
-    case NUMBER_FLOAT:
-        fprintf(stdout, "Value FLOAT = %lf\n", result->literal.float_value);
-        break;
-    case STRING:
-        fprintf(stdout, "Value STRING = %s\n", result->literal.char_value);
-        break;
-    case TRUE_TOKEN:
-    case FALSE_TOKEN:
-        fprintf(stdout, "Value BOOLEAN = %d\n", result->literal.boolean_value);
-        break;
-   default:
-        error("Tried to print undefined ValueTagged value in eval_print", __FILE__, __LINE__);
-        break;
-    }
-}
-
-static void free_value(ValueTagged *value)
-{   
-    if(value == NULL) return;
-    if(value->type == STRING) {
-        free(value->literal.char_value);
-    }
-    free(value);
-}
-
-extern ValueTagged *function_interpret(Token *callee, ValueTagged **args, const size_t arg_num, EnvironmentMap *env_parrent) 
+extern ValueTagged function_interpret(Token *callee, ValueTagged *args, const size_t arg_num, EnvironmentMap *env_parrent) 
 {
     if(callee == NULL) INTERNAL_ERROR("Passed null callee argument");
    
     EnvironmentMap env_child = {NULL, env_parrent, NULL, 0, 0} ;
     Environment *function = env_get_function(callee, env_parrent);
+
+    /* Body is parsed on first call, library scripts pay only for functions they use */
+    frontend_function_body(function->data.ENV_FUNCTION.definition);
+    if(error_flag) runtime_error_mode();
+
     AST **parameters = function->data.ENV_FUNCTION.definition->data.AST_FUNCT_DECL_STMT.parameters;
     AST **stmt_list = function->data.ENV_FUNCTION.definition->data.AST_FUNCT_DECL_STMT.stmt_list;
     size_t param_num = function->data.ENV_FUNCTION.definition->data.AST_FUNCT_DECL_STMT.param_num;
     size_t stmt_num =  function->data.ENV_FUNCTION.definition->data.AST_FUNCT_DECL_STMT.stmt_num;
+    size_t slot_num = function->data.ENV_FUNCTION.definition->data.AST_FUNCT_DECL_STMT.slot_num;
     
+    TRACE(TRACE_EVAL, "Call %s with %zu arguments\n", token_lexeme(callee), arg_num);
     if(arg_num != param_num) {
-        fprintf(stderr, "Error when calling %s, number of arguments given %d but expected %d\n", callee->lexeme, arg_num, param_num);
+        fprintf(stderr, "Error when calling %s, number of arguments given %d but expected %d\n", token_lexeme(callee), arg_num, param_num);
         runtime_error_mode();
     }
 
+    env_reserve_slots(&env_child, slot_num);
     for(size_t i = 0; i < param_num; ++i) {
-        Token *name = parameters[i]->data.token;
-        env_define_var(name, args[i], &env_child);
+        Token *name = parameters[i]->data.AST_IDENTIFIER.token;
+        env_define_slot(name, parameters[i]->data.AST_IDENTIFIER.slot, &args[i], &env_child);
     }
     
-    if(!setjmp(*((jmp_buf *)env_child.env_jmp_mark))) {
+    jmp_buf *caller_mark = return_mark;
+    return_mark = &env_child.env_jmp_mark;
+    if(!setjmp(*return_mark)) {
         for(size_t i = 0; i < stmt_num; ++i) {
-            free_value(evaluate(stmt_list[i], &env_child));
+            execute(stmt_list[i], &env_child);
         }
     }
+    return_mark = caller_mark;
     env_reset(&env_child);
-    return env_parrent->env_return; 
+    /* Function that ended without return gives no value */
+    ValueTagged result = return_value;
+    return_value = VALUE_NONE;
+    return result; 
 }
 
-static ValueTagged *literal_value(AST *node) 
+static ValueTagged literal_value(AST *node) 
 {
     if(node->tag != AST_LITERAL) {
         INTERNAL_ERROR("Tried to return non-literal node.");
         abort();
     }
-    ValueTagged *result = (ValueTagged *)malloc(sizeof(ValueTagged));
-    result->type = node->data.token->type;
-    if(node->data.token->type == STRING) 
-        return(result->literal.char_value = strdup(node->data.token->literal.char_value), result);
-    return (result->literal = node->data.token->literal, result);
+    /* String made by optimizer is shared, its bytes are not copied */
+    if(node->data.AST_LITERAL.string != NULL) 
+        return (ValueTagged){.type = STRING, .literal.char_value = string_copy(node->data.AST_LITERAL.string)};
+    return value_literal(node->data.token);
 }
 
-static ValueTagged *identifier_value(AST *node, EnvironmentMap *env_host) 
+static ValueTagged identifier_value(AST *node, EnvironmentMap *env_host) 
 {
     if(node->tag != AST_IDENTIFIER) {
         INTERNAL_ERROR("Tried to return non-identifier node.");
         abort();
     }
-    ValueTagged *found = env_get_var(node->data.token, env_host);
-    if(found == NULL) return NULL;
-    ValueTagged *result = (ValueTagged *)malloc(sizeof(ValueTagged));
-    result->type = found->type;
-    if(found->type == STRING) 
-        return(result->literal.char_value = strdup(found->literal.char_value), result);
-    return (result->literal = found->literal, result);
+    ValueTagged *found = env_get_slot(node->data.AST_IDENTIFIER.token, node->data.AST_IDENTIFIER.depth, node->data.AST_IDENTIFIER.slot, env_host);
+    if(found == NULL) return VALUE_NONE;
+    return value_clone(found);
 }
 
-static Value is_truth(ValueTagged *value, TokenType type) 
+static ValueTagged evaluate_unary_expression(AST *node, EnvironmentMap *env_host) 
 {
-    Value ret;
-    if(type == NUMBER_INT) 
-        return (ret.boolean_value = (value->literal.integer_value) ? TRUE : FALSE, ret);
-    if(type == NUMBER_FLOAT) 
-        return (ret.boolean_value = (value->literal.float_value) ? TRUE : FALSE, ret);
-    if(value->literal.char_value == NULL) 
-        return (ret.boolean_value = FALSE, ret);
-
-    return (ret.boolean_value = TRUE, ret);
+    ValueTagged right = evaluate(node->data.AST_UNARY_EXPR.right, env_host);
+    ValueTagged result;
+    if(!value_unary_into(node->data.AST_UNARY_EXPR.token, &right, &result)) runtime_error_mode();
+    return result;
 }
 
-static ValueTagged *evaluate_unary_expression(AST *node, EnvironmentMap *env_host) 
-{
-    ValueTagged *right = evaluate(node->data.AST_UNARY_EXPR.right, env_host);
-    ValueTagged *result = (ValueTagged *)malloc(sizeof(ValueTagged));
-    TokenType operator_type = node->data.AST_UNARY_EXPR.token->type;
-    result->type = right->type;
-
-    switch(operator_type) {
-        case SUBTRACT:
-        {
-            if(right->type == STRING) {
-                runtime_error(node->data.AST_UNARY_EXPR.right, "Can't do unary subtract operation on strings!");
-                break;
-            }
-
-            if(right->type == NUMBER_FLOAT)
-                result->literal.float_value = (-1)*right->literal.float_value;
-            if(right->type == NUMBER_INT)
-                result->literal.integer_value = (-1)*(right->literal.integer_value); 
-            if(right->type == TRUE_TOKEN || right->type == FALSE_TOKEN) {
-                result->literal.integer_value = (-1)*right->literal.boolean_value;
-                result->type = NUMBER_INT;
-            }
-            free_value(right);
-            return result;                
-        }
-        case XOR:
-        {
-            if(right->type == STRING) {
-                runtime_error(node->data.AST_UNARY_EXPR.right, "Can't do unary XOR operation on strings!");
-                break;
-            }
-            if(right->type == NUMBER_FLOAT) {
-                runtime_error(node->data.AST_UNARY_EXPR.right, "Can't do unary subtract operation on float!");
-                break;
-            }
-            if(right->type == NUMBER_INT)
-                result->literal.integer_value = ~right->literal.integer_value; 
-            if(right->type == TRUE_TOKEN || right->type == FALSE_TOKEN) {
-                result->literal.integer_value = ~right->literal.boolean_value;
-                result->type = NUMBER_INT;
-            }
-            free_value(right);
-            return result;
-        }
-        case EXCLAMATION:
-        {
-            result->literal.boolean_value = !is_truth(right, right->type).boolean_value;
-            free_value(right);
-            return (result->type = (result->literal.boolean_value) ? TRUE_TOKEN : FALSE_TOKEN, result);
-        }
-        default:
-            error("Unallowed operator on unary expression!", __FILE__, __LINE__); 
-            break;
-    }
-
-    free_value(result);
-    free_value(right);
-    runtime_error_mode();
-    abort();
-}
-
-static ValueTagged *evaluate_call_expression(AST *node, EnvironmentMap *env_host)
+static ValueTagged evaluate_call_expression(AST *node, EnvironmentMap *env_host)
 {
     Token *callee = node->data.AST_CALL_EXPR.callee->data.token;
-    ValueTagged **args = malloc(sizeof(ValueTagged *) * node->data.AST_CALL_EXPR.stmt_num);
-    ValueTagged *return_value = NULL;
+    size_t arg_num = node->data.AST_CALL_EXPR.stmt_num;
+    /* Arguments are kept on C stack, one more slot keeps array size above zero */
+    ValueTagged args[arg_num + 1];
     
-    for(size_t i = 0; i < node->data.AST_CALL_EXPR.stmt_num; ++i) {
+    for(size_t i = 0; i < arg_num; ++i) {
         args[i] = evaluate(node->data.AST_CALL_EXPR.stmt_list[i], env_host);
     }
 
-    ValueTagged *tmp_return = function_interpret(callee, args, node->data.AST_CALL_EXPR.stmt_num, env_host);
-    if(tmp_return != NULL) {
-        return_value = malloc(sizeof(ValueTagged));
-        return_value->type = tmp_return->type;
-
-        switch (tmp_return->type) {
-            case NUMBER_INT:
-                return_value->literal.integer_value = tmp_return->literal.integer_value;
-                break;
-            case NUMBER_FLOAT:
-                return_value->literal.float_value = tmp_return->literal.float_value;
-                break;
-            case STRING:
-                return_value->literal.char_value = strdup(tmp_return->literal.char_value);
-                break;
-            case TRUE_TOKEN:
-            case FALSE_TOKEN:
-                return_value->literal.boolean_value = tmp_return->literal.boolean_value;
-                break;
-            default:
-                INTERNAL_ERROR("Could not copy a value!");
-        } 
-    }
+    ValueTagged result = function_interpret(callee, args, arg_num, env_host);
 
-    for(size_t i = 0; i < node->data.AST_CALL_EXPR.stmt_num; ++i) {
-        free_value(args[i]);
+    for(size_t i = 0; i < arg_num; ++i) {
+        value_release(&args[i]);
     }
-    free(args);
-    
-    return return_value;
+    return result;
 }
 
 
-static ValueTagged *evaluate_binary_expression(AST *node, EnvironmentMap *env_host) 
+static ValueTagged evaluate_binary_expression(AST *node, EnvironmentMap *env_host) 
 {
-    ValueTagged *left = evaluate(node->data.AST_BINARY_EXPR.left, env_host);
-    ValueTagged *right = evaluate(node->data.AST_BINARY_EXPR.right, env_host);
-    ValueTagged *result = (ValueTagged *)malloc(sizeof(ValueTagged));
-    TokenType operator_type = node->data.AST_BINARY_EXPR.token->type;
-
-    if((left->type == STRING || right->type == STRING) && operator_type != ADD){
-        (left->type == STRING) ? runtime_error(node->data.AST_BINARY_EXPR.left, "Binary operator is not allowed on strings!")
-                               : runtime_error(node->data.AST_BINARY_EXPR.right, "Binary operator is not allowed on strings!");
-    }
-    else
-        switch(operator_type)
-        {
-            case EXCLAMATION_EQUEAL:
-                BINARY_COMPARISON_OPERATION(!=, left, right, result);
-                return (free(left), free(right), result);
-            case DOUBLE_EQUAL:
-                BINARY_COMPARISON_OPERATION(==, left, right, result); 
-                return (free(left), free(right), result);
-            case REDIRECTION_RIGHT_GREATER_RELATIONAL:
-                BINARY_COMPARISON_OPERATION(>, left, right, result); 
-                return (free(left), free(right), result);
-            case REDIRECTION_LEFT_LESS_RELATIONAL:
-                BINARY_COMPARISON_OPERATION(<, left, right, result);
-                return (free(left), free(right), result);
-            case GREATER_EQUAL:
-                BINARY_COMPARISON_OPERATION(>=, left, right, result);
-                return (free(left), free(right), result);
-            case LESS_EQUAL:
-                BINARY_COMPARISON_OPERATION(<=, left, right, result);
-                return (free(left), free(right), result);
-            case SUBTRACT:
-                BINARY_ADD_SUB_MULTIPLY_OPERATION(-, left, right, result);
-                return (free(left), free(right), result);          
-            case MULTIPLY:
-                BINARY_ADD_SUB_MULTIPLY_OPERATION(*, left, right, result);
-                return (free(left), free(right), result);
-            case DIVIDE:
-                BINARY_DIVIDE_OPERATION(/, left, right, result);
-                return (free(left), free(right), result);
-            case ADD:
-            {
-                if(left->type == STRING && right->type == STRING) {
-                    result->literal.char_value = strcat(left->literal.char_value, right->literal.char_value);
-                    result->type = STRING;
-                }
-                else if((left->type == STRING || right->type == STRING) && (left->type == NUMBER_INT || right->type == NUMBER_INT))
-                    TODO("Add support for STRING + INT = STRING");
-                else if((left->type == STRING || right->type == STRING) && (left->type == NUMBER_FLOAT || right->type == NUMBER_FLOAT))
-                    TODO("Add support for STRING + FLOAT = STRING");
-                else if((left->type == STRING || right->type == STRING) && (left->type == TRUE || left->type == FALSE || right->type == FALSE || right->type == TRUE))
-                    TODO("Add support for STRING + BOOLEAN = STRING");
-                else if(left->type != STRING && right->type != STRING)
-                    BINARY_ADD_SUB_MULTIPLY_OPERATION(+, left, right, result);
-                else
-                    break;
-                return (free_value(left), free_value(right), result);
-            }
-            default:
-                break;
-        }
-    free_value(left);
-    free_value(right);
-    free_value(result);
-    runtime_error_mode();
-    abort();
+    ValueTagged left = evaluate(node->data.AST_BINARY_EXPR.left, env_host);
+    ValueTagged right = evaluate(node->data.AST_BINARY_EXPR.right, env_host);
+    ValueTagged result;
+    if(!value_binary_into(node->data.AST_BINARY_EXPR.token, &left, &right, &result)) runtime_error_mode();
+    return result;
 } 
 
-static ValueTagged *evaulate_grouping_expression(AST *node, EnvironmentMap *env_host) 
+static ValueTagged evaulate_grouping_expression(AST *node, EnvironmentMap *env_host) 
 {
     return evaluate(node->data.AST_GROUPING_EXPR.left, env_host);
 }
 
-static ValueTagged *evaluate_logical_expression(AST *node, EnvironmentMap *env_host) 
+static ValueTagged evaluate_logical_expression(AST *node, EnvironmentMap *env_host) 
 {
-    ValueTagged *left = evaluate(node->data.AST_LOGICAL_EXPR.left, env_host);
+    ValueTagged left = evaluate(node->data.AST_LOGICAL_EXPR.left, env_host);
 
     if(node->data.AST_LOGICAL_EXPR.token->type == DOUBLE_OR) {
-        if(is_truth(left, left->type).boolean_value) return left;
+        if(value_is_truth(&left)) return left;
     }
     else {
-        if(!is_truth(left, left->type).boolean_value) return left;
+        if(!value_is_truth(&left)) return left;
     }
 
+    value_release(&left);
     return evaluate(node->data.AST_LOGICAL_EXPR.right, env_host);
 }
 
-static ValueTagged *evaluate_assign_expression(AST *node, EnvironmentMap *env_host) 
+static ValueTagged evaluate_assign_expression(AST *node, EnvironmentMap *env_host) 
 {
-    ValueTagged *value = evaluate(node->data.AST_ASSIGN_EXPR.expr, env_host);
+    AST *expr = node->data.AST_ASSIGN_EXPR.expr;
     Token *name = node->data.AST_ASSIGN_EXPR.token;
+    ValueTagged value;
+
+    if(expr->tag == AST_BINARY_EXPR && expr->data.AST_BINARY_EXPR.token->type == ADD) {
+        /* s = s + x: variable drops its string after both operands are evaluated, so it is appended in place */
+        ValueTagged left = evaluate(expr->data.AST_BINARY_EXPR.left, env_host);
+        ValueTagged right = evaluate(expr->data.AST_BINARY_EXPR.right, env_host);
+        if(value_can_append(&left, &right))
+            env_release_string(name, node->data.AST_ASSIGN_EXPR.depth, node->data.AST_ASSIGN_EXPR.slot, left.literal.char_value, env_host);
+        if(!value_binary_into(expr->data.AST_BINARY_EXPR.token, &left, &right, &value)) runtime_error_mode();
+    }
+    else 
+        value = evaluate(expr, env_host);
     
-    env_assign_var(name, value, env_host);
-    return (free_value(value), NULL);
+    env_assign_slot(name, node->data.AST_ASSIGN_EXPR.depth, node->data.AST_ASSIGN_EXPR.slot, &value, env_host);
+    return (value_release(&value), VALUE_NONE);
 }
 
-static ValueTagged *evaluate_if_statement(AST *node, EnvironmentMap *env_host) 
+static ValueTagged evaluate_if_statement(AST *node, EnvironmentMap *env_host) 
 {
-    ValueTagged *condition = evaluate(node->data.AST_IF_STMT.condition, env_host);
+    ValueTagged condition = evaluate(node->data.AST_IF_STMT.condition, env_host);
+    int truth = value_is_truth(&condition);
+    value_release(&condition);
 
-    if(is_truth(condition, condition->type).boolean_value) 
-        free_value(evaluate(node->data.AST_IF_STMT.true_branch, env_host)); 
+    if(truth) 
+        execute(node->data.AST_IF_STMT.true_branch, env_host); 
     else if(node->data.AST_IF_STMT.else_branch != NULL) 
-        free_value(evaluate(node->data.AST_IF_STMT.else_branch, env_host));
+        execute(node->data.AST_IF_STMT.else_branch, env_host);
 
-    return (free_value(condition), NULL);
+    return VALUE_NONE;
 }
 
-static ValueTagged *evaluate_while_statement(AST *node, EnvironmentMap *env_host) 
+static ValueTagged evaluate_while_statement(AST *node, EnvironmentMap *env_host) 
 {
-    ValueTagged *condition = evaluate(node->data.AST_WHILE_STMT.condition, env_host);
-    while(is_truth(condition, condition->type).boolean_value) {
-        free_value(evaluate(node->data.AST_WHILE_STMT.body, env_host));
-        free_value(condition);
+    ValueTagged condition = evaluate(node->data.AST_WHILE_STMT.condition, env_host);
+    while(value_is_truth(&condition)) {
+        value_release(&condition);
+        execute(node->data.AST_WHILE_STMT.body, env_host);
     	condition = evaluate(node->data.AST_WHILE_STMT.condition, env_host); 
     }
-    return (free_value(condition), NULL);
+    return (value_release(&condition), VALUE_NONE);
 }
 
-static ValueTagged *evaluate_for_statement(AST *node, EnvironmentMap *env_host) 
+static ValueTagged evaluate_for_statement(AST *node, EnvironmentMap *env_host) 
 {
     AST *init_node = node->data.AST_FOR_STMT.initializer;
     AST *cond_node = node->data.AST_FOR_STMT.condition;
+    AST *incr_node = node->data.AST_FOR_STMT.increment;
 
     EnvironmentMap env_child = {NULL, env_host, 0, 0};
-    ValueTagged *initializer = (init_node == NULL) ? NULL : evaluate(init_node, &env_child);
-    ValueTagged *condition = (cond_node == NULL) ? NULL : evaluate(cond_node, &env_child);
-    ValueTagged *increment = NULL;
+    env_reserve_slots(&env_child, node->data.AST_FOR_STMT.slot_num);
+    if(init_node != NULL) execute(init_node, &env_child);
     
-    while(is_truth(condition, condition->type).boolean_value) {
-        free_value(condition);
-        free_value(increment);
-        free_value(evaluate(node->data.AST_FOR_STMT.body, &env_child));
-        increment = evaluate(node->data.AST_FOR_STMT.increment, &env_child);
-	    condition = evaluate(node->data.AST_FOR_STMT.condition, &env_child); 
+    /* Missing condition loops forever, like in bytecode compiler */
+    while(TRUE) {
+        if(cond_node != NULL) {
+            ValueTagged condition = evaluate(cond_node, &env_child);
+            int truth = value_is_truth(&condition);
+            value_release(&condition);
+            if(!truth) break;
+        }
+        execute(node->data.AST_FOR_STMT.body, &env_child);
+        if(incr_node != NULL) execute(incr_node, &env_child);
     }
     
     env_reset(&env_child);
-    free_value(initializer);
-    free_value(condition);
-    free_value(increment);
-    return NULL;
+    return VALUE_NONE;
 }
 
-static ValueTagged *evaluate_block_statement(AST *node, EnvironmentMap *env_parrent, EnvironmentMap *env_host) 
+static ValueTagged evaluate_block_statement(AST *node, EnvironmentMap *env_parrent, EnvironmentMap *env_host) 
 {
     env_host->env_enclosing = env_parrent;
+    env_reserve_slots(env_host, node->data.AST_BLOCK_STMT.slot_num);
 
     for(size_t i = 0; i < node->data.AST_BLOCK_STMT.stmt_num; ++i)
     {
-        free_value(evaluate(node->data.AST_BLOCK_STMT.stmt_list[i], env_host));
+        execute(node->data.AST_BLOCK_STMT.stmt_list[i], env_host);
     }
     /* Free memory of Local Environment */
     env_reset(env_host);
-    return NULL;
+    return VALUE_NONE;
 }
 
-static ValueTagged *evaluate_variable_statement(AST *node, EnvironmentMap *env_host) 
+static ValueTagged evaluate_variable_statement(AST *node, EnvironmentMap *env_host) 
 {   
     Token *name = node->data.AST_VAR_DECL_STMT.name;
-    ValueTagged *value = NULL;
+    ValueTagged value = VALUE_NONE;
     if(node->data.AST_VAR_DECL_STMT.init != NULL) 
         value = evaluate(node->data.AST_VAR_DECL_STMT.init, env_host);
 
-    env_define_var(name, value, env_host);
-    return (free_value(value), NULL);
+    env_define_slot(name, node->data.AST_VAR_DECL_STMT.slot, &value, env_host);
+    return (value_release(&value), VALUE_NONE);
 }
 
-static ValueTagged *evaluate_function_declaration_statement(AST *node, EnvironmentMap *env_host)
+static ValueTagged evaluate_function_declaration_statement(AST *node, EnvironmentMap *env_host)
 {
     Token *name = node->data.AST_FUNCT_DECL_STMT.name;
     AST *function_definition = node;
-    env_define_function(name, env_host, function_definition);
-    return NULL;
+    env_define_function(name, env_host, function_definition, NULL, FLAT_NONE, NULL, NULL);
+    return VALUE_NONE;
 }
 
-static ValueTagged *evaluate_return_statement(AST *node, EnvironmentMap *env_host)
+static ValueTagged evaluate_return_statement(AST *node, EnvironmentMap *env_host)
 {
-    if(env_host->env_enclosing == NULL) { TODO("Fix so it works in other statemetnts"); runtime_error(node, "Can't return from global"); }
+    if(return_mark == NULL) {
+        fprintf(stderr, "Runtime error: Can't return outside of function!\n");
+        runtime_error_mode();
+    }
     if(node->data.AST_RETURN_STMT.expr == NULL) 
-        env_host->env_enclosing->env_return = NULL;
+        return_value = VALUE_NONE;
     else
-        env_host->env_enclosing->env_return = evaluate(node->data.AST_RETURN_STMT.expr, env_host->env_enclosing);
-    longjmp(env_host->env_jmp_mark, TRUE);
+        return_value = evaluate(node->data.AST_RETURN_STMT.expr, env_host);
+    /* Scopes nested in function are left by the jump, so they are freed here */
+    for(EnvironmentMap *env = env_host; &env->env_jmp_mark != return_mark; env = env->env_enclosing) 
+        env_reset(env);
+    longjmp(*return_mark, TRUE);
 }
 
-static ValueTagged *evaluate_time_statement(AST *node, EnvironmentMap *env_host) 
+extern void builtin_time(void) 
 {   
     time_t rt;
     struct tm *time_info;
@@ -454,64 +314,29 @@ static ValueTagged *evaluate_time_statement(AST *node, EnvironmentMap *env_host)
 
     fprintf(stdout, "Current Time is: \n");
     fprintf(stdout, "%s", asctime(time_info));
-
-    return NULL;
 }
 
-static ValueTagged *evaluate_clear_statement(AST *node, EnvironmentMap *env_host)
+extern void builtin_clear(void)
 {
     fprintf(stdout, "\033[H\033[J");
     fflush(stdout);
-    return NULL;
 }
 
-static ValueTagged *evaluate_cd_statement(AST *node, EnvironmentMap *env_host)
+extern void builtin_cd(const char *path)
 {
-    if(node->data.AST_CD_STMT.expr == NULL) {
-        chdir(getenv("HOME"));
-        getcwd(cwd, FILE_PATH_SIZE);
-        return NULL;
-    } 
-    chdir(node->data.AST_CD_STMT.expr->data.token->lexeme);
+    chdir((path == NULL) ? getenv("HOME") : path);
     getcwd(cwd, FILE_PATH_SIZE);
-    return NULL;
 }
 
-static ValueTagged *evaluate_run_statement(AST *node, EnvironmentMap *env_host)
+extern void builtin_run(Token *program_token, char **argv)
 {
-    if(node->data.AST_RUN_STMT.program_name == NULL) {
-        fprintf(stdout, "Runtime warning: run command requires a program name to run!\n");
-        runtime_error_mode();
-    }
-
-    Token *program_token = node->data.AST_RUN_STMT.program_name;
-    AST **args_list = node->data.AST_RUN_STMT.args_list;
-    size_t arg_num = node->data.AST_RUN_STMT.arg_num;
-    char **argv = malloc(sizeof(char *) * (arg_num + 2));
-    
-    argv[0] = strdup(program_token->lexeme);
-    for(size_t i = 0; i < arg_num; ++i) {
-        ValueTagged *arg = evaluate(args_list[i], env_host);
-        switch(arg->type) {
-            case STRING:
-                argv[i+1] = strdup(arg->literal.char_value);
-                break;
-            case TRUE_TOKEN:
-            case FALSE_TOKEN:
-            case NUMBER_INT:
-            case NUMBER_FLOAT:
-                TODO("Finish interpreting arguments!");
-        }
-        free_value(arg);
-        argv[i+2] = NULL;
-    }
     pid_t pid = fork();
 
     if(pid < 0) {
         INTERNAL_ERROR("Failed to fork a process!");
         exit(EXIT_FAILURE);
     } else if (pid == 0) {
-        if(execv(program_token->lexeme, argv) < 0) {
+        if(execv(token_lexeme(program_token), argv) < 0) {
             if(errno == EACCES) fprintf(stderr, "%s\n", strerror(errno));
             if(errno == ENOENT) {
                 char *env_path = NULL;
@@ -524,7 +349,7 @@ static ValueTagged *evaluate_run_statement(AST *node, EnvironmentMap *env_host)
                         char program_path[FILE_PATH_SIZE] = {0};
                         strcat(program_path, &env_path[j]);
                         strcat(program_path, "/");
-                        strcat(program_path, program_token->lexeme);
+                        strcat(program_path, token_lexeme(program_token));
                         execv(program_path, argv);
                         env_path[i] = ':';
                         j = i+1;
@@ -542,50 +367,77 @@ static ValueTagged *evaluate_run_statement(AST *node, EnvironmentMap *env_host)
             exit(EXIT_FAILURE);
         }
         if(!WIFEXITED(stat)) {
-            fprintf(stdout, "Program %s did not exit succesfully\n", program_token->lexeme, WEXITSTATUS(stat));
+            fprintf(stdout, "Program %s did not exit succesfully\n", token_lexeme(program_token), WEXITSTATUS(stat));
         }
     }
+}
+
+static ValueTagged evaluate_time_statement(AST *node, EnvironmentMap *env_host) 
+{   
+    builtin_time();
+    return VALUE_NONE;
+}
+
+static ValueTagged evaluate_clear_statement(AST *node, EnvironmentMap *env_host)
+{
+    builtin_clear();
+    return VALUE_NONE;
+}
+
+static ValueTagged evaluate_cd_statement(AST *node, EnvironmentMap *env_host)
+{
+    if(node->data.AST_CD_STMT.expr == NULL) 
+        builtin_cd(NULL);
+    else
+        builtin_cd(token_lexeme(node->data.AST_CD_STMT.expr->data.token));
+    return VALUE_NONE;
+}
+
+static ValueTagged evaluate_run_statement(AST *node, EnvironmentMap *env_host)
+{
+    if(node->data.AST_RUN_STMT.program_name == NULL) {
+        fprintf(stdout, "Runtime warning: run command requires a program name to run!\n");
+        runtime_error_mode();
+    }
+
+    Token *program_token = node->data.AST_RUN_STMT.program_name;
+    AST **args_list = node->data.AST_RUN_STMT.args_list;
+    size_t arg_num = node->data.AST_RUN_STMT.arg_num;
+    char **argv = malloc(sizeof(char *) * (arg_num + 2));
+    
+    argv[0] = strdup(token_lexeme(program_token));
+    argv[1] = NULL;
+    for(size_t i = 0; i < arg_num; ++i) {
+        ValueTagged arg = evaluate(args_list[i], env_host);
+        argv[i+1] = value_string(&arg);
+        value_release(&arg);
+        if(error_flag || argv[i+1] == NULL) {
+            /* Error of the argument itself was already reported */
+            if(!error_flag) operator_error(program_token, "Arguments of run must be strings, numbers or booleans!");
+            for(size_t j = 0; j <= i + 1; ++j) free(argv[j]);
+            free(argv);
+            runtime_error_mode();
+        }
+        argv[i+2] = NULL;
+    }
+    builtin_run(program_token, argv);
     
     for(size_t i = 0; i < arg_num + 1; ++i) {
         free(argv[i]);
     }
     free(argv);
-    return NULL;
+    return VALUE_NONE;
 }
 
-static ValueTagged *echo(ValueTagged *result) 
+static ValueTagged echo(ValueTagged *result) 
 {   
-    if(error_flag) return NULL;
-    switch (result->type) {
-        case NUMBER_INT:
-            fprintf(stdout, "%d", result->literal.integer_value);
-            break;
-        case NUMBER_FLOAT:
-            fprintf(stdout, "%lf", result->literal.float_value);
-            break;
-        case STRING:
-            for(size_t i = 0; result->literal.char_value[i] != '\0'; ++i) {
-                if(result->literal.char_value[i] == '\\' && result->literal.char_value[i+1] == 'n') {
-                    fprintf(stdout, "\n");
-                    i++;
-                }
-                else
-                    fprintf(stdout, "%c", result->literal.char_value[i]);
-            }
-            break;
-        case TRUE_TOKEN:
-        case FALSE_TOKEN:
-            fprintf(stdout, "%d", result->literal.boolean_value);
-            break;
-       default:
-            error("Tried to echo undefined undefined ValueTagged value in eval_print", __FILE__, __LINE__);
-            break;
-    }
-    return (free_value(result), NULL);
+    if(!error_flag) value_echo(result);
+    return (value_release(result), VALUE_NONE);
 }
 
-static ValueTagged *evaluate(AST *node, EnvironmentMap *env_host) 
+static ValueTagged evaluate(AST *node, EnvironmentMap *env_host) 
 {  
+    TRACE(TRACE_EVAL, "Evaluate %s\n", trace_ast_name(node->tag));
     switch (node->tag) {
     case AST_LITERAL:
         return literal_value(node);
@@ -615,8 +467,8 @@ static ValueTagged *evaluate(AST *node, EnvironmentMap *env_host)
     case AST_FOR_STMT:
         return evaluate_for_statement(node, env_host);
     case AST_ECHO_STMT:
-        ValueTagged *result = evaluate(node->data.AST_ECHO_STMT.expr, env_host);
-        return ((ValueTagged *) echo(result));
+        ValueTagged result = evaluate(node->data.AST_ECHO_STMT.expr, env_host);
+        return echo(&result);
     case AST_VAR_DECL_STMT:
         return evaluate_variable_statement(node, env_host);
     case AST_FUNCT_DECL_STMT:
@@ -635,17 +487,23 @@ static ValueTagged *evaluate(AST *node, EnvironmentMap *env_host)
         break;
     }
     error("Tried to evaluate undefined AST node type.", __FILE__, __LINE__);
-    return NULL;
+    return VALUE_NONE;
+}
+
+static void execute(AST *node, EnvironmentMap *env_host)
+{
+    ValueTagged value = evaluate(node, env_host);
+    value_release(&value);
 }
 
 extern void interpret(AST *expr) 
 {
-    ValueTagged *value = NULL;
+    /* Runtime error may have jumped out of function before its mark was restored */
+    return_mark = NULL;
     if(setjmp(sync_env));
     else {
-        fprintf(stdout, "Setjmp for interpreter!\n");
-        value = evaluate(expr, &env_global);
+        TRACE(TRACE_EVAL, "Setjmp for interpreter!\n");
+        execute(expr, &env_global);
     }
-    free_value(value);
 }
 
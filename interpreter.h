@@ -29,81 +29,93 @@ SOFTWARE.
 *Function that deals with runtime error by jumping to next stmt */
 static void runtime_error_mode(void);
 
-/*@Function: eval_print
-*Function that is used to print the result of evaluation */
-static void eval_print(ValueTagged *);
-
-/*@Function: is_truth
-*Helper function that returns TRUE, FALSE */
-static Value is_truth(ValueTagged *, TokenType);
-
 /*@Function: literal_value
 *Function that returns value of AST node */
-static ValueTagged *literal_value(AST *);
+static ValueTagged literal_value(AST *);
 
 /*@Function: identifier_value
 *Function that returns value of identifier found in Environment*/
-static ValueTagged *identifier_value(AST *, EnvironmentMap *);
+static ValueTagged identifier_value(AST *, EnvironmentMap *);
 
 /*@Function: evaluate_unary_expression
 *Function that evaluates unary expression */
-static ValueTagged *evaluate_unary_expression(AST *, EnvironmentMap *);
+static ValueTagged evaluate_unary_expression(AST *, EnvironmentMap *);
 
 /*@Function: evaluate_binary expression
 *Function that evaluates binary expression */
-static ValueTagged *evaluate_binary_expression(AST *, EnvironmentMap *);
+static ValueTagged evaluate_binary_expression(AST *, EnvironmentMap *);
 
 /*@Function: evaluate_grouping_expression
 *Function that evaluates grouping expression */
-static ValueTagged *evaulate_grouping_expression(AST *, EnvironmentMap *);
+static ValueTagged evaulate_grouping_expression(AST *, EnvironmentMap *);
 
 /*@Function: evaluate_assign_expression 
 *Function that evaluates assign expression */
-static ValueTagged *evaluate_assign_expression(AST *, EnvironmentMap *);
+static ValueTagged evaluate_assign_expression(AST *, EnvironmentMap *);
 
 /*@Function: evaluate_block_statement
 *Function that evaluates block statement */
-static ValueTagged *evaluate_block_statement(AST *, EnvironmentMap *, EnvironmentMap *); 
+static ValueTagged evaluate_block_statement(AST *, EnvironmentMap *, EnvironmentMap *); 
 
 /*@Function: evaluate_if_statement
 *Function that evaluates if statement */
-static ValueTagged *evaluate_if_statement(AST *, EnvironmentMap *); 
+static ValueTagged evaluate_if_statement(AST *, EnvironmentMap *); 
 
 /*@Function: evaluate_while_statement
 *Function that evaluates while statement */
-static ValueTagged *evaluate_while_statement(AST *, EnvironmentMap *); 
+static ValueTagged evaluate_while_statement(AST *, EnvironmentMap *); 
 
 /*@Function: evaluate_variable_statement
 *Function that evaluates variable statement */
-static ValueTagged *evaluate_variable_statement(AST *, EnvironmentMap *); 
+static ValueTagged evaluate_variable_statement(AST *, EnvironmentMap *); 
 
 /*@Function: evaluate_return_statemente
 *Function that evaluates return statement */
-static ValueTagged *evaluate_return_statement(AST *, EnvironmentMap *);
+static ValueTagged evaluate_return_statement(AST *, EnvironmentMap *);
 
 /*@Function: evaluate_time_statement
 *Function that evaluates time statement*/
-static ValueTagged *evaluate_time_statement(AST *, EnvironmentMap *); 
+static ValueTagged evaluate_time_statement(AST *, EnvironmentMap *); 
 
 /*@Function: evaluate_clear_statement
 *Function that evaluates clear statement*/
-static ValueTagged *evaluate_clear_statement(AST *, EnvironmentMap *); 
+static ValueTagged evaluate_clear_statement(AST *, EnvironmentMap *); 
 
 /*@Function: evaluate_cd_statement 
 *Function that evaluate cd statement*/
-static ValueTagged *evaluate_cd_statement(AST *, EnvironmentMap *); 
+static ValueTagged evaluate_cd_statement(AST *, EnvironmentMap *); 
 
 /*@Function: evaluate_run_statement 
 *Function that evaluate run statement*/
-static ValueTagged *evaluate_run_statement(AST *, EnvironmentMap *); 
+static ValueTagged evaluate_run_statement(AST *, EnvironmentMap *); 
 
 /*@Function: echo
 *Function that evaluates result of AST echo*/
-static ValueTagged * echo(ValueTagged *);
+static ValueTagged echo(ValueTagged *);
 
 /*@Function: evaluate
-*Function that calls evaluation of specific node type */
-static ValueTagged *evaluate(AST *, EnvironmentMap *);
+*Function that calls evaluation of specific node type, values are returned by value so that numbers are never allocated */
+static ValueTagged evaluate(AST *, EnvironmentMap *);
+
+/*@Function: execute
+*Function that evaluates statement and frees its value */
+static void execute(AST *, EnvironmentMap *);
+
+/*@Function: builtin_time
+*Function that prints current time, shared by tree and flat interpreter */
+extern void builtin_time(void);
+
+/*@Function: builtin_clear
+*Function that clears terminal, shared by tree and flat interpreter */
+extern void builtin_clear(void);
+
+/*@Function: builtin_cd
+*Function that changes working directory, NULL path changes it to HOME */
+extern void builtin_cd(const char *);
+
+/*@Function: builtin_run
+*Function that runs program with NULL terminated argv and waits for it, PATH is searched if program is not found */
+extern void builtin_run(Token *, char **);
 
 /*@Function: interpret
 *Function that interprets expressions*/
@@ -26,57 +26,60 @@ SOFTWARE.
 #include <stdlib.h>
 #include <string.h>
 #include <setjmp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #include "coretypes.h"
 #include "lexer.h"
+#include "keyword_hash.h"
+#include "symbol.h"
+#include "numeric.h"
 #include "error.h"
+#include "trace.h"
 
-/* Hash Map used for reserved words */
-static const ReservedWordMapType reserved_word_map[] = {
-    {"run",     RUN},
-    {"exec",    EXEC},
-    {"clear",   CLEAR},
-    {"cd",      CD},
-    {"time",    TIME},
-    {"if",      IF},
-    {"else",    ELSE},
-    {"false",   FALSE_TOKEN},
-    {"true",    TRUE_TOKEN},
-    {"for",     FOR},
-    {"while",   WHILE},
-    {"null",    NULL_TOKEN},
-    {"enum",    ENUM_TOKEN},
-    {"var",     VAR},
-    {"echo",    ECHO},
-    {"funct",   FUNCT},
-    {"class",   CLASS},
-    {"struct",  STRUCT},
-    {"return",  RETURN},
-    {"eof",     EOF_TOKEN}
-};
+/* Base of the Source that source tokens point into */
+static const char *source_base = NULL;
 
-static int compare_token(const char *token, const char *value) 
+static TokenType lookup_reserved_word(const char *span, const size_t length)
 {
-    if (strlen(token) != strlen(value))
-        return EXIT_FAILURE;
-    for (size_t i = 0; token[i] != 0; ++i) {
-        if (token[i] != value[i])
-            return EXIT_FAILURE;
-    }
-    return EXIT_SUCCESS;
-}       
+    /* Check length first, then hash into the table generated from tokens.def */
+    if (length < KEYWORD_MIN_LENGTH || length > KEYWORD_MAX_LENGTH)
+        return IDENTIFIER;
+
+    const ReservedWordMapType *entry = &keyword_hash_table[KEYWORD_HASH(span, length)];
+    if (entry->length != length || memcmp(span, entry->reserved_word, length))
+        return IDENTIFIER;
+    return entry->type;
+}
+
+static size_t token_capacity(const size_t number_of_tokens)
+{
+    /* Arrays grow geometrically, capacity is the next power of two */
+    size_t capacity = 64;
+    while (capacity < number_of_tokens)
+        capacity *= 2;
+    return capacity;
+}
 
 static char **add_token(char **tokens, size_t *token_cnt, char *token)
 {
-    char **new_tokens = realloc(tokens, (*token_cnt + 1) * sizeof(char *));
-    /* Deallocate memory if realloc fails */
-    if (!new_tokens) {
-        INTERNAL_ERROR("Failed to reallocate memory during add_token!");
-        for (size_t j = 0; j < *token_cnt; ++j)
-            free(tokens[j]);
-        free(tokens);
-        exit(EXIT_FAILURE);
+    /* Reallocate only when token count reaches capacity */
+    if (*token_cnt == 0 || *token_cnt == token_capacity(*token_cnt)) {
+        char **new_tokens = realloc(tokens, token_capacity(*token_cnt + 1) * sizeof(char *));
+        /* Deallocate memory if realloc fails */
+        if (!new_tokens) {
+            INTERNAL_ERROR("Failed to reallocate memory during add_token!");
+            for (size_t j = 0; j < *token_cnt; ++j)
+                free(tokens[j]);
+            free(tokens);
+            exit(EXIT_FAILURE);
+        }
+        tokens = new_tokens;
     }
-    tokens = new_tokens;
 
     /* Copy token into an array of tokens */
     tokens[*token_cnt] = strdup(token);
@@ -89,66 +92,438 @@ static char **add_token(char **tokens, size_t *token_cnt, char *token)
     return tokens;
 }
 
+/* Character class of every byte, bytes that are not listed are not allowed in Cash */
+static const unsigned char character_class[256] = {
+    [0 ... 255] = UNUSED_CHARACTERS,
+
+    /* Letter, number (float or int) or underscore */
+    ['0' ... '9'] = OTHER, ['a' ... 'z'] = OTHER, ['A' ... 'Z'] = OTHER,
+    ['_'] = OTHER,
+
+    /* Special characters come from tokens.def */
+#define SPECIAL_TOKEN(type, character, flags) [character] = ((flags) & TOKEN_IN_WORD) ? OTHER : SPECIAL,
+#include "tokens.def"
+
+    ['"'] = QUOTES,
+    [' '] = SPACE, ['\t'] = SPACE, ['\r'] = SPACE,
+    ['\n'] = NEW_LINE
+};
+
+/* Compact index of single character tokens, row and column of operator table */
+enum special_index_e
+{
+    SPECIAL_INDEX_NONE,
+#define SPECIAL_TOKEN(type, character, flags) SPECIAL_INDEX_##type,
+#include "tokens.def"
+    SPECIAL_INDEX_COUNT
+};
+
+static const unsigned char special_index[256] = {
+#define SPECIAL_TOKEN(type, character, flags) [character] = SPECIAL_INDEX_##type,
+#include "tokens.def"
+};
+
+/* Two character operators from tokens.def, 0 if pair of characters is not an operator */
+static const TokenType operator_table[SPECIAL_INDEX_COUNT][SPECIAL_INDEX_COUNT] = {
+#define OPERATOR_TOKEN(type, first, second, flags) [SPECIAL_INDEX_##first][SPECIAL_INDEX_##second] = type,
+#include "tokens.def"
+};
+
 static int is_digit(const char c) 
 {
     return c >= '0' && c <= '9';
 }
 
-static int is_letter(char c) 
+static TokenType classify_operator(const char first, const char second)
 {
-    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    return operator_table[special_index[(unsigned char)first]][special_index[(unsigned char)second]];
 }
 
 static CharacterType type_of_character(char c) 
 {
-    /* Determine if letter, number (float or int) or underscore */
-    if(is_digit(c) || is_letter(c) || c == '_' || c =='.')
-        return OTHER;
-
-    /* Determine if Special characters */
-    switch (c) {
-            case '~':  case '|': case ';': case '&': case '#': 
-            case '\'': case '(': case ')': case '{': case '}':
-            case '*':  case '+': case '-': case '%': case '/':
-            case '!':  case '=': case '<': case '>': case '?':
-            case ',':
-                return SPECIAL;
-            case '"':  
-                return QUOTES;
-            case ' ':  case '\t': case '\r':  
-                return SPACE;
-            case '\n':  
-                return NEW_LINE;
-            default:    
-                return UNUSED_CHARACTERS;
+    return (CharacterType)character_class[(unsigned char)c];
+}
+
+static const char *scan_word_scalar(const char *cursor, const char *end)
+{
+    while (cursor < end && character_class[(unsigned char)*cursor] == OTHER)
+        cursor++;
+    return cursor;
+}
+
+static const char *scan_string_scalar(const char *cursor, const char *end)
+{
+    while (cursor < end && *cursor != '"' && *cursor != '\n')
+        cursor++;
+    return cursor;
+}
+
+static int is_escaped(const char *cmd, const size_t begin, const size_t position)
+{
+    size_t backslashes = 0;
+    while (position - backslashes > begin && cmd[position - backslashes - 1] == '\\')
+        backslashes++;
+    return backslashes & 1;
+}
+
+static int hex_digit(const char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+        return (c | 0x20) - 'a' + 10;
+    return -1;
+}
+
+static size_t string_unescape(const char *raw, const size_t length, char *out)
+{
+    size_t size = 0;
+
+    for (size_t i = 0; i < length; ++i) {
+        if (raw[i] != '\\' || i + 1 == length) {
+            out[size++] = raw[i];
+            continue;
+        }
+        switch (raw[i + 1]) {
+        case 'n':
+            out[size++] = '\n';
+            break;
+        case 't':
+            out[size++] = '\t';
+            break;
+        case '"':
+        case '\\':
+            out[size++] = raw[i + 1];
+            break;
+        case 'x':
+        {
+            int high = (i + 3 < length) ? hex_digit(raw[i + 2]) : -1;
+            int low = (high >= 0) ? hex_digit(raw[i + 3]) : -1;
+            /* Strings are null terminated, so \x00 can not be stored and stays as written */
+            if (low < 0 || (high | low) == 0) {
+                out[size++] = raw[i];
+                continue;
+            }
+            out[size++] = (char)(high << 4 | low);
+            i += 2;
+            break;
+        }
+        default:
+            out[size++] = raw[i];
+            continue;
+        }
+        i++;
+    }
+    out[size] = '\0';
+    return size;
+}
+
+static size_t utf8_sequence(const unsigned char *cursor, const unsigned char *end)
+{
+    size_t length = 0;
+
+    if (cursor[0] < 0x80)
+        return 1;
+    if (cursor[0] >= 0xC2 && cursor[0] <= 0xDF)
+        length = 2;
+    else if (cursor[0] >= 0xE0 && cursor[0] <= 0xEF)
+        length = 3;
+    else if (cursor[0] >= 0xF0 && cursor[0] <= 0xF4)
+        length = 4;
+    if (length == 0 || (size_t)(end - cursor) < length)
+        return 0;
+    for (size_t i = 1; i < length; ++i)
+        if ((cursor[i] & 0xC0) != 0x80)
+            return 0;
+
+    /* Range of second byte rules out overlong forms, surrogates and code points above U+10FFFF */
+    if ((cursor[0] == 0xE0 && cursor[1] < 0xA0) || (cursor[0] == 0xED && cursor[1] > 0x9F) ||
+        (cursor[0] == 0xF0 && cursor[1] < 0x90) || (cursor[0] == 0xF4 && cursor[1] > 0x8F))
+        return 0;
+    return length;
+}
+
+static const char *utf8_validate_scalar(const char *cursor, const char *end)
+{
+    while (cursor < end) {
+        uint64_t block;
+        if (end - cursor >= 8 && (memcpy(&block, cursor, 8), !(block & 0x8080808080808080ULL))) {
+            cursor += 8;
+            continue;
+        }
+        size_t length = utf8_sequence((const unsigned char *)cursor, (const unsigned char *)end);
+        if (length == 0)
+            return cursor;
+        cursor += length;
+    }
+    return cursor;
+}
+
+static const char *utf8_restart(const char *begin, const char *position, const char *end)
+{
+    /* Bytes before position are valid, so going back over continuations finds the lead of a crossing sequence */
+    for (int back = 0; back < 3 && position > begin && ((unsigned char)position[-1] & 0xC0) == 0x80; ++back)
+        position--;
+    if (position > begin && (unsigned char)position[-1] >= 0xC0)
+        position--;
+    return utf8_validate_scalar(position, end);
+}
+
+static const char *scan_space_scalar(const char *cursor, const char *end)
+{
+    while (cursor < end && character_class[(unsigned char)*cursor] == SPACE)
+        cursor++;
+    return cursor;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/* Vector scanners compare whole blocks and stop at the first byte that ends the run,
+ * bytes >= 0x80 are negative in signed compares so they never match a range */
+static const char *scan_word_sse2(const char *cursor, const char *end)
+{
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    for (; cursor + 16 <= end; cursor += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)cursor);
+        __m128i lower = _mm_or_si128(block, case_bit);
+        __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+        __m128i other = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('_')), _mm_cmpeq_epi8(block, _mm_set1_epi8('.')));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), other)) ^ 0xFFFFu;
+        if (mask)
+            return cursor + __builtin_ctz(mask);
+    }
+    return scan_word_scalar(cursor, end);
+}
+
+static const char *scan_string_sse2(const char *cursor, const char *end)
+{
+    for (; cursor + 16 <= end; cursor += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)cursor);
+        __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('"')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\n')));
+        unsigned mask = (unsigned)_mm_movemask_epi8(stop);
+        if (mask)
+            return cursor + __builtin_ctz(mask);
+    }
+    return scan_string_scalar(cursor, end);
+}
+
+static const char *scan_space_sse2(const char *cursor, const char *end)
+{
+    for (; cursor + 16 <= end; cursor += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)cursor);
+        __m128i space = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')),
+                        _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\r'))));
+        unsigned mask = (unsigned)_mm_movemask_epi8(space) ^ 0xFFFFu;
+        if (mask)
+            return cursor + __builtin_ctz(mask);
+    }
+    return scan_space_scalar(cursor, end);
+}
+
+static const char *utf8_validate_sse2(const char *cursor, const char *end)
+{
+    while (cursor + 16 <= end) {
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)cursor));
+        if (!mask) {
+            cursor += 16;
+            continue;
+        }
+        /* Run of multibyte sequences is decoded until ASCII comes back */
+        cursor += __builtin_ctz(mask);
+        while (cursor < end && (unsigned char)*cursor >= 0x80) {
+            size_t length = utf8_sequence((const unsigned char *)cursor, (const unsigned char *)end);
+            if (length == 0)
+                return cursor;
+            cursor += length;
+        }
+    }
+    return utf8_validate_scalar(cursor, end);
+}
+
+__attribute__((target("avx2")))
+static const char *scan_word_avx2(const char *cursor, const char *end)
+{
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    for (; cursor + 32 <= end; cursor += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)cursor);
+        __m256i lower = _mm256_or_si256(block, case_bit);
+        __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), block));
+        __m256i other = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('.')));
+        unsigned mask = ~(unsigned)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(letter, digit), other));
+        if (mask)
+            return cursor + __builtin_ctz(mask);
+    }
+    return scan_word_sse2(cursor, end);
+}
+
+__attribute__((target("avx2")))
+static const char *scan_string_avx2(const char *cursor, const char *end)
+{
+    for (; cursor + 32 <= end; cursor += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)cursor);
+        __m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n')));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(stop);
+        if (mask)
+            return cursor + __builtin_ctz(mask);
+    }
+    return scan_string_sse2(cursor, end);
+}
+
+__attribute__((target("avx2")))
+static const char *scan_space_avx2(const char *cursor, const char *end)
+{
+    for (; cursor + 32 <= end; cursor += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)cursor);
+        __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r'))));
+        unsigned mask = ~(unsigned)_mm256_movemask_epi8(space);
+        if (mask)
+            return cursor + __builtin_ctz(mask);
+    }
+    return scan_space_sse2(cursor, end);
+}
+
+/* Lookup validator of Keiser and Lemire, every byte is checked against the three bytes before it */
+__attribute__((target("avx2")))
+static const char *utf8_validate_avx2(const char *begin, const char *end)
+{
+    static const unsigned char byte_1_high[16] = {
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+        UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+        UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+        UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4
+    };
+    static const unsigned char byte_1_low[16] = {
+        UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+        UTF8_CARRY | UTF8_OVERLONG_2,
+        UTF8_CARRY, UTF8_CARRY,
+        UTF8_CARRY | UTF8_TOO_LARGE,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000, UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000, UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000, UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000, UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000, UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000
+    };
+    static const unsigned char byte_2_high[16] = {
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+    };
+    const __m256i table_1_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)byte_1_high));
+    const __m256i table_1_low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)byte_1_low));
+    const __m256i table_2_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)byte_2_high));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    /* Last three bytes of block may not start a sequence that needs more bytes than are left */
+    const __m256i max_value = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                               -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, (char)0xEF, (char)0xDF, (char)0xBF);
+    __m256i previous = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    unsigned char tail[32];
+    const char *cursor = begin;
+
+    for (; cursor < end; cursor += 32) {
+        /* Runs of ASCII are skipped four blocks at a time while no sequence is open */
+        while (cursor + 128 <= end && _mm256_testz_si256(incomplete, incomplete)) {
+            __m256i last = _mm256_loadu_si256((const __m256i *)(cursor + 96));
+            __m256i any = _mm256_or_si256(_mm256_or_si256(_mm256_loadu_si256((const __m256i *)cursor), _mm256_loadu_si256((const __m256i *)(cursor + 32))),
+                                          _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(cursor + 64)), last));
+            if (_mm256_movemask_epi8(any))
+                break;
+            previous = last;
+            cursor += 128;
+        }
+
+        __m256i block;
+        if (cursor + 32 <= end)
+            block = _mm256_loadu_si256((const __m256i *)cursor);
+        else {
+            /* Zero padding is ASCII, sequence cut by the end of input is reported as too short */
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, cursor, end - cursor);
+            block = _mm256_loadu_si256((const __m256i *)tail);
+        }
+
+        if (!_mm256_movemask_epi8(block)) {
+            /* ASCII block is valid unless previous block ended inside a sequence */
+            if (!_mm256_testz_si256(incomplete, incomplete))
+                return utf8_restart(begin, cursor, end);
+            previous = block;
+            continue;
+        }
+
+        __m256i carried = _mm256_permute2x128_si256(previous, block, 0x21);
+        __m256i prev1 = _mm256_alignr_epi8(block, carried, 15);
+        __m256i prev2 = _mm256_alignr_epi8(block, carried, 14);
+        __m256i prev3 = _mm256_alignr_epi8(block, carried, 13);
+        __m256i special = _mm256_and_si256(_mm256_and_si256(
+            _mm256_shuffle_epi8(table_1_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+            _mm256_shuffle_epi8(table_1_low, _mm256_and_si256(prev1, nibble))),
+            _mm256_shuffle_epi8(table_2_high, _mm256_and_si256(_mm256_srli_epi16(block, 4), nibble)));
+        /* Third and fourth bytes of sequence must be continuations, those are the only allowed TWO_CONTS */
+        __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+        __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+        __m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+        __m256i error = _mm256_xor_si256(must_continue, special);
+        if (!_mm256_testz_si256(error, error))
+            return utf8_restart(begin, cursor, end);
+
+        incomplete = _mm256_subs_epu8(block, max_value);
+        previous = block;
+    }
+
+    if (!_mm256_testz_si256(incomplete, incomplete))
+        return utf8_restart(begin, end, end);
+    return end;
+}
+#endif
+
+/* Scanners used by the source lexer, selected by scan_dispatch */
+static const char *(*scan_word)(const char *, const char *) = scan_word_scalar;
+static const char *(*scan_string)(const char *, const char *) = scan_string_scalar;
+static const char *(*scan_space)(const char *, const char *) = scan_space_scalar;
+static const char *(*utf8_validate)(const char *, const char *) = utf8_validate_scalar;
+
+static void scan_dispatch(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        scan_word = scan_word_avx2;
+        scan_string = scan_string_avx2;
+        scan_space = scan_space_avx2;
+        utf8_validate = utf8_validate_avx2;
+    }
+    else if (__builtin_cpu_supports("sse2")) {
+        scan_word = scan_word_sse2;
+        scan_string = scan_string_sse2;
+        scan_space = scan_space_sse2;
+        utf8_validate = utf8_validate_sse2;
     }
+#endif
 }
 
 static TokenType classify_special_token(const char *token, Token *ctoken) 
 {   
+    ctoken->symbol = 0;
     ctoken->lexeme = strdup(token);
     ctoken->literal.char_value = ctoken->lexeme;
     if(!ctoken->lexeme)
         return FAILED_TO_CLASSIFY;
 
-    if (type_of_character(token[1]) == SPECIAL) {
-        switch (token[0]) {
-        case '<':
-            return (token[1] == '=') ? LESS_EQUAL : REDIRECTION_LEFT_LESS_RELATIONAL;
-        case '>':
-            return (token[1] == '=') ? GREATER_EQUAL : REDIRECTION_RIGHT_GREATER_RELATIONAL;
-        case '&':
-            return (token[1] == '&') ? DOUBLE_AND : AND;
-        case '|':
-            return (token[1] == '|') ? DOUBLE_OR : PIPE;
-        case '!':
-            return EXCLAMATION_EQUEAL;
-        case '=':
-            return DOUBLE_EQUAL;
-        default:
+    if (token[0] && token[1]) {
+        TokenType type = classify_operator(token[0], token[1]);
+        if (!type) {
             fprintf(stderr, "error: syntax mistake at %s\n", token);
             return FAILED_TO_CLASSIFY;
         }
+        return type;
     }
     return (TokenType)token[0];
 }
@@ -157,12 +532,14 @@ static TokenType classify_string(char *token, Token *ctoken)
 {
     char tmp_char = token[strlen(token)-1];
     
+    ctoken->symbol = 0;
     /* Temporary change token and add string that is inside quotes */
     token[strlen(token) - 1] = '\0';
-    ctoken->literal.char_value = strdup(&token[1]);
+    ctoken->literal.char_value = malloc(strlen(&token[1]) + 1);
     ctoken->lexeme = ctoken->literal.char_value;
     if(!ctoken->literal.char_value)
         return FAILED_TO_CLASSIFY;
+    string_unescape(&token[1], strlen(&token[1]), ctoken->literal.char_value);
     
     token[strlen(token) - 1] = tmp_char;
     return STRING;
@@ -170,40 +547,42 @@ static TokenType classify_string(char *token, Token *ctoken)
 
 static TokenType classify_number(const char *token, Token *ctoken) 
 {
+    ctoken->symbol = 0;
     ctoken->lexeme = strdup(token);
     if(!ctoken->lexeme)
         return FAILED_TO_CLASSIFY;
 
-    for(int i = 0; token[i]; ++i) {
-        if(token[i] == '.') {
-            ctoken->literal.float_value = atof(token);
-            return NUMBER_FLOAT;
-        }
-    }
-    ctoken->literal.integer_value = atoi(token);
-    return NUMBER_INT;
+    return parse_number(token, strlen(token), &ctoken->literal);
 }
 
 static TokenType classify_reserved_words(const char *token, Token *ctoken) 
 {
     /* Initialize lexeme and literal value to NULL*/
+    ctoken->symbol = 0;
     ctoken->lexeme = strdup(token);
-
-    for (size_t i = 0; i < sizeof(reserved_word_map) / sizeof(reserved_word_map[0]); i++) {
-        if (!compare_token(token, reserved_word_map[i].reserved_word)) {
-            if(reserved_word_map[i].type == TRUE_TOKEN)  ctoken->literal.boolean_value = TRUE;
-            else
-            if(reserved_word_map[i].type == FALSE_TOKEN) ctoken->literal.boolean_value = FALSE;
-            else
-                ctoken->literal.char_value = NULL;
-            return reserved_word_map[i].type;
-        }
-    }
-
     if (!ctoken->lexeme)
         return FAILED_TO_CLASSIFY;
 
-    return IDENTIFIER;
+    TokenType type = lookup_reserved_word(token, strlen(token));
+    if (type == TRUE_TOKEN)  ctoken->literal.boolean_value = TRUE;
+    else
+    if (type == FALSE_TOKEN) ctoken->literal.boolean_value = FALSE;
+    else
+        ctoken->literal.char_value = NULL;
+
+    /* Identifier name is kept only in the symbol table */
+    if (type == IDENTIFIER) {
+        ctoken->symbol = symbol_intern(token, strlen(token));
+        free(ctoken->lexeme);
+        ctoken->lexeme = NULL;
+    }
+    return type;
+}
+
+static void lexer_trace(Token *ctokens, const size_t number_of_ctokens)
+{
+    for (size_t i = 0; i < number_of_ctokens; ++i)
+        trace_printf("Token line %u %s '%s'\n", ctokens[i].line_number, trace_token_name(ctokens[i].type), token_lexeme(&ctokens[i]));
 }
 
 extern char **tokenizer(char *cmd, size_t *token_cnt) 
@@ -216,6 +595,12 @@ extern char **tokenizer(char *cmd, size_t *token_cnt)
 
     /* Reinitialize token count back to zero */
     *token_cnt = 0;
+
+    if (*utf8_validate(cmd, cmd + strlen(cmd)) != '\0') {
+        fprintf(stderr, "error: Invalid UTF-8 in line!\n");
+        set_error_flag();
+        return NULL;
+    }
     
     for (size_t i = 0; cmd[i]; ++i) {
         switch (type_of_character(cmd[i])) {
@@ -224,6 +609,9 @@ extern char **tokenizer(char *cmd, size_t *token_cnt)
             set_error_flag();
             break;
         case SPECIAL:
+            /* Signed exponent of float literal, 1.5e-3 */
+            if (head_position < i && is_exponent_sign(&cmd[head_position], i - head_position, &cmd[i], (cmd[i+1]) ? 2 : 1))
+                break;
             char special_token[3] = {cmd[i], '\0', '\0'};
 
             /* Copy previous token into the array */
@@ -238,7 +626,7 @@ extern char **tokenizer(char *cmd, size_t *token_cnt)
                 return tokens; // TODO: Add comment block..
 
             /*Copy special token into the array*/
-            if (cmd[i+1] == '=' || cmd[i+1] == '>' || cmd[i+1] == '<' || cmd[i+1] == '&' || cmd[i+1] == '|')
+            if (classify_operator(cmd[i], cmd[i+1]))
                 special_token[1] = cmd[++i];
 
             tokens = add_token(tokens, token_cnt, special_token);
@@ -259,6 +647,9 @@ extern char **tokenizer(char *cmd, size_t *token_cnt)
                     set_error_flag();
                     break;
                 } 
+                /*Escaped character can not end the string*/
+                if(cmd[i] == '\\' && cmd[i+1] != '\n' && cmd[i+1] != '\0')
+                    i++;
             }
             /*Report an error if an quotes are followed by an identifier*/
             if(type_of_character(cmd[i+1]) == OTHER) {
@@ -297,8 +688,10 @@ extern char **tokenizer(char *cmd, size_t *token_cnt)
 extern size_t eof_token(Token **ctoken, size_t number_of_ctokens) 
 {
     number_of_ctokens++;
-    *ctoken = realloc(*ctoken, sizeof(Token) * number_of_ctokens);
+    if (number_of_ctokens == 1 || token_capacity(number_of_ctokens) != token_capacity(number_of_ctokens - 1))
+        *ctoken = realloc(*ctoken, sizeof(Token) * token_capacity(number_of_ctokens));
     (*ctoken)[number_of_ctokens - 1].lexeme = NULL;
+    (*ctoken)[number_of_ctokens - 1].symbol = 0;
     (*ctoken)[number_of_ctokens - 1].literal.char_value = NULL;
     (*ctoken)[number_of_ctokens - 1].type = EOF_TOKEN;
     return number_of_ctokens;
@@ -309,13 +702,17 @@ extern Token *token_classifier(char **token, Token *ctoken, const size_t number_
     if (!token)
         return NULL;
 
-    ctoken = realloc(ctoken, sizeof(Token) * (number_of_tokens));
+    /* Classified tokens are appended, reallocate only when capacity is exceeded */
+    if (*number_of_ctokens == 0 || token_capacity(number_of_tokens) != token_capacity(*number_of_ctokens))
+        ctoken = realloc(ctoken, sizeof(Token) * token_capacity(number_of_tokens));
     if (ctoken == NULL) {
         fprintf(stderr, "Failed to allocate memory for ctoken!");
         free(ctoken);
     }
 
     for (size_t i = 0; i < number_of_tokens - *number_of_ctokens; ++i) {
+        /* Terminal input is a single line */
+        ctoken[*number_of_ctokens + i].line_number = 1;
         if (type_of_character(token[i][0]) == SPECIAL)
             ctoken[*number_of_ctokens + i].type = classify_special_token(token[i], &ctoken[*number_of_ctokens + i]);
         else if (type_of_character(token[i][0]) == QUOTES)
@@ -337,8 +734,296 @@ extern Token *token_classifier(char **token, Token *ctoken, const size_t number_
         }
     }
 
+    if (TRACE_ON(TRACE_LEXER))
+        lexer_trace(&ctoken[*number_of_ctokens], number_of_tokens - *number_of_ctokens);
     *number_of_ctokens = number_of_tokens;
     return ctoken;
 }
 
 
+
+
+static void token_vector_reserve(TokenVector *ctokens, const size_t capacity)
+{
+    if (capacity <= ctokens->capacity)
+        return;
+    Token *new_tokens = realloc(ctokens->tokens, sizeof(Token) * capacity);
+    if (!new_tokens) {
+        INTERNAL_ERROR("Failed to reallocate memory during token_vector_reserve!");
+        token_vector_free(ctokens);
+        exit(EXIT_FAILURE);
+    }
+    ctokens->tokens = new_tokens;
+    ctokens->capacity = capacity;
+}
+
+static Token *token_vector_push(TokenVector *ctokens, const size_t offset, const size_t length, const size_t line_number)
+{
+    if (ctokens->size == ctokens->capacity)
+        token_vector_reserve(ctokens, (ctokens->capacity) ? 2 * ctokens->capacity : 64);
+    Token *ctoken = &ctokens->tokens[ctokens->size++];
+    *ctoken = (Token){
+        .type = FAILED_TO_CLASSIFY,
+        .lexeme = NULL,
+        .literal.char_value = NULL,
+        .line_number = line_number,
+        .offset = offset,
+        .length = length,
+        .symbol = 0};
+    return ctoken;
+}
+
+static TokenType classify_special_span(const char *span, const size_t length)
+{
+    if (length == 2) {
+        TokenType type = classify_operator(span[0], span[1]);
+        if (!type) {
+            fprintf(stderr, "error: syntax mistake at %.*s\n", (int)length, span);
+            return FAILED_TO_CLASSIFY;
+        }
+        return type;
+    }
+    return (TokenType)span[0];
+}
+
+static TokenType classify_number_span(const char *span, const size_t length, Token *ctoken)
+{
+    return parse_number(span, length, &ctoken->literal);
+}
+
+static int is_exponent_sign(const char *word, const size_t length, const char *sign, const size_t remaining)
+{
+    /* Hex literals may end with digit e, there the sign is an operator */
+    if (!is_digit(word[0]) || length < 2 || (word[length - 1] | 0x20) != 'e' || (word[0] == '0' && (word[1] | 0x20) == 'x'))
+        return FALSE;
+    return remaining > 1 && (sign[0] == '+' || sign[0] == '-') && is_digit(sign[1]);
+}
+
+static TokenType classify_reserved_span(const char *span, const size_t length, Token *ctoken)
+{
+    TokenType type = lookup_reserved_word(span, length);
+    if (type == TRUE_TOKEN)  ctoken->literal.boolean_value = TRUE;
+    else
+    if (type == FALSE_TOKEN) ctoken->literal.boolean_value = FALSE;
+    return type;
+}
+
+static TokenType classify_word_span(const char *span, const size_t length, Token *ctoken)
+{
+    if (is_digit(span[0]))
+        return classify_number_span(span, length, ctoken);
+    return classify_reserved_span(span, length, ctoken);
+}
+
+extern int source_map(const char *file_name, Source *source)
+{
+    struct stat file_stat;
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0)
+        return EXIT_FAILURE;
+    if (fstat(fd, &file_stat) < 0) {
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    /* Empty scripts can't be mapped, point them to an empty string instead */
+    source->size = (size_t)file_stat.st_size;
+    source->data = "";
+    if (source->size > 0) {
+        void *mapping = mmap(NULL, source->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            return EXIT_FAILURE;
+        }
+        source->data = mapping;
+    }
+    close(fd);
+    return EXIT_SUCCESS;
+}
+
+extern void source_attach(const Source *source)
+{
+    source_base = source->data;
+    scan_dispatch();
+}
+
+extern void source_unmap(Source *source)
+{
+    if (source->size > 0)
+        munmap((void *)source->data, source->size);
+    if (source_base == source->data)
+        source_base = NULL;
+    source->data = NULL;
+    source->size = 0;
+}
+
+static TokenVector *lex_range(const char *cmd, const size_t begin, const size_t size, size_t line_number, TokenVector *ctokens, const int intern)
+{
+    Token *ctoken = NULL;
+
+    /* Tokens keep 32-bit offsets into the script */
+    if (size > LEXER_MAX_SOURCE) {
+        fprintf(stderr, "error: Script is larger than %u bytes!\n", LEXER_MAX_SOURCE);
+        set_error_flag();
+        return NULL;
+    }
+
+    /* Strings and comments may hold UTF-8, whole range is validated before lexing */
+    const char *invalid = utf8_validate(&cmd[begin], &cmd[size]);
+    if (invalid != &cmd[size]) {
+        for (const char *cursor = &cmd[begin]; (cursor = memchr(cursor, '\n', invalid - cursor)) != NULL; ++cursor)
+            line_number++;
+        fprintf(stderr, "error: Invalid UTF-8 at line %zu!\n", line_number);
+        set_error_flag();
+        return NULL;
+    }
+
+    /* Reserve for expected number of tokens at once instead of doubling through it */
+    token_vector_reserve(ctokens, ctokens->size + (size - begin) / LEXER_BYTES_PER_TOKEN + 1);
+
+    for (size_t i = begin; i < size;) {
+        switch (character_class[(unsigned char)cmd[i]]) {
+        case OTHER:
+        {
+            /* Most words are short, vector scanner is called only for the rest of a long one */
+            size_t end = i + 1;
+            while (end < size && end - i < LEXER_SHORT_RUN && character_class[(unsigned char)cmd[end]] == OTHER)
+                end++;
+            if (end - i == LEXER_SHORT_RUN)
+                end = scan_word(&cmd[end], &cmd[size]) - cmd;
+            /* Signed exponent of float literal, 1.5e-3 */
+            if (end < size && is_exponent_sign(&cmd[i], end - i, &cmd[end], size - end))
+                end = scan_word(&cmd[end + 1], &cmd[size]) - cmd;
+            ctoken = token_vector_push(ctokens, i, end - i, line_number);
+            ctoken->type = classify_word_span(&cmd[i], end - i, ctoken);
+            if (ctoken->type == FAILED_TO_CLASSIFY)
+                goto CLASSIFY_ERROR_LABEL;
+            if (ctoken->type == IDENTIFIER && intern)
+                ctoken->symbol = symbol_intern(&cmd[i], end - i);
+
+            /*Report an error if an identifier is followed by quotes*/
+            if (end < size && cmd[end] == '"') {
+                fprintf(stderr,"error: Syntax Error at line %zu! Expected valid separator after identifier.\n", line_number);
+                set_error_flag();
+                return NULL;
+            }
+            i = end;
+            break;
+        }
+        case SPECIAL:
+        {
+            /* Comment lasts until the end of the line */
+            if (cmd[i] == '#') {
+                const char *new_line = memchr(&cmd[i], '\n', size - i);
+                i = (new_line) ? (size_t)(new_line - cmd) : size;
+                break;
+            }
+
+            size_t length = 1;
+            if (i + 1 < size && classify_operator(cmd[i], cmd[i+1]))
+                length = 2;
+            ctoken = token_vector_push(ctokens, i, length, line_number);
+            ctoken->type = classify_special_span(&cmd[i], length);
+            if (ctoken->type == FAILED_TO_CLASSIFY)
+                goto CLASSIFY_ERROR_LABEL;
+            i += length;
+            break;
+        }
+        case QUOTES:
+        {
+            /* Skip string body up to the closing quotes */
+            size_t end = scan_string(&cmd[i + 1], &cmd[size]) - cmd;
+            while (end < size && cmd[end] == '"' && is_escaped(cmd, i + 1, end))
+                end = scan_string(&cmd[end + 1], &cmd[size]) - cmd;
+            /*Report an error if quotes are unterminated*/
+            if (end == size || cmd[end] != '"') {
+                fprintf(stderr, "error: Unterminated string at line %zu! \n", line_number);
+                set_error_flag();
+                return NULL;
+            }
+            /*Report an error if quotes are followed by an identifier*/
+            if (end + 1 < size && character_class[(unsigned char)cmd[end + 1]] == OTHER) {
+                fprintf(stderr, "error: Syntax Error at line %zu! Unexpected token.\n", line_number);
+                set_error_flag();
+                return NULL;
+            }
+            ctoken = token_vector_push(ctokens, i, end - i + 1, line_number);
+            ctoken->type = STRING;
+            i = end + 1;
+            break;
+        }
+        case SPACE:
+            /* Single space between tokens is the common case */
+            if (++i < size && character_class[(unsigned char)cmd[i]] == SPACE)
+                i = scan_space(&cmd[i], &cmd[size]) - cmd;
+            break;
+        case NEW_LINE:
+            line_number++;
+            i++;
+            break;
+        case UNUSED_CHARACTERS:
+        default:
+            fprintf(stderr, "error: Character is not allowed in Cash!\n\t Error at line: %zu! \n", line_number);
+            set_error_flag();
+            return NULL;
+        }
+    }
+
+    /* Add EOF token at the end */
+    ctoken = token_vector_push(ctokens, size, 0, line_number);
+    ctoken->type = EOF_TOKEN;
+    return ctokens;
+
+    CLASSIFY_ERROR_LABEL:
+    fprintf(stderr, "error: Failed to classify token %.*s at line %u\n", (int)ctoken->length, &cmd[ctoken->offset], ctoken->line_number);
+    set_error_flag();
+    return NULL;
+}
+
+extern TokenVector *source_lexer(const Source *source, TokenVector *ctokens)
+{
+    source_attach(source);
+    if (lex_range(source->data, 0, source->size, 1, ctokens, TRUE) == NULL)
+        return NULL;
+    if (TRACE_ON(TRACE_LEXER))
+        lexer_trace(ctokens->tokens, ctokens->size);
+    return ctokens;
+}
+
+extern TokenVector *source_lexer_range(const Source *source, const size_t begin, const size_t end, const size_t line_number, TokenVector *ctokens)
+{
+    return lex_range(source->data, begin, end, line_number, ctokens, FALSE);
+}
+
+extern void token_vector_free(TokenVector *ctokens)
+{
+    for (size_t i = 0; i < ctokens->size; ++i)
+        free(ctokens->tokens[i].lexeme);
+    free(ctokens->tokens);
+    ctokens->tokens = NULL;
+    ctokens->size = 0;
+    ctokens->capacity = 0;
+}
+
+extern char *token_lexeme(Token *ctoken)
+{
+    /* Identifiers are not copied, their name lives in the symbol table */
+    if (ctoken->type == IDENTIFIER && ctoken->symbol)
+        return symbol_name(ctoken->symbol);
+    if (ctoken->lexeme != NULL || ctoken->type == EOF_TOKEN || source_base == NULL)
+        return ctoken->lexeme;
+
+    /* String lexeme is the string that is inside quotes, escapes are decoded only here */
+    if (ctoken->type == STRING) {
+        ctoken->lexeme = malloc(ctoken->length - 1);
+        if (ctoken->lexeme)
+            string_unescape(source_base + ctoken->offset + 1, ctoken->length - 2, ctoken->lexeme);
+        ctoken->literal.char_value = ctoken->lexeme;
+    }
+    else
+        ctoken->lexeme = strndup(source_base + ctoken->offset, ctoken->length);
+
+    if (!ctoken->lexeme)
+        INTERNAL_ERROR("token_lexeme strndup failed!");
+    return ctoken->lexeme;
+}
@@ -25,9 +25,26 @@ SOFTWARE.
 #ifndef LEXER_H
 #define LEXER_H
 
-/*@compare_token
-*Function: Compares token with value.*/
-static int compare_token(const char *, const char *);
+/* Error bits of the vector UTF-8 validator, a byte pair is invalid if all three lookups share a bit */
+#define UTF8_TOO_SHORT      0x01    // Lead byte not followed by continuation
+#define UTF8_TOO_LONG       0x02    // ASCII followed by continuation
+#define UTF8_OVERLONG_3     0x04    // E0 followed by 80..9F
+#define UTF8_TOO_LARGE      0x08    // F4 followed by 90..BF or lead above F4
+#define UTF8_SURROGATE      0x10    // ED followed by A0..BF
+#define UTF8_OVERLONG_2     0x20    // C0 or C1 lead
+#define UTF8_TOO_LARGE_1000 0x40    // Lead above F4 followed by 80..8F
+#define UTF8_OVERLONG_4     0x40    // F0 followed by 80..8F
+#define UTF8_TWO_CONTS      0x80    // Continuation followed by continuation
+#define UTF8_CARRY          (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+/* Source lexer sizing */
+#define LEXER_MAX_SOURCE        UINT32_MAX  // Token offsets and lengths are 32-bit
+#define LEXER_BYTES_PER_TOKEN   2           // Dense code has about one token per three bytes, reserve covers it without reallocation
+#define LEXER_SHORT_RUN         16          // Words shorter than this are scanned without calling vector scanner
+
+/*@lookup_reserved_word
+*Function: Looks up reserved word in the generated perfect hash, returns IDENTIFIER if not reserved.*/
+static TokenType lookup_reserved_word(const char *, const size_t);
 
 /*@add_token
 *Helper Function: Adds a token to the array*/
@@ -37,14 +54,55 @@ static char **add_token(char **, size_t *, char *);
 *Helper Function: Determines if character is digit*/
 static int is_digit(const char c);
 
-/*@is_letter
-*Helper Function: Determines if character is letter*/
-static int is_letter(char c);
+/*@classify_operator
+*Helper Function: Looks up two character operator in table generated from tokens.def, returns 0 if there is none*/
+static TokenType classify_operator(const char, const char);
 
 /*@type_of_character
-*Helper Function: Determines type of character*/
+*Helper Function: Determines type of character from the character class table*/
 static CharacterType type_of_character(char c);
 
+/*@scan_word_scalar
+*Helper Function: Returns end of run of identifier characters*/
+static const char *scan_word_scalar(const char *, const char *);
+
+/*@scan_string_scalar
+*Helper Function: Returns position of closing quotes or new line in string body*/
+static const char *scan_string_scalar(const char *, const char *);
+
+/*@is_escaped
+*Helper Function: Returns TRUE if character at position is preceded by odd number of backslashes after begin*/
+static int is_escaped(const char *, const size_t, const size_t);
+
+/*@hex_digit
+*Helper Function: Returns value of hexadecimal digit or -1 if character is not one*/
+static int hex_digit(const char);
+
+/*@string_unescape
+*Helper Function: Decodes \n, \t, \", \\ and \xNN of string body into out, unknown escapes and \x00 are kept as written.
+*Out must hold length + 1 bytes, returns decoded length*/
+static size_t string_unescape(const char *, const size_t, char *);
+
+/*@utf8_sequence
+*Helper Function: Returns length of valid UTF-8 sequence at cursor, 0 if it is invalid, overlong, surrogate or truncated*/
+static size_t utf8_sequence(const unsigned char *, const unsigned char *);
+
+/*@utf8_validate_scalar
+*Helper Function: Returns position of first invalid UTF-8 byte or end, skips eight ASCII bytes at once*/
+static const char *utf8_validate_scalar(const char *, const char *);
+
+/*@utf8_restart
+*Helper Function: Validates with scalar validator from start of sequence that may cross position, used to locate error found by vector validator*/
+static const char *utf8_restart(const char *, const char *, const char *);
+
+/*@scan_space_scalar
+*Helper Function: Returns end of run of whitespace*/
+static const char *scan_space_scalar(const char *, const char *);
+
+/*@scan_dispatch
+*Helper Function: Selects AVX2, SSE2 or scalar scanners and UTF-8 validator supported by the CPU*/
+static void scan_dispatch(void);
+
 /*@classify_special_token
 *Helper Function: Classifies special character token*/
 static TokenType classify_special_token(const char *, Token *);
@@ -61,6 +119,46 @@ static TokenType classify_number(const char *, Token *);
 *Helper Function: Classifies reserved words*/
 static TokenType classify_reserved_words(const char *, Token *);
 
+/*@token_capacity
+*Helper Function: Returns capacity of token array holding given number of tokens*/
+static size_t token_capacity(const size_t);
+
+/*@token_vector_reserve
+*Helper Function: Grows TokenVector to hold at least given number of tokens*/
+static void token_vector_reserve(TokenVector *, const size_t);
+
+/*@token_vector_push
+*Helper Function: Appends token span to the TokenVector and returns pointer to it*/
+static Token *token_vector_push(TokenVector *, const size_t, const size_t, const size_t);
+
+/*@classify_word_span
+*Helper Function: Classifies number, reserved word or identifier source span*/
+static TokenType classify_word_span(const char *, const size_t, Token *);
+
+/*@classify_special_span
+*Helper Function: Classifies special character source span*/
+static TokenType classify_special_span(const char *, const size_t);
+
+/*@classify_number_span
+*Helper Function: Classifies number source span*/
+static TokenType classify_number_span(const char *, const size_t, Token *);
+
+/*@is_exponent_sign
+*Helper Function: Determines if + or - after number word is sign of float exponent*/
+static int is_exponent_sign(const char *, const size_t, const char *, const size_t);
+
+/*@classify_reserved_span
+*Helper Function: Classifies reserved words source span*/
+static TokenType classify_reserved_span(const char *, const size_t, Token *);
+
+/*@lex_range
+*Helper Function: Lexes bytes begin..size of script starting at line_number, interns identifiers only if intern is set*/
+static TokenVector *lex_range(const char *, const size_t, const size_t, size_t, TokenVector *, const int);
+
+/*@lexer_trace
+*Helper Function: Writes classified tokens to trace sink*/
+static void lexer_trace(Token *, const size_t);
+
 /*@tokenizer
 *Function: Separates line into individual null terminated tokens.*/
 extern char **tokenizer(char *, size_t *);
@@ -73,4 +171,36 @@ extern size_t eof_token(Token **, size_t );
 *Function: Classifies tokens and returns pointer to classified tokens*/
 extern Token *token_classifier(char **, Token *, const size_t , size_t *);
 
+/*@source_map
+*Function: Maps script read-only into Source, returns EXIT_FAILURE if it could not be mapped*/
+extern int source_map(const char *, Source *);
+
+/*@source_unmap
+*Function: Unmaps Source previously mapped by source_map*/
+extern void source_unmap(Source *);
+
+/*@source_attach
+*Function: Makes tokens materialize lexemes from Source without lexing it, used for tokens loaded from cache
+*and before source_lexer_range*/
+extern void source_attach(const Source *);
+
+/*@source_lexer
+*Function: Tokenizes and classifies mapped script in a single pass, appends tokens and EOF to TokenVector.
+*Tokens hold offset and length of the lexeme, no copies are made. Returns NULL on error*/
+extern TokenVector *source_lexer(const Source *, TokenVector *);
+
+/*@source_lexer_range
+*Function: Lexes bytes begin..end of Source attached by source_attach, first line is line_number.
+*Safe to call from several threads, identifiers are not interned (symbol is 0) and nothing is traced. Returns NULL on error*/
+extern TokenVector *source_lexer_range(const Source *, const size_t, const size_t, const size_t, TokenVector *);
+
+/*@token_vector_free
+*Function: Deallocates tokens of TokenVector and their materialized lexemes*/
+extern void token_vector_free(TokenVector *);
+
+/*@token_lexeme
+*Function: Returns null terminated lexeme of token, materializes it from the Source on first use.
+*Lexeme of STRING is its body with escapes decoded*/
+extern char *token_lexeme(Token *);
+
 #endif // LEXER_H
\ No newline at end of file
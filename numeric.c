@@ -0,0 +1,251 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <setjmp.h>
+#include "coretypes.h"
+#include "error.h"
+#include "numeric.h"
+#include "pow5_table.h"
+
+/* Exact powers of ten representable by double, used by the fast path */
+static const double exact_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static unsigned digit_value(const char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') return (c | 0x20) - 'a' + 10;
+    return 16;
+}
+
+static int is_float_literal(const char *span, const size_t length)
+{
+    if (length > 1 && span[0] == '0' && ((span[1] | 0x20) == 'x' || (span[1] | 0x20) == 'b'))
+        return FALSE;
+    for (size_t i = 0; i < length; ++i)
+        if (span[i] == '.' || (span[i] | 0x20) == 'e')
+            return TRUE;
+    return FALSE;
+}
+
+static NumberStatus parse_integer(const char *span, const size_t length, long long *value)
+{
+    unsigned base = 10;
+    size_t start = 0;
+    if (length > 1 && span[0] == '0' && (span[1] | 0x20) == 'x') base = 16, start = 2;
+    else
+    if (length > 1 && span[0] == '0' && (span[1] | 0x20) == 'b') base = 2, start = 2;
+
+    unsigned long long result = 0;
+    int overflow = FALSE;
+    if (start == length)
+        return NUMBER_MALFORMED;
+
+    for (size_t i = start; i < length; ++i) {
+        /* Separator has to be between two digits */
+        if (span[i] == '_') {
+            if (i == start || i + 1 == length || span[i + 1] == '_')
+                return NUMBER_MALFORMED;
+            continue;
+        }
+        unsigned digit = digit_value(span[i]);
+        if (digit >= base)
+            return NUMBER_MALFORMED;
+        if (__builtin_mul_overflow(result, base, &result) || __builtin_add_overflow(result, digit, &result))
+            overflow = TRUE;
+    }
+
+    if (overflow || result > LLONG_MAX)
+        return NUMBER_OVERFLOW;
+    *value = (long long)result;
+    return NUMBER_OK;
+}
+
+static int eisel_lemire(uint64_t w, int64_t q, double *value)
+{
+    if (q < POW5_MIN_EXPONENT) return (*value = 0.0, TRUE);
+    if (q > POW5_MAX_EXPONENT) return (*value = INFINITY, TRUE);
+
+    /* Normalize w and multiply by truncated 5^q */
+    int lz = __builtin_clzll(w);
+    w <<= lz;
+    const uint64_t *pow5 = pow5_table[q - POW5_MIN_EXPONENT];
+    unsigned __int128 product = (unsigned __int128)w * pow5[0];
+    uint64_t high = (uint64_t)(product >> 64);
+    uint64_t low = (uint64_t)product;
+
+    /* Low bits are all ones, the next 64 bits of 5^q may carry into them */
+    if ((high & 0x1FF) == 0x1FF) {
+        uint64_t second = (uint64_t)(((unsigned __int128)w * pow5[1]) >> 64);
+        low += second;
+        if (second > low) high++;
+    }
+    if (low == UINT64_MAX && (q < -27 || q > 55))
+        return FALSE;
+
+    int upperbit = (int)(high >> 63);
+    uint64_t mantissa = high >> (upperbit + 9);
+    int64_t power2 = (((152170 + 65536) * q) >> 16) + 63 + upperbit - lz + 1023;
+
+    /* Subnormal results are left to strtod */
+    if (power2 <= 0)
+        return FALSE;
+
+    /* Exactly halfway between two doubles, round to even */
+    if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << (upperbit + 9)) == high)
+        mantissa &= ~(uint64_t)1;
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (2ull << 52)) {
+        mantissa = 1ull << 52;
+        power2++;
+    }
+    mantissa &= ~(1ull << 52);
+    if (power2 >= 0x7FF)
+        return (*value = INFINITY, TRUE);
+
+    uint64_t bits = mantissa | ((uint64_t)power2 << 52);
+    memcpy(value, &bits, sizeof(*value));
+    return TRUE;
+}
+
+static double strtod_fallback(const char *span, const size_t length)
+{
+    char stack_buffer[MAX_NUMBER_SIZE];
+    char *buffer = (length < MAX_NUMBER_SIZE) ? stack_buffer : malloc(length + 1);
+    if (buffer == NULL) {
+        INTERNAL_ERROR("Failed to allocate number buffer!");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t size = 0;
+    for (size_t i = 0; i < length; ++i)
+        if (span[i] != '_') buffer[size++] = span[i];
+    buffer[size] = '\0';
+
+    double value = strtod(buffer, NULL);
+    if (buffer != stack_buffer)
+        free(buffer);
+    return value;
+}
+
+static NumberStatus parse_float(const char *span, const size_t length, double *value)
+{
+    uint64_t mantissa = 0;
+    int64_t exponent = 0;
+    int significant_digits = 0;
+    int truncated = FALSE;
+    int fraction = FALSE;
+    size_t i = 0;
+
+    /* Integer and fraction digits, at most 19 significant digits fit into mantissa */
+    for (; i < length; ++i) {
+        char c = span[i];
+        if (c == '_') {
+            if (i == 0 || !(span[i - 1] >= '0' && span[i - 1] <= '9') || i + 1 == length || !(span[i + 1] >= '0' && span[i + 1] <= '9'))
+                return NUMBER_MALFORMED;
+            continue;
+        }
+        if (c == '.') {
+            if (fraction)
+                return NUMBER_MALFORMED;
+            fraction = TRUE;
+            continue;
+        }
+        if (!(c >= '0' && c <= '9'))
+            break;
+
+        if (significant_digits < 19) {
+            mantissa = mantissa * 10 + (c - '0');
+            if (mantissa) significant_digits++;
+            if (fraction) exponent--;
+        }
+        else {
+            truncated |= (c != '0');
+            if (!fraction) exponent++;
+        }
+    }
+
+    if (i < length && (span[i] | 0x20) == 'e') {
+        int negative = FALSE;
+        int64_t explicit_exponent = 0;
+        if (++i < length && (span[i] == '+' || span[i] == '-'))
+            negative = (span[i++] == '-');
+        if (i == length)
+            return NUMBER_MALFORMED;
+        for (; i < length; ++i) {
+            if (!(span[i] >= '0' && span[i] <= '9'))
+                return NUMBER_MALFORMED;
+            /* Clamp, anything this large is zero or infinity anyway */
+            if (explicit_exponent < 100000)
+                explicit_exponent = explicit_exponent * 10 + (span[i] - '0');
+        }
+        exponent += (negative) ? -explicit_exponent : explicit_exponent;
+    }
+    if (i != length)
+        return NUMBER_MALFORMED;
+
+    if (mantissa == 0 && !truncated)
+        *value = 0.0;
+    /* Both operands are exact so a single rounding gives correct result */
+    else if (!truncated && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
+        *value = (exponent < 0) ? (double)mantissa / exact_pow10[-exponent] : (double)mantissa * exact_pow10[exponent];
+    else if (truncated || !eisel_lemire(mantissa, exponent, value))
+        *value = strtod_fallback(span, length);
+
+    return (isinf(*value)) ? NUMBER_OVERFLOW : NUMBER_OK;
+}
+
+extern TokenType parse_number(const char *span, const size_t length, Value *literal)
+{
+    TokenType type = NUMBER_INT;
+    NumberStatus status;
+
+    if (is_float_literal(span, length)) {
+        type = NUMBER_FLOAT;
+        status = parse_float(span, length, &literal->float_value);
+    }
+    else
+        status = parse_integer(span, length, &literal->integer_value);
+
+    switch (status) {
+    case NUMBER_OK:
+        return type;
+    case NUMBER_OVERFLOW:
+        fprintf(stderr, "error: Number %.*s is out of range!\n", (int)length, span);
+        return FAILED_TO_CLASSIFY;
+    case NUMBER_MALFORMED:
+    default:
+        fprintf(stderr, "error: Malformed number %.*s!\n", (int)length, span);
+        return FAILED_TO_CLASSIFY;
+    }
+}
@@ -0,0 +1,56 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef NUMERIC_H
+#define NUMERIC_H
+
+/*@Function: digit_value
+*Helper Function: Returns value of decimal or hex digit, 16 or more if character is not a digit */
+static unsigned digit_value(const char);
+
+/*@Function: is_float_literal
+*Helper Function: Determines if decimal literal has fraction or exponent */
+static int is_float_literal(const char *, const size_t);
+
+/*@Function: parse_integer
+*Helper Function: Parses decimal, hex (0x) or binary (0b) literal with _ separators into 64 bit integer */
+static NumberStatus parse_integer(const char *, const size_t, long long *);
+
+/*@Function: parse_float
+*Helper Function: Parses decimal float literal, uses fast path, then Eisel-Lemire, then strtod */
+static NumberStatus parse_float(const char *, const size_t, double *);
+
+/*@Function: eisel_lemire
+*Helper Function: Correctly rounded w * 10^q using 128 bit power of five table, returns FALSE if it can not decide */
+static int eisel_lemire(uint64_t, int64_t, double *);
+
+/*@Function: strtod_fallback
+*Helper Function: Parses float literal with strtod after removing _ separators */
+static double strtod_fallback(const char *, const size_t);
+
+/*@Function: parse_number
+*Function that classifies number literal span as NUMBER_INT or NUMBER_FLOAT and stores its value, reports malformed literals and overflow */
+extern TokenType parse_number(const char *, const size_t, Value *);
+
+#endif // NUMERIC_H
@@ -0,0 +1,459 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "coretypes.h"
+#include "error.h"
+#include "lexer.h"
+#include "arena.h"
+#include "value.h"
+#include "trace.h"
+#include "optimizer.h"
+
+/* Number of function bodies that prune is inside of, return ends statement list only there */
+static size_t prune_function_depth = 0;
+
+static size_t ast_count(AST *ast)
+{
+    if(ast == NULL) return 0;
+    size_t count = 1;
+
+    switch(ast->tag) {
+        case AST_VAR_DECL_STMT:
+            return count + ast_count(ast->data.AST_VAR_DECL_STMT.init);
+        case AST_FUNCT_DECL_STMT:
+            for(size_t i = 0; i < ast->data.AST_FUNCT_DECL_STMT.param_num; ++i)
+                count += ast_count(ast->data.AST_FUNCT_DECL_STMT.parameters[i]);
+            for(size_t i = 0; i < ast->data.AST_FUNCT_DECL_STMT.stmt_num; ++i)
+                count += ast_count(ast->data.AST_FUNCT_DECL_STMT.stmt_list[i]);
+            return count;
+        case AST_EXPR_STMT:
+        case AST_ECHO_STMT:
+        case AST_RETURN_STMT:
+        case AST_CD_STMT:
+            return count + ast_count(ast->data.AST_EXPR_STMT.expr);
+        case AST_BLOCK_STMT:
+            for(size_t i = 0; i < ast->data.AST_BLOCK_STMT.stmt_num; ++i)
+                count += ast_count(ast->data.AST_BLOCK_STMT.stmt_list[i]);
+            return count;
+        case AST_IF_STMT:
+            return count + ast_count(ast->data.AST_IF_STMT.condition) + ast_count(ast->data.AST_IF_STMT.true_branch)
+                         + ast_count(ast->data.AST_IF_STMT.else_branch);
+        case AST_WHILE_STMT:
+            return count + ast_count(ast->data.AST_WHILE_STMT.condition) + ast_count(ast->data.AST_WHILE_STMT.body);
+        case AST_FOR_STMT:
+            return count + ast_count(ast->data.AST_FOR_STMT.initializer) + ast_count(ast->data.AST_FOR_STMT.condition)
+                         + ast_count(ast->data.AST_FOR_STMT.increment) + ast_count(ast->data.AST_FOR_STMT.body);
+        case AST_RUN_STMT:
+            for(size_t i = 0; i < ast->data.AST_RUN_STMT.arg_num; ++i)
+                count += ast_count(ast->data.AST_RUN_STMT.args_list[i]);
+            return count;
+        case AST_CALL_EXPR:
+            count += ast_count(ast->data.AST_CALL_EXPR.callee);
+            for(size_t i = 0; i < ast->data.AST_CALL_EXPR.stmt_num; ++i)
+                count += ast_count(ast->data.AST_CALL_EXPR.stmt_list[i]);
+            return count;
+        case AST_ASSIGN_EXPR:
+            return count + ast_count(ast->data.AST_ASSIGN_EXPR.expr);
+        case AST_LOGICAL_EXPR:
+        case AST_BINARY_EXPR:
+            return count + ast_count(ast->data.AST_BINARY_EXPR.left) + ast_count(ast->data.AST_BINARY_EXPR.right);
+        case AST_GROUPING_EXPR:
+            return count + ast_count(ast->data.AST_GROUPING_EXPR.left);
+        case AST_UNARY_EXPR:
+            return count + ast_count(ast->data.AST_UNARY_EXPR.right);
+        default:
+            return count;
+    }
+}
+
+static int is_constant(const AST *ast)
+{
+    if(ast == NULL || ast->tag != AST_LITERAL) return FALSE;
+    switch(ast->data.token->type) {
+        case NUMBER_INT:
+        case NUMBER_FLOAT:
+        case STRING:
+        case TRUE_TOKEN:
+        case FALSE_TOKEN:
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+static int is_numeric(const AST *ast)
+{
+    if(ast == NULL) return FALSE;
+    switch(ast->tag) {
+        case AST_LITERAL:
+            return ast->data.token->type == NUMBER_INT || ast->data.token->type == NUMBER_FLOAT;
+        case AST_UNARY_EXPR:
+            /* Unary subtract of boolean and XOR also result in int */
+            return ast->data.AST_UNARY_EXPR.token->type != EXCLAMATION;
+        case AST_BINARY_EXPR:
+            switch(ast->data.AST_BINARY_EXPR.token->type) {
+                case SUBTRACT:
+                case MULTIPLY:
+                case DIVIDE:
+                case MODULUS:
+                case SHIFT_LEFT:
+                case SHIFT_RIGHT:
+                case AND:
+                case PIPE:
+                    return TRUE;
+                default:
+                    /* Add may concatenate strings, comparisons result in booleans */
+                    return FALSE;
+            }
+        default:
+            return FALSE;
+    }
+}
+
+static int is_integer_literal(const AST *ast, const long long int value)
+{
+    return ast->tag == AST_LITERAL && ast->data.token->type == NUMBER_INT && ast->data.token->literal.integer_value == value;
+}
+
+static int can_fold_unary(const Token *operator, const Token *right)
+{
+    switch(operator->type) {
+        case SUBTRACT:
+            return right->type != STRING;
+        case XOR:
+            return right->type != STRING && right->type != NUMBER_FLOAT;
+        case EXCLAMATION:
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+static int can_fold_binary(const Token *operator, const Token *left, const Token *right)
+{
+    if(left->type == STRING || right->type == STRING)
+        return operator->type == ADD && left->type == STRING && right->type == STRING;
+
+    switch(operator->type) {
+        case EXCLAMATION_EQUEAL:
+        case DOUBLE_EQUAL:
+        case REDIRECTION_RIGHT_GREATER_RELATIONAL:
+        case REDIRECTION_LEFT_LESS_RELATIONAL:
+        case GREATER_EQUAL:
+        case LESS_EQUAL:
+        case ADD:
+        case SUBTRACT:
+        case MULTIPLY:
+        case DIVIDE:
+            return TRUE;
+        case MODULUS:
+            return left->type != NUMBER_FLOAT && right->type == NUMBER_INT && right->literal.integer_value != 0;
+        case SHIFT_LEFT:
+        case SHIFT_RIGHT:
+            return left->type != NUMBER_FLOAT && right->type == NUMBER_INT && 
+                   right->literal.integer_value >= 0 && right->literal.integer_value <= 63;
+        case AND:
+        case PIPE:
+            return left->type != NUMBER_FLOAT && right->type != NUMBER_FLOAT;
+        default:
+            return FALSE;
+    }
+}
+
+static AST *constant_node(Arena *arena, const Token *operator, ValueTagged *value)
+{
+    Token *token = arena_alloc(arena, sizeof(Token));
+    AST *ast = arena_alloc(arena, sizeof(AST));
+    char *lexeme = NULL;
+
+    switch(value->type) {
+        case STRING:
+        {
+            /* Lexeme is also the shared string value of folded literal */
+            lexeme = string_static(arena, value->literal.char_value, string_length(value->literal.char_value));
+            break;
+        }
+        case NUMBER_INT:
+            lexeme = arena_alloc(arena, FOLD_LEXEME_SIZE);
+            snprintf(lexeme, FOLD_LEXEME_SIZE, "%lld", value->literal.integer_value);
+            break;
+        case NUMBER_FLOAT:
+            lexeme = arena_alloc(arena, FOLD_LEXEME_SIZE);
+            snprintf(lexeme, FOLD_LEXEME_SIZE, "%.17g", value->literal.float_value);
+            break;
+        default:
+            lexeme = (value->literal.boolean_value) ? "true" : "false";
+            break;
+    }
+
+    /* Folded token has no span in source, lexeme is owned by arena */
+    *token = (Token){
+        .type = value->type,
+        .lexeme = lexeme,
+        .literal = value->literal,
+        .line_number = operator->line_number,
+        .offset = operator->offset,
+        .length = operator->length,
+        .symbol = 0
+    };
+    TokenType value_type = value->type;
+    if(value_type == STRING) token->literal.char_value = lexeme;
+    free_value(value);
+
+    *ast = (AST){.tag = AST_LITERAL, .data.AST_LITERAL = {.token = token, .string = (value_type == STRING) ? lexeme : NULL}};
+    return ast;
+}
+
+static AST *fold_binary(Arena *arena, AST *ast)
+{
+    AST *left = ast->data.AST_BINARY_EXPR.left;
+    AST *right = ast->data.AST_BINARY_EXPR.right;
+    Token *operator = ast->data.AST_BINARY_EXPR.token;
+
+    if(is_constant(left) && is_constant(right)) {
+        if(!can_fold_binary(operator, left->data.token, right->data.token)) return ast;
+        ValueTagged *value = value_binary(operator, value_from_token(left->data.token), value_from_token(right->data.token));
+        return (value == NULL) ? ast : constant_node(arena, operator, value);
+    }
+
+    /* Identities keep operand only if it is numeric, so type and runtime errors do not change */
+    switch(operator->type) {
+        case ADD:
+            if(is_integer_literal(right, 0) && is_numeric(left)) return left;
+            if(is_integer_literal(left, 0) && is_numeric(right)) return right;
+            break;
+        case SUBTRACT:
+            if(is_integer_literal(right, 0) && is_numeric(left)) return left;
+            break;
+        case MULTIPLY:
+            if(is_integer_literal(right, 1) && is_numeric(left)) return left;
+            if(is_integer_literal(left, 1) && is_numeric(right)) return right;
+            break;
+        default:
+            break;
+    }
+    return ast;
+}
+
+static AST *fold(Arena *arena, AST *ast)
+{
+    if(ast == NULL) return NULL;
+
+    switch(ast->tag) {
+        case AST_VAR_DECL_STMT:
+            ast->data.AST_VAR_DECL_STMT.init = fold(arena, ast->data.AST_VAR_DECL_STMT.init);
+            return ast;
+        case AST_FUNCT_DECL_STMT:
+            fold_list(arena, ast->data.AST_FUNCT_DECL_STMT.stmt_list, ast->data.AST_FUNCT_DECL_STMT.stmt_num);
+            return ast;
+        case AST_EXPR_STMT:
+        case AST_ECHO_STMT:
+        case AST_RETURN_STMT:
+            ast->data.AST_EXPR_STMT.expr = fold(arena, ast->data.AST_EXPR_STMT.expr);
+            return ast;
+        case AST_BLOCK_STMT:
+            fold_list(arena, ast->data.AST_BLOCK_STMT.stmt_list, ast->data.AST_BLOCK_STMT.stmt_num);
+            return ast;
+        case AST_IF_STMT:
+            ast->data.AST_IF_STMT.condition = fold(arena, ast->data.AST_IF_STMT.condition);
+            ast->data.AST_IF_STMT.true_branch = fold(arena, ast->data.AST_IF_STMT.true_branch);
+            ast->data.AST_IF_STMT.else_branch = fold(arena, ast->data.AST_IF_STMT.else_branch);
+            return ast;
+        case AST_WHILE_STMT:
+            ast->data.AST_WHILE_STMT.condition = fold(arena, ast->data.AST_WHILE_STMT.condition);
+            ast->data.AST_WHILE_STMT.body = fold(arena, ast->data.AST_WHILE_STMT.body);
+            return ast;
+        case AST_FOR_STMT:
+            ast->data.AST_FOR_STMT.initializer = fold(arena, ast->data.AST_FOR_STMT.initializer);
+            ast->data.AST_FOR_STMT.condition = fold(arena, ast->data.AST_FOR_STMT.condition);
+            ast->data.AST_FOR_STMT.increment = fold(arena, ast->data.AST_FOR_STMT.increment);
+            ast->data.AST_FOR_STMT.body = fold(arena, ast->data.AST_FOR_STMT.body);
+            return ast;
+        case AST_RUN_STMT:
+            fold_list(arena, ast->data.AST_RUN_STMT.args_list, ast->data.AST_RUN_STMT.arg_num);
+            return ast;
+        case AST_CALL_EXPR:
+            fold_list(arena, ast->data.AST_CALL_EXPR.stmt_list, ast->data.AST_CALL_EXPR.stmt_num);
+            return ast;
+        case AST_ASSIGN_EXPR:
+            ast->data.AST_ASSIGN_EXPR.expr = fold(arena, ast->data.AST_ASSIGN_EXPR.expr);
+            return ast;
+        case AST_GROUPING_EXPR:
+            /* Grouping only affects parsing */
+            return fold(arena, ast->data.AST_GROUPING_EXPR.left);
+        case AST_UNARY_EXPR:
+        {
+            AST *right = fold(arena, ast->data.AST_UNARY_EXPR.right);
+            Token *operator = ast->data.AST_UNARY_EXPR.token;
+            ast->data.AST_UNARY_EXPR.right = right;
+            if(!is_constant(right) || !can_fold_unary(operator, right->data.token)) return ast;
+
+            ValueTagged *value = value_unary(operator, value_from_token(right->data.token));
+            return (value == NULL) ? ast : constant_node(arena, operator, value);
+        }
+        case AST_LOGICAL_EXPR:
+        {
+            AST *left = fold(arena, ast->data.AST_LOGICAL_EXPR.left);
+            ast->data.AST_LOGICAL_EXPR.left = left;
+            ast->data.AST_LOGICAL_EXPR.right = fold(arena, ast->data.AST_LOGICAL_EXPR.right);
+            if(!is_constant(left)) return ast;
+
+            /* Logical expression evaluates to left operand when it decides the result */
+            int truth = constant_truth(left);
+            if(ast->data.AST_LOGICAL_EXPR.token->type == DOUBLE_OR) 
+                return (truth) ? left : ast->data.AST_LOGICAL_EXPR.right;
+            return (truth) ? ast->data.AST_LOGICAL_EXPR.right : left;
+        }
+        case AST_BINARY_EXPR:
+            ast->data.AST_BINARY_EXPR.left = fold(arena, ast->data.AST_BINARY_EXPR.left);
+            ast->data.AST_BINARY_EXPR.right = fold(arena, ast->data.AST_BINARY_EXPR.right);
+            return fold_binary(arena, ast);
+        case AST_LITERAL:
+            /* String literal is made once, every evaluation shares it instead of copying lexeme */
+            if(ast->data.token->type == STRING && ast->data.AST_LITERAL.string == NULL) {
+                char *lexeme = token_lexeme(ast->data.token);
+                ast->data.AST_LITERAL.string = string_static(arena, lexeme, strlen(lexeme));
+            }
+            return ast;
+        default:
+            return ast;
+    }
+}
+
+static void fold_list(Arena *arena, AST **list, const size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+        list[i] = fold(arena, list[i]);
+}
+
+static int constant_truth(const AST *ast)
+{
+    ValueTagged *value = value_from_token(ast->data.token);
+    int truth = value_is_truth(value);
+    free_value(value);
+    return truth;
+}
+
+static int declares_name(const AST *ast)
+{
+    return ast->tag == AST_VAR_DECL_STMT || ast->tag == AST_FUNCT_DECL_STMT;
+}
+
+static AST *empty_block(Arena *arena, AST *ast)
+{
+    if(ast == NULL || ast->tag != AST_BLOCK_STMT) {
+        ast = arena_alloc(arena, sizeof(AST));
+        ast->tag = AST_BLOCK_STMT;
+        ast->data.AST_BLOCK_STMT.stmt_list = NULL;
+    }
+    ast->data.AST_BLOCK_STMT.stmt_num = 0;
+    ast->data.AST_BLOCK_STMT.slot_num = 0;
+    return ast;
+}
+
+static AST *prune(Arena *arena, AST *ast)
+{
+    if(ast == NULL) return NULL;
+
+    switch(ast->tag) {
+        case AST_FUNCT_DECL_STMT:
+            ++prune_function_depth;
+            ast->data.AST_FUNCT_DECL_STMT.stmt_num = prune_list(arena, ast->data.AST_FUNCT_DECL_STMT.stmt_list, 
+                                                                ast->data.AST_FUNCT_DECL_STMT.stmt_num);
+            --prune_function_depth;
+            return ast;
+        case AST_BLOCK_STMT:
+        {
+            size_t stmt_num = prune_list(arena, ast->data.AST_BLOCK_STMT.stmt_list, ast->data.AST_BLOCK_STMT.stmt_num);
+            ast->data.AST_BLOCK_STMT.stmt_num = stmt_num;
+            if(stmt_num == 0) return NULL;
+            /* Block with single statement that declares nothing does not need its own environment */
+            if(stmt_num == 1 && !declares_name(ast->data.AST_BLOCK_STMT.stmt_list[0])) return ast->data.AST_BLOCK_STMT.stmt_list[0];
+            return ast;
+        }
+        case AST_IF_STMT:
+        {
+            AST *condition = ast->data.AST_IF_STMT.condition;
+            if(is_constant(condition)) 
+                return prune(arena, (constant_truth(condition)) ? ast->data.AST_IF_STMT.true_branch : ast->data.AST_IF_STMT.else_branch);
+
+            ast->data.AST_IF_STMT.true_branch = prune_body(arena, ast->data.AST_IF_STMT.true_branch);
+            ast->data.AST_IF_STMT.else_branch = prune(arena, ast->data.AST_IF_STMT.else_branch);
+            return ast;
+        }
+        case AST_WHILE_STMT:
+            if(is_constant(ast->data.AST_WHILE_STMT.condition) && !constant_truth(ast->data.AST_WHILE_STMT.condition)) return NULL;
+            ast->data.AST_WHILE_STMT.body = prune_body(arena, ast->data.AST_WHILE_STMT.body);
+            return ast;
+        case AST_FOR_STMT:
+        {
+            /* Initializer still runs once when condition is false, declared loop variable keeps whole loop */
+            AST *initializer = ast->data.AST_FOR_STMT.initializer;
+            AST *condition = ast->data.AST_FOR_STMT.condition;
+            if(is_constant(condition) && !constant_truth(condition) && (initializer == NULL || !declares_name(initializer)))
+                return initializer;
+            ast->data.AST_FOR_STMT.body = prune_body(arena, ast->data.AST_FOR_STMT.body);
+            return ast;
+        }
+        default:
+            return ast;
+    }
+}
+
+static AST *prune_body(Arena *arena, AST *ast)
+{
+    AST *pruned = prune(arena, ast);
+    return (pruned == NULL) ? empty_block(arena, ast) : pruned;
+}
+
+static size_t prune_list(Arena *arena, AST **list, const size_t count)
+{
+    size_t kept = 0;
+
+    for(size_t i = 0; i < count; ++i) {
+        AST *pruned = prune(arena, list[i]);
+        if(pruned == NULL) continue;
+        list[kept++] = pruned;
+        if(prune_function_depth && pruned->tag == AST_RETURN_STMT) break;
+    }
+    return kept;
+}
+
+extern size_t ast_optimize(AST **ast, const size_t number_of_statements, Arena *arena)
+{
+    size_t before = 0, after = 0;
+
+    for(size_t i = 0; i < number_of_statements; ++i) {
+        before += ast_count(ast[i]);
+        ast[i] = prune(arena, fold(arena, ast[i]));
+        after += ast_count(ast[i]);
+    }
+
+    TRACE(TRACE_PARSER, "Constant folding and dead code elimination removed %zu of %zu AST nodes\n", before - after, before);
+    return before - after;
+}
@@ -0,0 +1,98 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#define FOLD_LEXEME_SIZE 32
+
+/*@Function: ast_count
+*Helper Function: Returns number of nodes in AST */
+static size_t ast_count(AST *);
+
+/*@Function: is_constant
+*Helper Function: Returns TRUE if node is literal that can be folded, null literal is not folded */
+static int is_constant(const AST *);
+
+/*@Function: is_numeric
+*Helper Function: Returns TRUE if node always evaluates to int or float or raises runtime error */
+static int is_numeric(const AST *);
+
+/*@Function: is_integer_literal
+*Helper Function: Returns TRUE if node is integer literal equal to given value */
+static int is_integer_literal(const AST *, const long long int);
+
+/*@Function: can_fold_unary
+*Helper Function: Returns TRUE if unary operator on constant can not raise runtime error */
+static int can_fold_unary(const Token *, const Token *);
+
+/*@Function: can_fold_binary
+*Helper Function: Returns TRUE if binary operator on constants can not raise runtime error */
+static int can_fold_binary(const Token *, const Token *, const Token *);
+
+/*@Function: constant_node
+*Helper Function: Returns literal node in arena holding value, token of node is made from operator token */
+static AST *constant_node(Arena *, const Token *, ValueTagged *);
+
+/*@Function: fold_binary
+*Helper Function: Folds binary node with folded operands or simplifies identity, returns replacement node */
+static AST *fold_binary(Arena *, AST *);
+
+/*@Function: fold
+*Helper Function: Folds node and its children, returns node that replaces it */
+static AST *fold(Arena *, AST *);
+
+/*@Function: fold_list
+*Helper Function: Folds every node of list in place */
+static void fold_list(Arena *, AST **, const size_t);
+
+/*@Function: constant_truth
+*Helper Function: Returns truth value of constant literal node */
+static int constant_truth(const AST *);
+
+/*@Function: declares_name
+*Helper Function: Returns TRUE if statement defines variable or function in environment it runs in */
+static int declares_name(const AST *);
+
+/*@Function: empty_block
+*Helper Function: Returns block without statements, node is reused when it already is block */
+static AST *empty_block(Arena *, AST *);
+
+/*@Function: prune
+*Helper Function: Removes unreachable statements and branches with constant conditions, returns node that replaces statement or NULL when statement has no effect */
+static AST *prune(Arena *, AST *);
+
+/*@Function: prune_body
+*Helper Function: Prunes statement that can not be missing, empty block replaces removed statement */
+static AST *prune_body(Arena *, AST *);
+
+/*@Function: prune_list
+*Helper Function: Prunes every statement of list and compacts it, statements after return in function are dropped, returns new number of statements */
+static size_t prune_list(Arena *, AST **, const size_t);
+
+/*@Function: ast_optimize
+*Function that folds constant expressions and identities of statements and removes dead code, new nodes are allocated in arena, removed top level statements are set to NULL, returns number of removed nodes */
+extern size_t ast_optimize(AST **, const size_t, Arena *);
+
+#endif // OPTIMIZER_H
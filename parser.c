@@ -27,9 +27,51 @@ SOFTWARE.
 #include <setjmp.h>
 #include "coretypes.h"
 #include "error.h"
+#include "lexer.h"
+#include "arena.h"
+#include "trace.h"
 #include "parser.h"
 
-static jmp_buf sync_env;
+/* Parser state is per thread, frontend_parse runs one parser per chunk */
+static _Thread_local jmp_buf sync_env;
+
+/* Arena of compilation unit that is being parsed, owns all AST nodes and lists */
+static _Thread_local Arena *ast_arena = NULL;
+
+/* Closing brace of function body parsed by parser_function_body, panic mode does not synchronize past it */
+static _Thread_local Token *body_end = NULL;
+
+/* Flags of every token type, synchronize stops at tokens marked with TOKEN_SYNC */
+static const unsigned char token_flags[TOKEN_TYPE_COUNT] = {
+#define SPECIAL_TOKEN(type, character, flags) [type] = flags,
+#define OPERATOR_TOKEN(type, first, second, flags) [type] = flags,
+#define TOKEN(type, flags) [type] = flags,
+#define RESERVED_WORD(type, word, flags) [type] = flags,
+#include "tokens.def"
+};
+
+/* Binding powers of expression operators, new operator needs only an entry here and its evaluation */
+static const OperatorRule operator_rules[TOKEN_TYPE_COUNT] = {
+    [DOUBLE_OR]                            = {0,         BP_OR,          AST_LOGICAL_EXPR},
+    [DOUBLE_AND]                           = {0,         BP_AND,         AST_LOGICAL_EXPR},
+    [PIPE]                                 = {0,         BP_BITWISE_OR,  AST_BINARY_EXPR},
+    [AND]                                  = {0,         BP_BITWISE_AND, AST_BINARY_EXPR},
+    [DOUBLE_EQUAL]                         = {0,         BP_EQUALITY,    AST_BINARY_EXPR},
+    [EXCLAMATION_EQUEAL]                   = {0,         BP_EQUALITY,    AST_BINARY_EXPR},
+    [REDIRECTION_LEFT_LESS_RELATIONAL]     = {0,         BP_COMPARISON,  AST_BINARY_EXPR},
+    [LESS_EQUAL]                           = {0,         BP_COMPARISON,  AST_BINARY_EXPR},
+    [REDIRECTION_RIGHT_GREATER_RELATIONAL] = {0,         BP_COMPARISON,  AST_BINARY_EXPR},
+    [GREATER_EQUAL]                        = {0,         BP_COMPARISON,  AST_BINARY_EXPR},
+    [SHIFT_LEFT]                           = {0,         BP_SHIFT,       AST_BINARY_EXPR},
+    [SHIFT_RIGHT]                          = {0,         BP_SHIFT,       AST_BINARY_EXPR},
+    [ADD]                                  = {0,         BP_TERM,        AST_BINARY_EXPR},
+    [SUBTRACT]                             = {BP_UNARY,  BP_TERM,        AST_BINARY_EXPR},
+    [MULTIPLY]                             = {0,         BP_FACTOR,      AST_BINARY_EXPR},
+    [DIVIDE]                               = {0,         BP_FACTOR,      AST_BINARY_EXPR},
+    [MODULUS]                              = {0,         BP_FACTOR,      AST_BINARY_EXPR},
+    [EXCLAMATION]                          = {BP_UNARY,  0,              0},
+    [XOR]                                  = {BP_UNARY,  0,              0},
+};
 
 static int next_position(size_t *current_position, Token *token_list) 
 {
@@ -37,334 +79,203 @@ static int next_position(size_t *current_position, Token *token_list)
         return 1;
         
     (*current_position)++;
-    printf("New position %d, token %s\n", (*current_position), token_list[*current_position].lexeme);
+    TRACE(TRACE_PARSER, "New position %zu, token %s\n", (*current_position), token_lexeme(&token_list[*current_position]));
     return 0;
 }
 
 static AST *ast_new(AST ast) 
 {
-    AST *ast_ptr = malloc(sizeof(AST));
-    if(ast_ptr) *ast_ptr = ast;
-    else
-        error("ast_new failed to allocate memory!", __FILE__, __LINE__);
+    AST *ast_ptr = arena_alloc(ast_arena, sizeof(AST));
+    *ast_ptr = ast;
     return ast_ptr;
 }
 
+static AST **ast_list_push(AST **list, const size_t count, AST *item)
+{
+    /* Capacity is the next power of two, grow when list is full */
+    if((count & (count - 1)) == 0)
+        list = arena_grow(ast_arena, list, sizeof(AST *) * count, sizeof(AST *) * (count ? 2 * count : 1));
+    list[count] = item;
+    return list;
+}
+
 extern void ast_print(AST *ast) 
 {
     if(!ast) {
-        fprintf(stderr, "Error! AST IS NULL!\n");
+        trace_printf("Error! AST IS NULL!\n");
         return;
     }
 
     switch(ast->tag) {
         case AST_VAR_DECL_STMT:
         {
-            fprintf(stdout, "Variable Declaration Statement Node: %s\n", ast->data.AST_VAR_DECL_STMT.name->lexeme);
+            trace_printf("Variable Declaration Statement Node: %s\n", token_lexeme(ast->data.AST_VAR_DECL_STMT.name));
             ast_print(ast->data.AST_VAR_DECL_STMT.init);
             break;
         }
         case AST_FUNCT_DECL_STMT:
         {
-            fprintf(stdout, "Function Declaration Statement Node: %s\n", ast->data.AST_FUNCT_DECL_STMT.name->lexeme);
-            fprintf(stdout, "Function Declaration Statement parameters: \n");
+            trace_printf("Function Declaration Statement Node: %s\n", token_lexeme(ast->data.AST_FUNCT_DECL_STMT.name));
+            trace_printf("Function Declaration Statement parameters: \n");
             for(size_t i = 0; i < ast->data.AST_FUNCT_DECL_STMT.param_num; ++i)
                 ast_print(ast->data.AST_FUNCT_DECL_STMT.parameters[i]);
-            fprintf(stdout, "Function Declaration Statement block: \n");
+            trace_printf("Function Declaration Statement block: \n");
             for(size_t i = 0; i < ast->data.AST_FUNCT_DECL_STMT.stmt_num; ++i)
                 ast_print(ast->data.AST_FUNCT_DECL_STMT.stmt_list[i]);
             break;
         }
         case AST_EXPR_STMT: 
         {
-            fprintf(stdout, "Expression Statement Node.\n");
+            trace_printf("Expression Statement Node.\n");
             ast_print(ast->data.AST_EXPR_STMT.expr);
             break;
         }
         case AST_BLOCK_STMT:
         {
-            fprintf(stdout, "Block Statement Node.\n");
+            trace_printf("Block Statement Node.\n");
             for(size_t i = 0; i < ast->data.AST_BLOCK_STMT.stmt_num; ++i)
                 ast_print(ast->data.AST_BLOCK_STMT.stmt_list[i]);
             break;
         }
         case AST_IF_STMT:
         {
-            fprintf(stdout, "If statement Node.\n");
-            fprintf(stdout, "Condition AST:\n");
+            trace_printf("If statement Node.\n");
+            trace_printf("Condition AST:\n");
             ast_print(ast->data.AST_IF_STMT.condition);
-            fprintf(stdout, "True Branch AST:\n");
+            trace_printf("True Branch AST:\n");
             ast_print(ast->data.AST_IF_STMT.true_branch);
-            fprintf(stdout, "Else Branch AST:\n");
+            trace_printf("Else Branch AST:\n");
             if(ast->data.AST_IF_STMT.else_branch != NULL)
                 ast_print(ast->data.AST_IF_STMT.else_branch);
             break;
         }
         case AST_WHILE_STMT:
         {
-            fprintf(stdout, "While statement Node.\n");
-            fprintf(stdout, "Condition AST:\n");
+            trace_printf("While statement Node.\n");
+            trace_printf("Condition AST:\n");
             ast_print(ast->data.AST_WHILE_STMT.condition);
-            fprintf(stdout, "True Branch AST:\n");
+            trace_printf("True Branch AST:\n");
             if(ast->data.AST_WHILE_STMT.body != NULL)
                 ast_print(ast->data.AST_WHILE_STMT.body);
             break;
         }        
         case AST_FOR_STMT:
         {
-            fprintf(stdout, "For Statement Node.\n");
-            fprintf(stdout, "Init node ast:\n");
+            trace_printf("For Statement Node.\n");
+            trace_printf("Init node ast:\n");
             if(ast->data.AST_FOR_STMT.initializer != NULL)
                 ast_print(ast->data.AST_FOR_STMT.initializer);
             else
-                fprintf(stdout, "Init Node is NULL\n");
+                trace_printf("Init Node is NULL\n");
  
-            fprintf(stdout, "Condition node ast:\n");
+            trace_printf("Condition node ast:\n");
             if(ast->data.AST_FOR_STMT.condition != NULL)
                 ast_print(ast->data.AST_FOR_STMT.condition);
             else
-                fprintf(stdout, "condition Node is NULL\n");
+                trace_printf("condition Node is NULL\n");
 
-            fprintf(stdout, "Increment node ast:\n");
+            trace_printf("Increment node ast:\n");
             if(ast->data.AST_FOR_STMT.increment != NULL)
                 ast_print(ast->data.AST_FOR_STMT.increment);
             else
-                fprintf(stdout, "Increment Node is NULL\n");
+                trace_printf("Increment Node is NULL\n");
 
-            fprintf(stdout, "Body node ast:\n");
+            trace_printf("Body node ast:\n");
             ast_print(ast->data.AST_FOR_STMT.body);
         }
         case AST_ECHO_STMT: 
         {
-            fprintf(stdout, "echo statement Node.\n");
+            trace_printf("echo statement Node.\n");
             ast_print(ast->data.AST_ECHO_STMT.expr);
             break;
         }
         case AST_RETURN_STMT:
         {
-            fprintf(stdout, "Return statement Node.\n");
+            trace_printf("Return statement Node.\n");
             ast_print(ast->data.AST_RETURN_STMT.expr);
             break;
         }
         case AST_TIME_STMT:
         {
-            fprintf(stdout, "Time statement Node.\n");
+            trace_printf("Time statement Node.\n");
             break;
         }
         case AST_CLEAR_STMT:
         {
-            fprintf(stdout, "Clear statement Node.\n");
+            trace_printf("Clear statement Node.\n");
             break;
         }
         case AST_CD_STMT: 
         {
-            fprintf(stdout, "cd statement Node.\n");
+            trace_printf("cd statement Node.\n");
             ast_print(ast->data.AST_CD_STMT.expr);
             break;
         }
         case AST_RUN_STMT:
         {     
-            fprintf(stdout, "run statement node\n");
+            trace_printf("run statement node\n");
             if(ast->data.AST_RUN_STMT.program_name != NULL)
-                fprintf(stdout, "Program name: %s\n", ast->data.AST_RUN_STMT.program_name->lexeme);
+                trace_printf("Program name: %s\n", token_lexeme(ast->data.AST_RUN_STMT.program_name));
             for(size_t i = 0; i < ast->data.AST_RUN_STMT.arg_num; ++i)
                 ast_print(ast->data.AST_RUN_STMT.args_list[i]);
             break;
         }
         case AST_ASSIGN_EXPR:
         {
-            fprintf(stdout, "Assignment Expression Node: %s\n", ast->data.AST_ASSIGN_EXPR.token->lexeme);
+            trace_printf("Assignment Expression Node: %s\n", token_lexeme(ast->data.AST_ASSIGN_EXPR.token));
             ast_print(ast->data.AST_ASSIGN_EXPR.expr);
             break;               
         }
         case AST_BINARY_EXPR:
         {
-            fprintf(stdout, "Binary Node: %s\n", ast->data.AST_BINARY_EXPR.token->lexeme);
+            trace_printf("Binary Node: %s\n", token_lexeme(ast->data.AST_BINARY_EXPR.token));
             ast_print(ast->data.AST_BINARY_EXPR.left);
             ast_print(ast->data.AST_BINARY_EXPR.right);
             break;
         }
         case AST_CALL_EXPR:
         {
-            fprintf(stdout, "Call Expr node: \n");
+            trace_printf("Call Expr node: \n");
             ast_print(ast->data.AST_CALL_EXPR.callee);
             for(size_t i = 0; i < ast->data.AST_CALL_EXPR.stmt_num; ++i) {
-                fprintf(stdout, "Argument %d:\n", i);
+                trace_printf("Argument %d:\n", i);
                 ast_print(ast->data.AST_CALL_EXPR.stmt_list[i]);
             }
             break;
         } 
         case AST_UNARY_EXPR:
         {
-            fprintf(stdout, "Unary Node: %s\n", ast->data.AST_UNARY_EXPR.token->lexeme);
+            trace_printf("Unary Node: %s\n", token_lexeme(ast->data.AST_UNARY_EXPR.token));
             ast_print(ast->data.AST_UNARY_EXPR.right);
             break;
         }
         case AST_IDENTIFIER:
         {
-            fprintf(stdout, "Identifier node: %s\n", ast->data.token->lexeme);
+            trace_printf("Identifier node: %s\n", token_lexeme(ast->data.token));
             break;
         }
         case AST_LITERAL:
         {
-            fprintf(stdout, "Literal Node: %s\n", ast->data.token->lexeme);
-            break;
-        }
-        default:
-            fprintf(stderr, "Error! Cannot print AST node: %s\n", ast->data.token->lexeme);
-            break;
-    }
-}
-
-extern void ast_free(AST *ast) 
-{
-    if(!ast) {
-        fprintf(stderr, "%s: %d Error: Cannot free AST: %s\n", __FILE__, __LINE__, ast->data.token->lexeme);
-        return;
-    }
-    switch(ast->tag) {
-        case AST_VAR_DECL_STMT:
-        {
-            if(ast->data.AST_VAR_DECL_STMT.init != NULL)
-                ast_free(ast->data.AST_VAR_DECL_STMT.init);
-            break;
-        }
-        case AST_FUNCT_DECL_STMT:
-        {
-            for(size_t i = 0; i < ast->data.AST_FUNCT_DECL_STMT.param_num; ++i)
-                ast_free(ast->data.AST_FUNCT_DECL_STMT.parameters[i]);
-            if(ast->data.AST_FUNCT_DECL_STMT.parameters != NULL)
-                free(ast->data.AST_FUNCT_DECL_STMT.parameters);
-            for(size_t i = 0; i < ast->data.AST_FUNCT_DECL_STMT.stmt_num; ++i)
-                ast_free(ast->data.AST_FUNCT_DECL_STMT.stmt_list[i]);
-            if(ast->data.AST_FUNCT_DECL_STMT.stmt_list != NULL)
-                free(ast->data.AST_FUNCT_DECL_STMT.stmt_list);
-            break;
-        }
-        case AST_EXPR_STMT: 
-        {
-            ast_free(ast->data.AST_EXPR_STMT.expr);
-            break;
-        }
-        case AST_BLOCK_STMT:
-        {
-            for(size_t i = 0; i < ast->data.AST_BLOCK_STMT.stmt_num; ++i)
-                ast_free(ast->data.AST_BLOCK_STMT.stmt_list[i]);
-            free(ast->data.AST_BLOCK_STMT.stmt_list);
-            break;
-        }
-        case AST_IF_STMT:
-        {
-            ast_free(ast->data.AST_IF_STMT.condition);
-            ast_free(ast->data.AST_IF_STMT.true_branch);
-            if(ast->data.AST_IF_STMT.else_branch != NULL) 
-                ast_free(ast->data.AST_IF_STMT.else_branch);  
-            break; 
-        }
-        case AST_WHILE_STMT:
-        {
-            if(ast->data.AST_WHILE_STMT.condition != NULL)
-                ast_free(ast->data.AST_WHILE_STMT.condition);
-            if(ast->data.AST_WHILE_STMT.body != NULL)
-                ast_free(ast->data.AST_WHILE_STMT.body);
-            break;
-        }
-        case AST_FOR_STMT:
-        {
-            if(ast->data.AST_FOR_STMT.initializer != NULL)
-                ast_free(ast->data.AST_FOR_STMT.initializer);
-            if(ast->data.AST_FOR_STMT.condition != NULL)
-                ast_free(ast->data.AST_FOR_STMT.condition);
-            if(ast->data.AST_FOR_STMT.increment != NULL)
-                ast_free(ast->data.AST_FOR_STMT.increment);
-            ast_free(ast->data.AST_FOR_STMT.body);
-            break;
-        } 
-        case AST_ECHO_STMT: 
-        {
-            ast_free(ast->data.AST_ECHO_STMT.expr);
-            break;
-        }
-        case AST_RETURN_STMT:
-        {
-            ast_free(ast->data.AST_RETURN_STMT.expr);
-            break;
-        }
-        case AST_CD_STMT: 
-        {
-            if(ast->data.AST_CD_STMT.expr != NULL)
-                ast_free(ast->data.AST_CD_STMT.expr);
-            break;
-        }
-        case AST_RUN_STMT:
-        {     
-            for(size_t i = 0; i < ast->data.AST_RUN_STMT.arg_num; ++i)
-                ast_free(ast->data.AST_RUN_STMT.args_list[i]);
-            if(ast->data.AST_RUN_STMT.args_list != NULL)
-                free(ast->data.AST_RUN_STMT.args_list);
-            break;
-        }
-        /* AST_TIME_STMT is default deallocation */
-        /* AST_CLEAR_STMT is default deallocation */
-        case AST_ASSIGN_EXPR:
-        {
-            ast_free(ast->data.AST_ASSIGN_EXPR.expr);
-            break;               
-        }
-        case AST_BINARY_EXPR: 
-        {
-            ast_free(ast->data.AST_BINARY_EXPR.left);
-            ast_free(ast->data.AST_BINARY_EXPR.right);
-            break;
-        }
-        case AST_CALL_EXPR:
-        {
-            for(size_t i = 0; i < ast->data.AST_CALL_EXPR.stmt_num; ++i)
-                ast_free(ast->data.AST_CALL_EXPR.stmt_list[i]);
-            if(ast->data.AST_CALL_EXPR.stmt_list != NULL) {
-                free(ast->data.AST_CALL_EXPR.stmt_list);
-            }
-            ast_free(ast->data.AST_CALL_EXPR.callee);
-            break;
-        }
-        case AST_UNARY_EXPR: 
-        {
-            ast_free(ast->data.AST_UNARY_EXPR.right);
-            break;
-        }
-        case AST_GROUPING_EXPR:
-        {
-            ast_free(ast->data.AST_GROUPING_EXPR.left);
+            trace_printf("Literal Node: %s\n", token_lexeme(ast->data.token));
             break;
         }
         default:
+            fprintf(stderr, "Error! Cannot print AST node: %s\n", token_lexeme(ast->data.token));
             break;
     }
-    free(ast);
 }
 
 static void synchronize(Token *token_list, size_t *token_position) 
 {
-    while(!next_position(token_position, token_list)) {
-       switch(token_list[*token_position].type) {
-            case SEMICOLON:
-            case FUNCT:
-            case CLASS:
-            case STRUCT:
-            case VAR:
-            case FOR:
-            case IF:
-            case WHILE:
-            case ECHO:
-            case EXEC:
-            case CD:
-            case TIME:
-            case CLEAR:
-                return;
-        } 
+    while(&token_list[*token_position] != body_end) {
+        if(next_position(token_position, token_list)) {
+            // set token_position to EOF_TOKEN
+            (*token_position)++;
+            return;
+        }
+        if(&token_list[*token_position] == body_end || token_flags[token_list[*token_position].type] & TOKEN_SYNC)
+            return;
     }
-    // set token_position to EOF_TOKEN
-    (*token_position)++;
 }
 
 static void panic_mode(Token *token_list, size_t *token_position) 
@@ -385,7 +296,7 @@ static AST *primary(Token *token_list, size_t *token_position, AST *ast)
         {
             ast = ast_new((AST){
                 .tag = AST_LITERAL,
-                .data.token = &token_list[*token_position]});
+                .data.AST_LITERAL = {.token = &token_list[*token_position], .string = NULL}});
             next_position(token_position, token_list);
             return ast;
         }
@@ -395,14 +306,14 @@ static AST *primary(Token *token_list, size_t *token_position, AST *ast)
         {
              ast = ast_new((AST){
                 .tag = AST_LITERAL,
-                .data.token = &token_list[*token_position]}); 
+                .data.AST_LITERAL = {.token = &token_list[*token_position], .string = NULL}}); 
             next_position(token_position, token_list);
             return ast;
         }
         case LEFT_PARENTHESIS:
         {
             if (next_position(token_position, token_list)) {
-                parser_error(token_list[*token_position], "Unclosed paranthesis");
+                parser_error(&token_list[*token_position], "Unclosed paranthesis");
                 longjmp(sync_env, 1);
                 break;  
             }
@@ -411,24 +322,26 @@ static AST *primary(Token *token_list, size_t *token_position, AST *ast)
                 next_position(token_position, token_list);
                 return ast;
             }
+            parser_error(&token_list[*token_position], "Expected ')' after expression.");
+            panic_mode(token_list, token_position);
         }
         case IDENTIFIER:
         {
             ast = ast_new((AST){
                 .tag = AST_IDENTIFIER,
-                .data.token = &token_list[*token_position]}); 
+                .data.AST_IDENTIFIER = {&token_list[*token_position], 0, RESOLVE_BY_NAME}}); 
             next_position(token_position, token_list);
             return ast;           
         }
         case ADD: case SUBTRACT: case MULTIPLY: case DIVIDE:
         {
-            parser_error(token_list[*token_position], "could not parse such token. Expected right operator.");
+            parser_error(&token_list[*token_position], "could not parse such token. Expected right operator.");
             panic_mode(token_list, token_position);
         }
         default:
             break;
     }
-    parser_error(token_list[*token_position], "could not parse such token. Expect expression.");
+    parser_error(&token_list[*token_position], "could not parse such token. Expect expression.");
     panic_mode(token_list, token_position);
     return NULL;
 }
@@ -445,8 +358,8 @@ static AST *call(Token *token_list, size_t *token_position, AST *ast)
 
         if(token_list[*token_position].type != RIGHT_PARENTHESIS) {
             do {
-                args = realloc(args, sizeof(AST *) * (stmt_num + 1));
-                args[stmt_num++] = expression(token_list, token_position, expr);
+                args = ast_list_push(args, stmt_num, expression(token_list, token_position, expr));
+                stmt_num++;
                 if(stmt_num >= MAX_ARG_CNT) {TODO("Add error later!");}
             } while(token_list[*token_position].type == COMMA && !next_position(token_position, token_list));
             
@@ -469,136 +382,47 @@ static AST *call(Token *token_list, size_t *token_position, AST *ast)
     return ast;
 }
 
-static AST *unary(Token *token_list, size_t *token_position, AST *ast) 
-{
-    if(token_list[*token_position].type == SUBTRACT    ||
-       token_list[*token_position].type == EXCLAMATION ||
-       token_list[*token_position].type == XOR) 
-    {
-        Token *operator = &token_list[*token_position];
-        if(next_position(token_position, token_list)) {
-            parser_error(*operator, "Missing right operator!\n");
-            panic_mode(token_list, token_position);
-            return ast; 
-        }
-        AST *right = unary(token_list, token_position, ast);
-        ast = ast_new((AST)
-            {
-                .tag = AST_UNARY_EXPR,
-                .data.AST_UNARY_EXPR = {
-                    right,
-                    operator,
-                }
-            }
-        );
-        return ast;
-    }
-    return call(token_list, token_position, ast);
-}
-
-static AST *factor(Token *token_list, size_t *token_position, AST *ast) 
-{
-    ast = unary(token_list, token_position, ast);
-
-    while(token_list[*token_position].type == DIVIDE  ||
-          token_list[*token_position].type == MULTIPLY)
-    {
-        Token *operator = &token_list[*token_position];
-        if(next_position(token_position, token_list)) {
-            parser_error(*operator, "Missing right operator!\n");
-            panic_mode(token_list, token_position);
-            return ast; 
-        }
-        AST *right = unary(token_list, token_position, ast);
-        ast = ast_new((AST)
-            {
-                .tag = AST_BINARY_EXPR,
-                .data.AST_BINARY_EXPR = {
-                    ast,
-                    operator,
-                    right
-                }
-            }
-        );
-    }
-    return ast;
-}
-
-static AST *term(Token *token_list, size_t *token_position, AST *ast) 
+static AST *prefix(Token *token_list, size_t *token_position, AST *ast) 
 {
-    ast = factor(token_list, token_position, ast);
+    Token *operator = &token_list[*token_position];
+    if(!operator_rules[operator->type].prefix) 
+        return call(token_list, token_position, ast);
 
-    while(token_list[*token_position].type == ADD ||
-          token_list[*token_position].type == SUBTRACT)
-    {   
-        Token *operator = &token_list[*token_position];
-        if(next_position(token_position, token_list)) {
-            parser_error(*operator, "Missing right operator!\n");
-            panic_mode(token_list, token_position);
-            return ast; 
-        }
-        AST *right = factor(token_list, token_position, ast);
-        ast = ast_new((AST)
-            {
-                .tag = AST_BINARY_EXPR,
-                .data.AST_BINARY_EXPR = {
-                    ast,
-                    operator,
-                    right
-                }
-            }
-        );
+    if(next_position(token_position, token_list)) {
+        parser_error(operator, "Missing right operator!\n");
+        panic_mode(token_list, token_position);
+        return ast; 
     }
-    return ast;
-}
-
-static AST *comparison(Token *token_list, size_t *token_position, AST *ast) 
-{
-    ast = term(token_list, token_position, ast);
-
-    while(token_list[*token_position].type == REDIRECTION_LEFT_LESS_RELATIONAL ||
-          token_list[*token_position].type == LESS_EQUAL ||
-          token_list[*token_position].type == REDIRECTION_RIGHT_GREATER_RELATIONAL ||
-          token_list[*token_position].type == GREATER_EQUAL)
-    {
-        Token *operator = &token_list[*token_position];
-        if(next_position(token_position, token_list)) {
-            parser_error(*operator, "Missing right operator!\n");
-            panic_mode(token_list, token_position);
-            return ast; 
-        }    
-        AST *right = term(token_list, token_position, ast);
-        ast = ast_new((AST)
-            {
-                .tag = AST_BINARY_EXPR,
-                .data.AST_BINARY_EXPR = {
-                    ast,
-                    operator,
-                    right
-                }
+    AST *right = binding_power_expression(token_list, token_position, ast, operator_rules[operator->type].prefix);
+    ast = ast_new((AST)
+        {
+            .tag = AST_UNARY_EXPR,
+            .data.AST_UNARY_EXPR = {
+                right,
+                operator,
             }
-        );
-    }
+        }
+    );
     return ast;
 }
 
-static AST *equality(Token *token_list, size_t *token_position, AST *ast) 
+static AST *binding_power_expression(Token *token_list, size_t *token_position, AST *ast, const BindingPower min_power) 
 {
-    ast = comparison(token_list, token_position, ast);
+    ast = prefix(token_list, token_position, ast);
 
-    while(token_list[*token_position].type == EXCLAMATION_EQUEAL ||
-          token_list[*token_position].type == DOUBLE_EQUAL)
-    {
+    /* Left associative, right operand takes only operators that bind tighter than this one */
+    while(operator_rules[token_list[*token_position].type].infix > min_power) {
         Token *operator = &token_list[*token_position];
+        const OperatorRule *rule = &operator_rules[operator->type];
         if(next_position(token_position, token_list)) {
-            parser_error(*operator, "Missing right operator!\n");
+            parser_error(operator, "Missing right operator!\n");
             panic_mode(token_list, token_position);
             return ast; 
-        }         
-        AST *right = comparison(token_list, token_position, ast);
+        }
+        AST *right = binding_power_expression(token_list, token_position, ast, rule->infix);
         ast = ast_new((AST)
             {
-                .tag = AST_BINARY_EXPR,
+                .tag = rule->tag,
                 .data.AST_BINARY_EXPR = {
                     ast,
                     operator,
@@ -610,80 +434,28 @@ static AST *equality(Token *token_list, size_t *token_position, AST *ast)
     return ast;
 }
 
-static AST *logic_and(Token *token_list, size_t *token_postition, AST *ast) 
-{
-    ast = equality(token_list, token_postition, ast);
-
-    while(token_list[*token_postition].type == DOUBLE_AND) {
-        Token *operator = &token_list[*token_postition];
-        if(next_position(token_postition, token_list)) {
-            parser_error(*operator, "Missing right operator!\n");
-            panic_mode(token_list, token_postition);
-            return ast; 
-        }
-        AST *right = equality(token_list, token_postition, ast);
-        ast = ast_new((AST)
-            {
-                .tag = AST_LOGICAL_EXPR,
-                .data.AST_LOGICAL_EXPR = {
-                    ast,
-                    operator,
-                    right
-                }
-            }
-        );               
-    }
-    return ast;
-}
-
-static AST *logic_or(Token *token_list, size_t *token_postition, AST *ast) 
-{
-    ast = logic_and(token_list, token_postition, ast);
-
-    while(token_list[*token_postition].type == DOUBLE_OR) {
-        Token *operator = &token_list[*token_postition];
-        if(next_position(token_postition, token_list)) {
-            parser_error(*operator, "Missing right operator!\n");
-            panic_mode(token_list, token_postition);
-            return ast; 
-        }
-        AST *right = logic_and(token_list, token_postition, ast);
-        ast = ast_new((AST)
-            {
-                .tag = AST_LOGICAL_EXPR,
-                .data.AST_LOGICAL_EXPR = {
-                    ast,
-                    operator,
-                    right
-                }
-            }
-        );       
-    }
-    return ast;
-}
-
-static AST *assignment(Token *token_list, size_t *token_position, AST *ast) 
+static AST *expression(Token *token_list, size_t *token_position, AST *ast) 
 {
-    ast = logic_or(token_list, token_position, ast);
+    ast = binding_power_expression(token_list, token_position, ast, BP_ASSIGNMENT);
 
     if(token_list[*token_position].type == EQUAL) {
-        Token *equals = &token_list[*token_position];
-
         if(next_position(token_position, token_list)) {
-            parser_error(token_list[*token_position], "Expected expression after equals sign");
+            parser_error(&token_list[*token_position], "Expected expression after equals sign");
             panic_mode(token_list, token_position);
         }
-        AST *value = assignment(token_list, token_position, ast);
+        /* Assignment is right associative */
+        AST *value = expression(token_list, token_position, ast);
         
         if(ast->tag == AST_IDENTIFIER) {
             Token *name = ast->data.token;
-            ast_free(ast); 
             ast = ast_new((AST)
                 {  
                     .tag = AST_ASSIGN_EXPR,
                     .data.AST_ASSIGN_EXPR = {
                         name,
-                        value
+                        value,
+                        0,
+                        RESOLVE_BY_NAME
                     }
                 }            
             );
@@ -691,18 +463,13 @@ static AST *assignment(Token *token_list, size_t *token_position, AST *ast)
             return ast;
         }
         
-        parser_error(token_list[*token_position], "Invalid assignment target");
+        parser_error(&token_list[*token_position], "Invalid assignment target");
         panic_mode(token_list, token_position);
 
     }
     return ast;    
 }
 
-static AST *expression(Token *token_list, size_t *token_position, AST *ast) 
-{
-    return assignment(token_list, token_position, ast);   
-}
-
 static AST *expression_statement(Token *token_list, size_t *token_position, AST *ast) 
 {
     ast = expression(token_list, token_position, ast);
@@ -756,12 +523,11 @@ static AST *block_statement(Token *token_list, size_t *token_position, AST *ast)
     );
     AST **_stmt_list = ast->data.AST_BLOCK_STMT.stmt_list;
     while(token_list[*token_position].type != RIGHT_BRACE && token_list[(*token_position) + 1].type != EOF_TOKEN) {
-        _stmt_list = realloc(_stmt_list, sizeof(AST *) * (ast->data.AST_BLOCK_STMT.stmt_num + 1));
-        _stmt_list[ast->data.AST_BLOCK_STMT.stmt_num] = declaration(token_list, token_position, ast);
+        _stmt_list = ast_list_push(_stmt_list, ast->data.AST_BLOCK_STMT.stmt_num, declaration(token_list, token_position, ast));
 
         if(next_position(token_position, token_list)) {
             TODO("Fix panic mode!");
-            parser_error(token_list[*token_position], "Expected '}' after block statement.");
+            parser_error(&token_list[*token_position], "Expected '}' after block statement.");
             panic_mode(token_list, token_position);
         }
         ast->data.AST_BLOCK_STMT.stmt_num++;
@@ -769,7 +535,7 @@ static AST *block_statement(Token *token_list, size_t *token_position, AST *ast)
     ast->data.AST_BLOCK_STMT.stmt_list = _stmt_list;
     
     if(token_list[*token_position].type != RIGHT_BRACE) {
-        parser_error(token_list[*token_position], "Expected '}' after block statement.");
+        parser_error(&token_list[*token_position], "Expected '}' after block statement.");
         panic_mode(token_list, token_position);
     }
 
@@ -780,7 +546,7 @@ static AST *if_statement(Token *token_list, size_t *token_position, AST *ast)
 {
     if(token_list[*token_position].type != LEFT_PARENTHESIS) {
         TODO("Fix errors");
-        parser_error(token_list[*token_position], "Expected ( after if statement!");
+        parser_error(&token_list[*token_position], "Expected ( after if statement!");
         return ast;
     }
 
@@ -788,7 +554,7 @@ static AST *if_statement(Token *token_list, size_t *token_position, AST *ast)
     AST *condition = expression(token_list, token_position, ast);
     if(token_list[*token_position].type != RIGHT_PARENTHESIS) {
         TODO("Fix errors");
-        parser_error(token_list[*token_position], "Expected ) after if statement!");
+        parser_error(&token_list[*token_position], "Expected ) after if statement!");
         return ast;
     }
     next_position(token_position, token_list);
@@ -815,7 +581,7 @@ static AST *while_statement(Token *token_list, size_t *token_position, AST *ast)
 {
     if(token_list[*token_position].type != LEFT_PARENTHESIS) {
         TODO("Fix errors");
-        parser_error(token_list[*token_position], "Expected ( after while statement!");
+        parser_error(&token_list[*token_position], "Expected ( after while statement!");
         return ast;
     }
 
@@ -823,7 +589,7 @@ static AST *while_statement(Token *token_list, size_t *token_position, AST *ast)
     AST *condition = expression(token_list, token_position, ast);
     if(token_list[*token_position].type != RIGHT_PARENTHESIS) {
         TODO("Fix errors");
-        parser_error(token_list[*token_position], "Expected ) after while statement!");
+        parser_error(&token_list[*token_position], "Expected ) after while statement!");
         return ast;
     }
     next_position(token_position, token_list);
@@ -845,17 +611,17 @@ static AST *for_statement(Token *token_list, size_t *token_position, AST *ast)
 {
     if(token_list[*token_position].type != LEFT_PARENTHESIS) {
         TODO("Fix errors");
-        parser_error(token_list[*token_position], "Expected ( after while statement!");
+        parser_error(&token_list[*token_position], "Expected ( after while statement!");
         return ast;
     }
 
     if(next_position(token_position, token_list)) {
         TODO("Fix errors");
-        parser_error(token_list[*token_position], "Expected expression in initializer part of for statement!");
+        parser_error(&token_list[*token_position], "Expected expression in initializer part of for statement!");
         return ast;
     }
 
-    AST *initializer;
+    AST *initializer = NULL;
     
     if(token_list[*token_position].type == SEMICOLON)  {
         initializer = NULL;
@@ -868,13 +634,13 @@ static AST *for_statement(Token *token_list, size_t *token_position, AST *ast)
 
     if(token_list[*token_position].type != SEMICOLON) {
         TODO("Fix errors");
-        parser_error(token_list[*token_position], "Expected ; after initializerializer in for statement!");
+        parser_error(&token_list[*token_position], "Expected ; after initializerializer in for statement!");
         return ast;
     }
 
     if(next_position(token_position, token_list)) {
         TODO("Fix errors");
-        parser_error(token_list[*token_position], "Expected expression in initializerializer part of for statement!");
+        parser_error(&token_list[*token_position], "Expected expression in initializerializer part of for statement!");
         return ast;
     }
 
@@ -885,13 +651,13 @@ static AST *for_statement(Token *token_list, size_t *token_position, AST *ast)
 
     if(token_list[*token_position].type != SEMICOLON) {
         TODO("Fix errors");
-        parser_error(token_list[*token_position], "Expected ( after while statement!");
+        parser_error(&token_list[*token_position], "Expected ( after while statement!");
         return ast;
     }
 
     if(next_position(token_position, token_list)) {
         TODO("Fix errors");
-        parser_error(token_list[*token_position], "Expected expression in initializer part of for statement!");
+        parser_error(&token_list[*token_position], "Expected expression in initializer part of for statement!");
         return ast;
     }
 
@@ -902,7 +668,7 @@ static AST *for_statement(Token *token_list, size_t *token_position, AST *ast)
 
     if(token_list[*token_position].type != RIGHT_PARENTHESIS) {
         TODO("Fix errors");
-        parser_error(token_list[*token_position], "Expected closing ) in for statement!");
+        parser_error(&token_list[*token_position], "Expected closing ) in for statement!");
         return ast;
     }
    
@@ -931,7 +697,7 @@ static AST *return_statement(Token *token_list, size_t *token_position, AST *ast
     }
 
     if(token_list[*token_position].type != SEMICOLON) {
-        parser_error(token_list[*token_position], "Expected ; after return expression.");
+        parser_error(&token_list[*token_position], "Expected ; after return expression.");
         return ast;
     }
 
@@ -1019,8 +785,8 @@ static AST *run_statement(Token *token_list, size_t *token_position, AST *ast)
         program_name = &token_list[*token_position];
         if(next_position(token_position, token_list)) {TODO("Add error later");}
         while(token_list[*token_position].type != SEMICOLON) {
-            args_list = realloc(args_list, sizeof(AST *) * (arg_num + 1));
-            args_list[arg_num++] = expression(token_list, token_position, expr);
+            args_list = ast_list_push(args_list, arg_num, expression(token_list, token_position, expr));
+            arg_num++;
             if(arg_num >= MAX_ARG_CNT) {TODO("Add error later!");}
         }
     }
@@ -1046,18 +812,18 @@ static AST *run_statement(Token *token_list, size_t *token_position, AST *ast)
 static AST *variable_declaration(Token *token_list, size_t *token_position, AST *ast)
 {
     if(token_list[*token_position].type != IDENTIFIER) {
-        parser_error(token_list[*token_position], "Expected Identifier after var.");
+        parser_error(&token_list[*token_position], "Expected Identifier after var.");
         return ast;
     }
 
     Token *name = &token_list[*token_position];
     AST *initializer = NULL;
     if(next_position(token_position,token_list))
-        parser_error(token_list[*token_position], "Unexpected EOF after var.");
+        parser_error(&token_list[*token_position], "Unexpected EOF after var.");
 
     if(token_list[*token_position].type == EQUAL) {
         if(next_position(token_position,token_list))
-            parser_error(token_list[*token_position], "Unexpected EOF after initialization of variable.");
+            parser_error(&token_list[*token_position], "Unexpected EOF after initialization of variable.");
         initializer = expression(token_list, token_position, ast);
     }
     ast = ast_new((AST)
@@ -1065,7 +831,8 @@ static AST *variable_declaration(Token *token_list, size_t *token_position, AST
             .tag = AST_VAR_DECL_STMT,
             .data.AST_VAR_DECL_STMT = {
                 name,
-                initializer
+                initializer,
+                RESOLVE_BY_NAME
             }
         }            
     );
@@ -1078,6 +845,20 @@ static AST *variable_declaration(Token *token_list, size_t *token_position, AST
     return ast;
 }
 
+static void skip_function_body(Token *token_list, size_t *token_position)
+{
+    size_t depth = 1;
+
+    while(TRUE) {
+        if(token_list[*token_position].type == LEFT_BRACE) depth++;
+        if(token_list[*token_position].type == RIGHT_BRACE && --depth == 0) return;
+        if(next_position(token_position, token_list)) {
+            parser_error(&token_list[*token_position], "Expected '}' after block statement.");
+            panic_mode(token_list, token_position);
+        }
+    }
+}
+
 static AST *funct_declaration(Token *token_list, size_t *token_position, AST *ast)
 {
     if(token_list[*token_position].type != IDENTIFIER) {
@@ -1085,9 +866,7 @@ static AST *funct_declaration(Token *token_list, size_t *token_position, AST *as
     } 
 
     size_t param_num = 0;
-    size_t stmt_num = 0;
     AST **params = NULL;
-    AST **stmt_list = NULL;
     Token *name = &token_list[*token_position];
     
     if(next_position(token_position, token_list) || token_list[*token_position].type != LEFT_PARENTHESIS) {
@@ -1100,8 +879,8 @@ static AST *funct_declaration(Token *token_list, size_t *token_position, AST *as
 
     if(token_list[*token_position].type != RIGHT_PARENTHESIS) {
         do {
-            params = realloc(params, sizeof(AST *) * (param_num + 1));
-            params[param_num++] = expression(token_list, token_position, ast);
+            params = ast_list_push(params, param_num, expression(token_list, token_position, ast));
+            param_num++;
             if(param_num >= MAX_ARG_CNT) {TODO("Add error later!");}
         } while(token_list[*token_position].type == COMMA && !next_position(token_position, token_list));
         
@@ -1116,30 +895,23 @@ static AST *funct_declaration(Token *token_list, size_t *token_position, AST *as
         TODO("Handle the error!");
     } 
 
-    while(token_list[*token_position].type != RIGHT_BRACE && token_list[(*token_position) + 1].type != EOF_TOKEN) {
-        stmt_list = realloc(stmt_list, sizeof(AST *) * (stmt_num + 1));
-        stmt_list[stmt_num++] = declaration(token_list, token_position, ast);
-        if(next_position(token_position, token_list)) {
-            TODO("Fix panic mode!");
-            parser_error(token_list[*token_position], "Expected '}' after block statement.");
-            panic_mode(token_list, token_position);
-        }
-    } 
-    
-    if(token_list[*token_position].type != RIGHT_BRACE) {
-        parser_error(token_list[*token_position], "Expected '}' after block statement.");
-        panic_mode(token_list, token_position);
-    }
+    /* Body is parsed later, only its first token and closing brace are kept */
+    Token *body = (token_list[*token_position].type != RIGHT_BRACE) ? &token_list[*token_position] : NULL;
+    if(body != NULL) skip_function_body(token_list, token_position);
+    Token *end = &token_list[*token_position];
    
     ast = ast_new((AST)
         {
             .tag = AST_FUNCT_DECL_STMT,
             .data.AST_FUNCT_DECL_STMT = {
-                name,
-                params,
-                stmt_list,
-                param_num,
-                stmt_num
+                .name = name,
+                .body = body,
+                .body_end = end,
+                .parameters = params,
+                .stmt_list = NULL,
+                .param_num = param_num,
+                .slot_num = 0,
+                .stmt_num = 0
             }
         }            
     );
@@ -1152,7 +924,7 @@ static AST *statement(Token *token_list, size_t *token_position, AST *ast)
     /* print statement rule */
     if(token_list[*token_position].type == ECHO) {
         if(next_position(token_position, token_list)) {
-            parser_error(token_list[*token_position], "Expected expression after echo!");
+            parser_error(&token_list[*token_position], "Expected expression after echo!");
             return ast;
         }
         return echo_statement(token_list, token_position, ast);
@@ -1161,7 +933,7 @@ static AST *statement(Token *token_list, size_t *token_position, AST *ast)
     /* Block statement rule */
     if(token_list[*token_position].type == LEFT_BRACE) {
         if(next_position(token_position, token_list)) {
-            parser_error(token_list[*token_position], "Expected expression or '}' after opening block statement!");
+            parser_error(&token_list[*token_position], "Expected expression or '}' after opening block statement!");
             return ast;
         }
         return block_statement(token_list, token_position, ast);       
@@ -1170,7 +942,7 @@ static AST *statement(Token *token_list, size_t *token_position, AST *ast)
     /* If statement rule */
     if(token_list[*token_position].type == IF) {
         if(next_position(token_position, token_list)) {
-            parser_error(token_list[*token_position], "Expected '(' condition ')' after if statement!");
+            parser_error(&token_list[*token_position], "Expected '(' condition ')' after if statement!");
             return ast;
         }
         return if_statement(token_list, token_position, ast);       
@@ -1178,7 +950,7 @@ static AST *statement(Token *token_list, size_t *token_position, AST *ast)
     /* While statement rule */
     if(token_list[*token_position].type == WHILE) {
         if(next_position(token_position, token_list)) {
-            parser_error(token_list[*token_position], "Expected '(' condition ')' after if statement!");
+            parser_error(&token_list[*token_position], "Expected '(' condition ')' after if statement!");
             return ast;
         }
         return while_statement(token_list, token_position, ast);       
@@ -1186,15 +958,17 @@ static AST *statement(Token *token_list, size_t *token_position, AST *ast)
     /* For statement rule */
     if(token_list[*token_position].type == FOR) {
         if(next_position(token_position, token_list)) {
-            parser_error(token_list[*token_position], "Expected '(' after for statement!");
+            parser_error(&token_list[*token_position], "Expected '(' after for statement!");
             return ast;
         }
         return for_statement(token_list, token_position, ast);       
     }
     /* return statement rule */
     if(token_list[*token_position].type == RETURN) {
+        /* Function bodies are parsed only by parser_function_body, any other return is outside of function */
+        if(body_end == NULL) parser_error(&token_list[*token_position], "Can't return outside of function.");
         if(next_position(token_position, token_list)) {
-            parser_error(token_list[*token_position], "Expected expression or ';'  after return statement!");
+            parser_error(&token_list[*token_position], "Expected expression or ';'  after return statement!");
             return ast;
         }
         return return_statement(token_list, token_position, ast);       
@@ -1202,7 +976,7 @@ static AST *statement(Token *token_list, size_t *token_position, AST *ast)
     /* time statement rule */
     if(token_list[*token_position].type == TIME) {
         if(next_position(token_position, token_list)) {
-            parser_error(token_list[*token_position], "Expected ';'  after time statement!");
+            parser_error(&token_list[*token_position], "Expected ';'  after time statement!");
             return ast;
         }
         return time_statement(token_list, token_position, ast);       
@@ -1211,7 +985,7 @@ static AST *statement(Token *token_list, size_t *token_position, AST *ast)
     /* clear statement rule */
     if(token_list[*token_position].type == CLEAR) {
         if(next_position(token_position, token_list)) {
-            parser_error(token_list[*token_position], "Expected ';'  after clear statement!");
+            parser_error(&token_list[*token_position], "Expected ';'  after clear statement!");
             return ast;
         }
         return clear_statement(token_list, token_position, ast);       
@@ -1220,7 +994,7 @@ static AST *statement(Token *token_list, size_t *token_position, AST *ast)
     /* cd statement rule */
     if(token_list[*token_position].type == CD) {
         if(next_position(token_position, token_list)) {
-            parser_error(token_list[*token_position], "Expected ';'  after cd statement!");
+            parser_error(&token_list[*token_position], "Expected ';'  after cd statement!");
             return ast;
         }
         return cd_statement(token_list, token_position, ast);       
@@ -1229,7 +1003,7 @@ static AST *statement(Token *token_list, size_t *token_position, AST *ast)
     /* run statement rule */
     if(token_list[*token_position].type == RUN) {
         if(next_position(token_position, token_list)) {
-            parser_error(token_list[*token_position], "Expected ';'  after run statement!");
+            parser_error(&token_list[*token_position], "Expected ';'  after run statement!");
             return ast;
         }
         return run_statement(token_list, token_position, ast);       
@@ -1242,14 +1016,14 @@ static AST *statement(Token *token_list, size_t *token_position, AST *ast)
 static AST *declaration(Token *token_list, size_t *token_position, AST *ast) 
 {
     if(!setjmp(sync_env))
-        fprintf(stdout, "Setjmp for parser!\n");
+        TRACE(TRACE_PARSER, "Setjmp for parser!\n");
 
-    if(token_list[*token_position].type == EOF_TOKEN)
+    if(token_list[*token_position].type == EOF_TOKEN || &token_list[*token_position] == body_end)
         return ast;
     
     if(token_list[*token_position].type == VAR) {
         if(next_position(token_position, token_list)) {
-            parser_error(token_list[*token_position], "Expected expression after var.");
+            parser_error(&token_list[*token_position], "Expected expression after var.");
             return ast;
         }
         return variable_declaration(token_list, token_position, ast);
@@ -1257,7 +1031,7 @@ static AST *declaration(Token *token_list, size_t *token_position, AST *ast)
     
     if(token_list[*token_position].type == FUNCT) {
         if(next_position(token_position, token_list)) {
-            parser_error(token_list[*token_position], "Expected function identifier after funct.");
+            parser_error(&token_list[*token_position], "Expected function identifier after funct.");
             return ast;
         }
         return funct_declaration(token_list, token_position, ast);
@@ -1266,22 +1040,61 @@ static AST *declaration(Token *token_list, size_t *token_position, AST *ast)
     return statement(token_list, token_position, ast);
 }
 
-extern AST **parser(Token *token_list, size_t *statement_number) 
+extern AST **parser(Token *token_list, size_t *statement_number, Arena *arena) 
 {
     size_t token_position = 0;
     size_t num_of_stmt = 0;
     AST **ast = NULL;
     *statement_number = 0;
+    ast_arena = arena;
 
     do {
-        ast = realloc(ast, sizeof(AST *)*(num_of_stmt+1));
-        ast[num_of_stmt] = (ast[num_of_stmt] = NULL, declaration(token_list, &token_position, ast[num_of_stmt]));
-        if(ast[num_of_stmt] != NULL) {
+        AST *statement = declaration(token_list, &token_position, NULL);
+        if(statement != NULL) {
+            ast = ast_list_push(ast, num_of_stmt, statement);
             num_of_stmt++;
         }
-        printf("Number of statements parsed: %d\n\n", num_of_stmt);
+        TRACE(TRACE_PARSER, "Number of statements parsed: %zu\n\n", num_of_stmt);
     } while(!next_position(&token_position, token_list));
     
     *statement_number = num_of_stmt;
     return ast;
 }
+
+extern AST *parser_function_declaration(Token *name, Arena *arena)
+{
+    size_t token_position = 0;
+    ast_arena = arena;
+    return funct_declaration(name, &token_position, NULL);
+}
+
+extern void parser_function_body(AST *funct, Arena *arena)
+{
+    Token *token_list = funct->data.AST_FUNCT_DECL_STMT.body;
+    size_t token_position = 0;
+    size_t stmt_num = 0;
+    AST **stmt_list = NULL;
+    ast_arena = arena;
+
+    /* Body is parsed only once, even if it has errors */
+    funct->data.AST_FUNCT_DECL_STMT.body = NULL;
+    if(token_list == NULL) return;
+
+    /* Statements and error recovery stop at closing brace, tokens after it belong to enclosing code */
+    body_end = funct->data.AST_FUNCT_DECL_STMT.body_end;
+    while(&token_list[token_position] < body_end) {
+        AST *statement = declaration(token_list, &token_position, NULL);
+        if(statement != NULL) {
+            stmt_list = ast_list_push(stmt_list, stmt_num, statement);
+            stmt_num++;
+        }
+        if(&token_list[token_position] >= body_end || next_position(&token_position, token_list)) break;
+    } 
+
+    if(&token_list[token_position] != body_end)
+        parser_error(&token_list[token_position], "Expected '}' after block statement.");
+    body_end = NULL;
+
+    funct->data.AST_FUNCT_DECL_STMT.stmt_list = stmt_list;
+    funct->data.AST_FUNCT_DECL_STMT.stmt_num = stmt_num;
+}
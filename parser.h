@@ -33,6 +33,10 @@ static int next_position(size_t *, Token *);
 *Function that creates ASTs */
 static AST *ast_new(AST );
 
+/*@Function ast_list_push:
+*Function that appends AST to list allocated in arena, list capacity grows geometrically */
+static AST **ast_list_push(AST **, const size_t, AST *);
+
 /*@Function: synchronize
 *Helper function for synchronization when parser enters Panic Mode */
 static void synchronize(Token *, size_t *);
@@ -45,41 +49,17 @@ static void panic_mode(Token *, size_t *);
 *Function that implements PRIM rule of grammar */
 static AST *primary(Token *, size_t *, AST *);
 
-/*@Function: unary
-*Function that implements UNRY rule of grammar */
-static AST *unary(Token *, size_t *, AST *);
-
 /*@Function: call
-*Function that implements CALL rule of grammar */
+*Function that parses primary expression and optional call arguments */
 static AST *call(Token *, size_t *, AST *);
 
-/*@Function: factor
-*Function that implements FACT rule of grammar */
-static AST *factor(Token *, size_t *, AST *);
-
-/*@Function: term
-*Function that implements TERM rule of grammar */
-static AST *term(Token *, size_t *, AST *);
-
-/*@Function: comparison
-*Function that implements CMPR rule of grammar */
-static AST *comparison(Token *, size_t *, AST *);
-
-/*@Function: equality
-*Function that implements EQL rule of grammar */
-static AST *equality(Token *, size_t *, AST *);
-
-/*@Function logic_or
-*Function that implement LOR rule of grammar */
-static AST *logic_or(Token *, size_t *, AST *);
+/*@Function: prefix
+*Function that parses prefix operator from operator_rules or call expression */
+static AST *prefix(Token *, size_t *, AST *);
 
-/*@Function logic_and
-*Function that implement LAND rule of grammar */
-static AST *logic_and(Token *, size_t *, AST *);
-
-/*@Function: assignment
-*Function that implements ASSIGN expression rule of grammar */
-static AST *assignment(Token *, size_t *, AST *);
+/*@Function: binding_power_expression
+*Function that parses infix operators from operator_rules that bind tighter than given BindingPower */
+static AST *binding_power_expression(Token *, size_t *, AST *, const BindingPower);
 
 /*@Function: expression
 *Function that implements EXPR rule of grammar */
@@ -89,8 +69,12 @@ static AST *expression(Token *, size_t *, AST *);
 *Function that implements VAR-DECL statement rule of grammar*/
 static AST *variable_declaration(Token *, size_t *, AST *);
 
+/*@Function: skip_function_body
+*Helper Function: Moves token position to '}' that closes function body, nested braces are balanced */
+static void skip_function_body(Token *, size_t *);
+
 /*@Function: funct_declaration
- * Function that implements FUNCT_DECL statement rule of grammar */
+ * Function that implements FUNCT_DECL statement rule of grammar, body is only skipped and parsed by parser_function_body */
 static AST *funct_declaration(Token *, size_t *, AST *);
 
 /*@Function: expression_statement
@@ -141,16 +125,21 @@ static AST *statement(Token *, size_t *, AST *);
 *Function that implements DECL statement rule of grammar*/
 static AST *declaration(Token *, size_t *, AST *);
 
-/*@Function: ast_free
-*Function that deletes AST from current node down */
-extern void ast_free(AST *);
-
 /*@Function: ast_print
-*Function that prints ASTs */
+*Function that prints ASTs to trace sink, callers check TRACE_ON(TRACE_PARSER) */
 extern void ast_print(AST *);
 
 /*@Function: parser
-*Function that parses tokens into AST using grammar rules*/
-extern AST **parser(Token *, size_t *);
+*Function that parses tokens into AST using grammar rules, all nodes are allocated in given arena*/
+extern AST **parser(Token *, size_t *, Arena *);
+
+/*@Function: parser_function_declaration
+*Function that parses FUNCT_DECL again from its name token, body is skipped like in parser. Lowered engines keep only
+*name of function whose body was not parsed yet, nodes are allocated in given arena */
+extern AST *parser_function_declaration(Token *, Arena *);
+
+/*@Function: parser_function_body
+*Function that parses skipped body of FUNCT_DECL node into its statement list, nodes are allocated in given arena */
+extern void parser_function_body(AST *, Arena *);
 
 #endif // PARSER_H 
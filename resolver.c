@@ -0,0 +1,239 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "coretypes.h"
+#include "error.h"
+#include "trace.h"
+#include "resolver.h"
+
+/* Scopes of statement that is being resolved, innermost is last */
+static ResolverScope *scopes = NULL;
+static size_t scope_num = 0;
+static size_t scope_capacity = 0;
+
+/* Number of references resolved to slots and to names, for trace */
+static size_t slot_references = 0;
+static size_t name_references = 0;
+
+static void scope_push(const int function)
+{
+    if(scope_num == scope_capacity) {
+        scope_capacity = (scope_capacity) ? 2 * scope_capacity : 16;
+        scopes = realloc(scopes, sizeof(ResolverScope) * scope_capacity);
+        if(scopes == NULL) {
+            INTERNAL_ERROR("Could not reallocate resolver scopes!");
+            exit(EXIT_FAILURE);
+        }
+    }
+    scopes[scope_num++] = (ResolverScope){.names = NULL, .slot_num = 0, .capacity = 0, .function = function};
+}
+
+static size_t scope_pop(void)
+{
+    ResolverScope *scope = &scopes[--scope_num];
+    free(scope->names);
+    return scope->slot_num;
+}
+
+static uint32_t scope_declare(const Symbol name)
+{
+    ResolverScope *scope = &scopes[scope_num - 1];
+    /* Redeclaration reuses slot, as env_define_var overwrites variable of the same name */
+    for(size_t i = 0; i < scope->slot_num; ++i)
+        if(scope->names[i] == name) return i;
+
+    if(scope->slot_num == scope->capacity) {
+        scope->capacity = (scope->capacity) ? 2 * scope->capacity : 8;
+        scope->names = realloc(scope->names, sizeof(Symbol) * scope->capacity);
+        if(scope->names == NULL) {
+            INTERNAL_ERROR("Could not reallocate resolver scope names!");
+            exit(EXIT_FAILURE);
+        }
+    }
+    scope->names[scope->slot_num] = name;
+    return scope->slot_num++;
+}
+
+static void resolve_binding(const Token *name, uint32_t *depth, uint32_t *slot)
+{
+    for(size_t i = scope_num; i-- > 0;) {
+        for(size_t j = 0; j < scopes[i].slot_num; ++j) {
+            if(scopes[i].names[j] == name->symbol) {
+                *depth = scope_num - 1 - i;
+                *slot = j;
+                slot_references++;
+                return;
+            }
+        }
+        /* Callee environment encloses caller environment, its names are only known at runtime */
+        if(scopes[i].function) break;
+    }
+    *depth = 0;
+    *slot = RESOLVE_BY_NAME;
+    name_references++;
+}
+
+static void hoist(AST *ast)
+{
+    if(ast == NULL) return;
+
+    switch(ast->tag) {
+        case AST_VAR_DECL_STMT:
+            ast->data.AST_VAR_DECL_STMT.slot = scope_declare(ast->data.AST_VAR_DECL_STMT.name->symbol);
+            return;
+        case AST_IF_STMT:
+            hoist(ast->data.AST_IF_STMT.true_branch);
+            hoist(ast->data.AST_IF_STMT.else_branch);
+            return;
+        case AST_WHILE_STMT:
+            hoist(ast->data.AST_WHILE_STMT.body);
+            return;
+        default:
+            /* Blocks, for loops and functions declare into their own scope */
+            return;
+    }
+}
+
+static size_t resolve_block(AST **stmt_list, const size_t stmt_num)
+{
+    scope_push(FALSE);
+    /* Every declaration of scope has its slot before any use, use before declaration falls back to name at runtime */
+    for(size_t i = 0; i < stmt_num; ++i)
+        hoist(stmt_list[i]);
+    for(size_t i = 0; i < stmt_num; ++i)
+        resolve(stmt_list[i]);
+    return scope_pop();
+}
+
+static void resolve(AST *ast)
+{
+    if(ast == NULL) return;
+
+    switch(ast->tag) {
+        case AST_LITERAL:
+        case AST_TIME_STMT:
+        case AST_CLEAR_STMT:
+            return;
+        case AST_IDENTIFIER:
+            resolve_binding(ast->data.AST_IDENTIFIER.token, &ast->data.AST_IDENTIFIER.depth, &ast->data.AST_IDENTIFIER.slot);
+            return;
+        case AST_ASSIGN_EXPR:
+            resolve(ast->data.AST_ASSIGN_EXPR.expr);
+            resolve_binding(ast->data.AST_ASSIGN_EXPR.token, &ast->data.AST_ASSIGN_EXPR.depth, &ast->data.AST_ASSIGN_EXPR.slot);
+            return;
+        case AST_VAR_DECL_STMT:
+            resolve(ast->data.AST_VAR_DECL_STMT.init);
+            /* Globals are defined by name, local declaration got its slot when scope was hoisted */
+            if(scope_num == 0) ast->data.AST_VAR_DECL_STMT.slot = RESOLVE_BY_NAME;
+            return;
+        case AST_FUNCT_DECL_STMT:
+        {
+            struct AST_FUNCT_DECL_STMT *function = &ast->data.AST_FUNCT_DECL_STMT;
+            scope_push(TRUE);
+            for(size_t i = 0; i < function->param_num; ++i) {
+                AST *parameter = function->parameters[i];
+                if(parameter->tag != AST_IDENTIFIER) continue;
+                parameter->data.AST_IDENTIFIER.depth = 0;
+                parameter->data.AST_IDENTIFIER.slot = scope_declare(parameter->data.AST_IDENTIFIER.token->symbol);
+            }
+            for(size_t i = 0; i < function->stmt_num; ++i)
+                hoist(function->stmt_list[i]);
+            for(size_t i = 0; i < function->stmt_num; ++i)
+                resolve(function->stmt_list[i]);
+            function->slot_num = scope_pop();
+            return;
+        }
+        case AST_EXPR_STMT:
+        case AST_ECHO_STMT:
+        case AST_RETURN_STMT:
+        case AST_CD_STMT:
+            /* Expression of these statements is first member of their structures */
+            resolve(ast->data.AST_EXPR_STMT.expr);
+            return;
+        case AST_GROUPING_EXPR:
+            resolve(ast->data.AST_GROUPING_EXPR.left);
+            return;
+        case AST_UNARY_EXPR:
+            resolve(ast->data.AST_UNARY_EXPR.right);
+            return;
+        case AST_LOGICAL_EXPR:
+        case AST_BINARY_EXPR:
+            resolve(ast->data.AST_BINARY_EXPR.left);
+            resolve(ast->data.AST_BINARY_EXPR.right);
+            return;
+        case AST_CALL_EXPR:
+            /* Callee is function name, functions are looked up by name */
+            for(size_t i = 0; i < ast->data.AST_CALL_EXPR.stmt_num; ++i)
+                resolve(ast->data.AST_CALL_EXPR.stmt_list[i]);
+            return;
+        case AST_RUN_STMT:
+            for(size_t i = 0; i < ast->data.AST_RUN_STMT.arg_num; ++i)
+                resolve(ast->data.AST_RUN_STMT.args_list[i]);
+            return;
+        case AST_BLOCK_STMT:
+            ast->data.AST_BLOCK_STMT.slot_num = resolve_block(ast->data.AST_BLOCK_STMT.stmt_list, ast->data.AST_BLOCK_STMT.stmt_num);
+            return;
+        case AST_IF_STMT:
+            resolve(ast->data.AST_IF_STMT.condition);
+            resolve(ast->data.AST_IF_STMT.true_branch);
+            resolve(ast->data.AST_IF_STMT.else_branch);
+            return;
+        case AST_WHILE_STMT:
+            resolve(ast->data.AST_WHILE_STMT.condition);
+            resolve(ast->data.AST_WHILE_STMT.body);
+            return;
+        case AST_FOR_STMT:
+            scope_push(FALSE);
+            hoist(ast->data.AST_FOR_STMT.initializer);
+            hoist(ast->data.AST_FOR_STMT.body);
+            resolve(ast->data.AST_FOR_STMT.initializer);
+            resolve(ast->data.AST_FOR_STMT.condition);
+            resolve(ast->data.AST_FOR_STMT.increment);
+            resolve(ast->data.AST_FOR_STMT.body);
+            ast->data.AST_FOR_STMT.slot_num = scope_pop();
+            return;
+        default:
+            break;
+    }
+    INTERNAL_ERROR("Tried to resolve undefined AST node type.");
+    exit(EXIT_FAILURE);
+}
+
+extern size_t ast_resolve(AST **ast, const size_t number_of_statements)
+{
+    slot_references = 0;
+    name_references = 0;
+    for(size_t i = 0; i < number_of_statements; ++i)
+        resolve(ast[i]);
+
+    free(scopes);
+    scopes = NULL;
+    scope_capacity = 0;
+    TRACE(TRACE_PARSER, "Resolver bound %zu of %zu variable references to slots\n", slot_references, slot_references + name_references);
+    return slot_references;
+}
@@ -0,0 +1,62 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+/*@Function: scope_push
+*Helper Function: Opens scope of block, for loop or function body */
+static void scope_push(const int);
+
+/*@Function: scope_pop
+*Helper Function: Closes innermost scope and returns number of its slots */
+static size_t scope_pop(void);
+
+/*@Function: scope_declare
+*Helper Function: Returns slot of name in innermost scope, name gets new slot if it is not declared there yet */
+static uint32_t scope_declare(const Symbol);
+
+/*@Function: resolve_binding
+*Helper Function: Finds nearest declaration of name up to function scope, RESOLVE_BY_NAME slot if there is none */
+static void resolve_binding(const Token *, uint32_t *, uint32_t *);
+
+/*@Function: hoist
+*Helper Function: Declares variables of statement that live in innermost scope, if and while bodies do not open scope */
+static void hoist(AST *);
+
+/*@Function: resolve_block
+*Helper Function: Resolves statements in new scope, returns number of slots the scope needs */
+static size_t resolve_block(AST **, const size_t);
+
+/*@Function: resolve
+*Helper Function: Resolves variables of node and its children */
+static void resolve(AST *);
+
+/*@Function: ast_resolve
+*Function that computes depth and slot of every local variable declaration, use and assignment, so that
+*interpreters index Environment directly. Globals and names declared outside of function stay looked up by name.
+*Returns number of references resolved to slots */
+extern size_t ast_resolve(AST **, const size_t);
+
+#endif // RESOLVER_H
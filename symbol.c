@@ -0,0 +1,122 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "coretypes.h"
+#include "error.h"
+#include "arena.h"
+#include "symbol.h"
+
+SymbolTable symbol_table = {.entries = NULL, .size = 0, .capacity = 0, .slots = NULL, .slot_capacity = 0, .names = {NULL, 0, 0, NULL}};
+
+static uint32_t symbol_hash(const char *span, const size_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= (unsigned char)span[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void symbol_table_grow(void)
+{
+    size_t slot_capacity = (symbol_table.slot_capacity) ? 2 * symbol_table.slot_capacity : 256;
+    SymbolSlot *slots = calloc(slot_capacity, sizeof(SymbolSlot));
+    if (slots == NULL) {
+        INTERNAL_ERROR("Failed to allocate symbol table slots!");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Reinsert every occupied slot, hashes are kept in slots so names are not rehashed */
+    for (size_t i = 0; i < symbol_table.slot_capacity; ++i) {
+        if (!symbol_table.slots[i].symbol)
+            continue;
+        size_t slot = symbol_table.slots[i].hash & (slot_capacity - 1);
+        while (slots[slot].symbol)
+            slot = (slot + 1) & (slot_capacity - 1);
+        slots[slot] = symbol_table.slots[i];
+    }
+    free(symbol_table.slots);
+    symbol_table.slots = slots;
+    symbol_table.slot_capacity = slot_capacity;
+}
+
+extern Symbol symbol_intern(const char *span, const size_t length)
+{
+    /* Keep load factor under three quarters, hashes in slots keep long probes cheap */
+    if (4 * (symbol_table.size + 1) > 3 * symbol_table.slot_capacity)
+        symbol_table_grow();
+
+    uint32_t hash = symbol_hash(span, length);
+    size_t slot = hash & (symbol_table.slot_capacity - 1);
+    for (; symbol_table.slots[slot].symbol; slot = (slot + 1) & (symbol_table.slot_capacity - 1)) {
+        if (symbol_table.slots[slot].hash != hash)
+            continue;
+        SymbolEntry *entry = &symbol_table.entries[symbol_table.slots[slot].symbol];
+        if (entry->length == length && !memcmp(entry->name, span, length))
+            return symbol_table.slots[slot].symbol;
+    }
+
+    /* Entry 0 is reserved so that Symbol 0 means no symbol */
+    if (symbol_table.size == 0)
+        symbol_table.size = 1;
+    if (symbol_table.size >= symbol_table.capacity) {
+        symbol_table.capacity = (symbol_table.capacity) ? 2 * symbol_table.capacity : 128;
+        SymbolEntry *entries = realloc(symbol_table.entries, sizeof(SymbolEntry) * symbol_table.capacity);
+        if (entries == NULL) {
+            INTERNAL_ERROR("Failed to reallocate symbol table entries!");
+            exit(EXIT_FAILURE);
+        }
+        symbol_table.entries = entries;
+    }
+
+    /* Names are bump allocated, arena exits on failure */
+    char *name = arena_alloc(&symbol_table.names, length + 1);
+    memcpy(name, span, length);
+    name[length] = '\0';
+
+    Symbol symbol = (Symbol)symbol_table.size++;
+    symbol_table.entries[symbol] = (SymbolEntry){.name = name, .length = length};
+    symbol_table.slots[slot] = (SymbolSlot){.hash = hash, .symbol = symbol};
+    return symbol;
+}
+
+extern char *symbol_name(const Symbol symbol)
+{
+    if (symbol == 0 || symbol >= symbol_table.size)
+        return NULL;
+    return symbol_table.entries[symbol].name;
+}
+
+extern void symbol_table_free(void)
+{
+    arena_release(&symbol_table.names);
+    free(symbol_table.entries);
+    free(symbol_table.slots);
+    symbol_table = (SymbolTable){.entries = NULL, .size = 0, .capacity = 0, .slots = NULL, .slot_capacity = 0, .names = {NULL, 0, 0, NULL}};
+}
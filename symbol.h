@@ -0,0 +1,52 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+/*@Variable: symbol_table
+*Global table of interned identifiers */
+extern SymbolTable symbol_table;
+
+/*@Function: symbol_hash
+*Helper Function: FNV-1a hash of identifier span */
+static uint32_t symbol_hash(const char *, const size_t);
+
+/*@Function: symbol_table_grow
+*Helper Function: Doubles slot array and reinserts all symbols */
+static void symbol_table_grow(void);
+
+/*@Function: symbol_intern
+*Function that returns Symbol of identifier span, identifier is stored only the first time it is seen */
+extern Symbol symbol_intern(const char *, const size_t);
+
+/*@Function: symbol_name
+*Function that returns name of interned Symbol */
+extern char *symbol_name(const Symbol);
+
+/*@Function: symbol_table_free
+*Function that frees all interned identifiers */
+extern void symbol_table_free(void);
+
+#endif // SYMBOL_H
@@ -0,0 +1,158 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <setjmp.h>
+#include "coretypes.h"
+#include "trace.h"
+
+unsigned int trace_mask = 0;
+
+static char trace_buffer[TRACE_BUFFER_SIZE];
+static size_t trace_used = 0;
+
+static const char *token_names[TOKEN_TYPE_COUNT] = {
+#define SPECIAL_TOKEN(type, character, flags) [type] = #type,
+#define OPERATOR_TOKEN(type, first, second, flags) [type] = #type,
+#define TOKEN(type, flags) [type] = #type,
+#define RESERVED_WORD(type, word, flags) [type] = #type,
+#include "tokens.def"
+};
+
+static const char *ast_names[] = {
+    [AST_LITERAL] = "literal",
+    [AST_IDENTIFIER] = "identifier",
+    [AST_FUNCT_DECL_STMT] = "function declaration",
+    [AST_VAR_DECL_STMT] = "variable declaration",
+    [AST_EXPR_STMT] = "expression statement",
+    [AST_BLOCK_STMT] = "block",
+    [AST_IF_STMT] = "if",
+    [AST_WHILE_STMT] = "while",
+    [AST_FOR_STMT] = "for",
+    [AST_ECHO_STMT] = "echo",
+    [AST_RETURN_STMT] = "return",
+    [AST_TIME_STMT] = "time",
+    [AST_CLEAR_STMT] = "clear",
+    [AST_CD_STMT] = "cd",
+    [AST_RUN_STMT] = "run",
+    [AST_ASSIGN_EXPR] = "assign",
+    [AST_LOGICAL_EXPR] = "logical",
+    [AST_BINARY_EXPR] = "binary",
+    [AST_GROUPING_EXPR] = "grouping",
+    [AST_CALL_EXPR] = "call",
+    [AST_UNARY_EXPR] = "unary",
+};
+
+static const char *opcode_names[OPCODE_COUNT] = {
+#define OPCODE(name, operands) [name] = #name,
+#include "opcodes.def"
+};
+
+static unsigned int trace_category(const char *name, const size_t length)
+{
+    if(length == 5 && !strncmp(name, "lexer", length)) return TRACE_LEXER;
+    if(length == 6 && !strncmp(name, "parser", length)) return TRACE_PARSER;
+    if(length == 4 && !strncmp(name, "eval", length)) return TRACE_EVAL;
+    if(length == 3 && !strncmp(name, "all", length)) return TRACE_ALL;
+    return 0;
+}
+
+extern int trace_init(const char *categories)
+{
+    static int registered = FALSE;
+    if(categories == NULL) return 0;
+
+    trace_mask = 0;
+    for(const char *name = categories; *name != '\0';) {
+        size_t length = strcspn(name, ",");
+        unsigned int category = trace_category(name, length);
+        if(category == 0 && !(length == 4 && !strncmp(name, "none", length))) {
+            fprintf(stderr, "Unknown trace category %.*s, expected lexer, parser, eval, all or none!\n", (int)length, name);
+            return 1;
+        }
+        trace_mask |= category;
+        name += (name[length] == ',') ? length + 1 : length;
+    }
+
+#ifndef TRACE_ENABLED
+    if(trace_mask) fprintf(stderr, "Tracing is not compiled in, rebuild with make TRACE=1!\n");
+#endif
+    if(trace_mask && !registered) {
+        atexit(trace_flush);
+        registered = TRUE;
+    }
+    return 0;
+}
+
+extern void trace_printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    size_t available = TRACE_BUFFER_SIZE - trace_used;
+    int length = vsnprintf(&trace_buffer[trace_used], available, format, args);
+    va_end(args);
+    if(length < 0) return;
+
+    if((size_t)length >= available) {
+        /* Message did not fit, flush what was buffered before it and format again */
+        trace_flush();
+        va_start(args, format);
+        if((size_t)length >= TRACE_BUFFER_SIZE) 
+            vfprintf(stderr, format, args);
+        else 
+            trace_used = vsnprintf(trace_buffer, TRACE_BUFFER_SIZE, format, args);
+        va_end(args);
+        return;
+    }
+    trace_used += length;
+}
+
+extern void trace_flush(void)
+{
+    if(trace_used == 0) return;
+    fwrite(trace_buffer, 1, trace_used, stderr);
+    fflush(stderr);
+    trace_used = 0;
+}
+
+extern const char *trace_token_name(const TokenType type)
+{
+    if(type < 0 || type >= TOKEN_TYPE_COUNT || token_names[type] == NULL) return "UNKNOWN";
+    return token_names[type];
+}
+
+extern const char *trace_ast_name(const int tag)
+{
+    if(tag < 0 || (size_t)tag >= sizeof(ast_names) / sizeof(ast_names[0])) return "unknown";
+    return ast_names[tag];
+}
+
+extern const char *trace_opcode_name(const Opcode opcode)
+{
+    if(opcode < 0 || opcode >= OPCODE_COUNT) return "UNKNOWN";
+    return opcode_names[opcode];
+}
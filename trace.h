@@ -0,0 +1,74 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#define TRACE_BUFFER_SIZE 65536
+
+/* Trace points are compiled only with -DTRACE_ENABLED (make TRACE=1), otherwise they expand to nothing 
+ * and arguments are not evaluated. When compiled in, disabled category costs one test of trace_mask. */
+#ifdef TRACE_ENABLED
+#define TRACE_ON(category) (trace_mask & (category))
+#define TRACE(category, ...) do {                       \
+        if(TRACE_ON(category)) trace_printf(__VA_ARGS__); \
+    } while(0)
+#else
+#define TRACE_ON(category) 0
+#define TRACE(category, ...) do {} while(0)
+#endif
+
+/*@Global Variable: trace_mask
+*Variable that holds TraceCategory bits that are enabled */
+extern unsigned int trace_mask;
+
+/*@Function: trace_category
+*Helper Function: Returns TraceCategory of name, 0 if name is unknown */
+static unsigned int trace_category(const char *, const size_t);
+
+/*@Function: trace_init
+*Function that enables comma separated categories (lexer, parser, eval, all, none), returns 1 on unknown category */
+extern int trace_init(const char *);
+
+/*@Function: trace_printf
+*Function that formats trace message into buffered sink, sink is flushed to stderr when full or on exit */
+extern void trace_printf(const char *, ...);
+
+/*@Function: trace_flush
+*Function that writes buffered trace messages to stderr */
+extern void trace_flush(void);
+
+/*@Function: trace_token_name
+*Function that returns name of TokenType as written in tokens.def */
+extern const char *trace_token_name(const TokenType);
+
+/*@Function: trace_ast_name
+*Function that returns name of AST node tag */
+extern const char *trace_ast_name(const int);
+
+/*@Function: trace_opcode_name
+*Function that returns name of Opcode as written in opcodes.def */
+extern const char *trace_opcode_name(const Opcode);
+
+#endif // TRACE_H
@@ -0,0 +1,459 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "coretypes.h"
+#include "error.h"
+#include "lexer.h"
+#include "arena.h"
+#include "value.h"
+
+extern char *string_new(const char *bytes, const size_t length)
+{
+    StringHeader *header = malloc(sizeof(StringHeader) + length + 1);
+    if(header == NULL) {
+        INTERNAL_ERROR("Failed to allocate string!");
+        exit(EXIT_FAILURE);
+    }
+    header->length = length;
+    header->capacity = length;
+    header->references = 1;
+    char *chars = (char *)(header + 1);
+    if(bytes != NULL) memcpy(chars, bytes, length);
+    chars[length] = '\0';
+    return chars;
+}
+
+extern char *string_static(Arena *arena, const char *bytes, const size_t length)
+{
+    StringHeader *header = arena_alloc(arena, sizeof(StringHeader) + length + 1);
+    header->length = length;
+    header->capacity = length;
+    header->references = STRING_STATIC;
+    char *chars = (char *)(header + 1);
+    memcpy(chars, bytes, length);
+    chars[length] = '\0';
+    return chars;
+}
+
+extern char *string_copy(const char *chars)
+{
+    StringHeader *header = (StringHeader *)chars - 1;
+    if(header->references != STRING_STATIC) ++header->references;
+    return (char *)chars;
+}
+
+extern char *string_append(char *chars, const char *bytes, const size_t length)
+{
+    StringHeader *header = (StringHeader *)chars - 1;
+    size_t old_length = header->length;
+
+    if(header->references != 1) {
+        /* Shared string is not changed, its bytes are copied and reference of caller is dropped */
+        char *result = string_new(NULL, old_length + length);
+        memcpy(result, chars, old_length);
+        memcpy(result + old_length, bytes, length);
+        string_free(chars);
+        return result;
+    }
+
+    if(old_length + length > header->capacity) {
+        /* Capacity is doubled, so that repeated appends copy every byte only a constant number of times */
+        size_t capacity = (header->capacity > STRING_FIRST_CAPACITY) ? header->capacity : STRING_FIRST_CAPACITY;
+        while(capacity < old_length + length) capacity *= 2;
+        header = realloc(header, sizeof(StringHeader) + capacity + 1);
+        if(header == NULL) {
+            INTERNAL_ERROR("Failed to reallocate string!");
+            exit(EXIT_FAILURE);
+        }
+        header->capacity = capacity;
+        chars = (char *)(header + 1);
+    }
+    memcpy(chars + old_length, bytes, length);
+    header->length = old_length + length;
+    chars[header->length] = '\0';
+    return chars;
+}
+
+extern size_t string_length(const char *chars)
+{
+    return ((const StringHeader *)chars - 1)->length;
+}
+
+extern void string_free(char *chars)
+{
+    if(chars == NULL) return;
+    StringHeader *header = (StringHeader *)chars - 1;
+    if(header->references == STRING_STATIC || --header->references) return;
+    free(header);
+}
+
+extern void value_release(ValueTagged *value)
+{
+    if(value->type == STRING) string_free(value->literal.char_value);
+}
+
+extern void free_value(ValueTagged *value)
+{   
+    if(value == NULL) return;
+    value_release(value);
+    free(value);
+}
+
+extern ValueTagged value_literal(Token *token)
+{
+    ValueTagged result = {.type = token->type, .literal = token->literal};
+    if(token->type == STRING) {
+        char *lexeme = token_lexeme(token);
+        result.literal.char_value = string_new(lexeme, strlen(lexeme));
+    }
+    return result;
+}
+
+extern ValueTagged *value_from_token(Token *token)
+{
+    ValueTagged *result = (ValueTagged *)malloc(sizeof(ValueTagged));
+    *result = value_literal(token);
+    return result;
+}
+
+extern ValueTagged value_clone(const ValueTagged *value)
+{
+    ValueTagged result = *value;
+    if(value->type == STRING) result.literal.char_value = string_copy(value->literal.char_value);
+    return result;
+}
+
+extern ValueTagged *value_copy(const ValueTagged *value)
+{
+    ValueTagged *result = (ValueTagged *)malloc(sizeof(ValueTagged));
+    *result = value_clone(value);
+    return result;
+}
+
+extern int value_is_truth(const ValueTagged *value) 
+{
+    switch(value->type) {
+        case NUMBER_INT:
+            return (value->literal.integer_value) ? TRUE : FALSE;
+        case NUMBER_FLOAT:
+            return (value->literal.float_value) ? TRUE : FALSE;
+        case TRUE_TOKEN:
+        case FALSE_TOKEN:
+            return (value->literal.boolean_value) ? TRUE : FALSE;
+        default:
+            return (value->literal.char_value != NULL) ? TRUE : FALSE;
+    }
+}
+
+extern int value_unary_into(Token *operator, ValueTagged *right, ValueTagged *result) 
+{
+    ValueTagged value = {.type = right->type, .literal = {.integer_value = 0}};
+
+    switch(operator->type) {
+        case SUBTRACT:
+        {
+            if(right->type == STRING) {
+                operator_error(operator, "Can't do unary subtract operation on strings!");
+                break;
+            }
+
+            if(right->type == NUMBER_FLOAT)
+                value.literal.float_value = (-1)*right->literal.float_value;
+            if(right->type == NUMBER_INT)
+                value.literal.integer_value = (-1)*(right->literal.integer_value); 
+            if(right->type == TRUE_TOKEN || right->type == FALSE_TOKEN) {
+                value.literal.integer_value = (-1)*right->literal.boolean_value;
+                value.type = NUMBER_INT;
+            }
+            return (*result = value, TRUE);                
+        }
+        case XOR:
+        {
+            if(right->type == STRING) {
+                operator_error(operator, "Can't do unary XOR operation on strings!");
+                break;
+            }
+            if(right->type == NUMBER_FLOAT) {
+                operator_error(operator, "Can't do unary XOR operation on float!");
+                break;
+            }
+            if(right->type == NUMBER_INT)
+                value.literal.integer_value = ~right->literal.integer_value; 
+            if(right->type == TRUE_TOKEN || right->type == FALSE_TOKEN) {
+                value.literal.integer_value = ~right->literal.boolean_value;
+                value.type = NUMBER_INT;
+            }
+            return (*result = value, TRUE);
+        }
+        case EXCLAMATION:
+        {
+            value.literal.boolean_value = !value_is_truth(right);
+            value.type = (value.literal.boolean_value) ? TRUE_TOKEN : FALSE_TOKEN;
+            value_release(right);
+            return (*result = value, TRUE);
+        }
+        default:
+            error("Unallowed operator on unary expression!", __FILE__, __LINE__); 
+            break;
+    }
+
+    value_release(right);
+    return FALSE;
+}
+
+extern ValueTagged *value_unary(Token *operator, ValueTagged *right) 
+{
+    ValueTagged *result = (ValueTagged *)malloc(sizeof(ValueTagged));
+    int done = value_unary_into(operator, right, result);
+    free(right);
+    if(!done) return (free(result), NULL);
+    return result;
+}
+
+static int integer_operand(const ValueTagged *value, long long int *integer)
+{
+    switch(value->type) {
+        case NUMBER_INT:
+            return (*integer = value->literal.integer_value, TRUE);
+        case TRUE_TOKEN:
+        case FALSE_TOKEN:
+            return (*integer = value->literal.boolean_value, TRUE);
+        default:
+            return FALSE;
+    }
+}
+
+static ValueTagged *value_integer_binary(Token *operator, const long long int left, const long long int right, ValueTagged *result)
+{
+    result->type = NUMBER_INT;
+    switch(operator->type) {
+        case MODULUS:
+            if(right == 0) {
+                operator_error(operator, "Modulus by zero!");
+                return NULL;
+            }
+            /* LLONG_MIN % -1 overflows in C */
+            result->literal.integer_value = (right == -1) ? 0 : left % right;
+            return result;
+        case SHIFT_LEFT:
+        case SHIFT_RIGHT:
+            if(right < 0 || right > 63) {
+                operator_error(operator, "Shift count must be between 0 and 63!");
+                return NULL;
+            }
+            result->literal.integer_value = (operator->type == SHIFT_LEFT) ? (long long int)((unsigned long long int)left << right) 
+                                                                           : left >> right;
+            return result;
+        case AND:
+            result->literal.integer_value = left & right;
+            return result;
+        case PIPE:
+            result->literal.integer_value = left | right;
+            return result;
+        default:
+            break;
+    }
+    operator_error(operator, "Binary operator is not supported!");
+    return NULL;
+}
+
+static const char *value_text(const ValueTagged *value, char *buffer, size_t *length)
+{
+    int written;
+    /* Numbers and booleans are written the same way as echo writes them */
+    switch(value->type) {
+        case STRING:
+            *length = string_length(value->literal.char_value);
+            return value->literal.char_value;
+        case NUMBER_INT:
+            written = snprintf(buffer, VALUE_TEXT_SIZE, "%lld", value->literal.integer_value);
+            break;
+        case NUMBER_FLOAT:
+            written = snprintf(buffer, VALUE_TEXT_SIZE, "%lf", value->literal.float_value);
+            break;
+        case TRUE_TOKEN:
+        case FALSE_TOKEN:
+            written = snprintf(buffer, VALUE_TEXT_SIZE, "%d", value->literal.boolean_value);
+            break;
+        default:
+            return NULL;
+    }
+    *length = (size_t)written;
+    return buffer;
+}
+
+extern int value_can_append(const ValueTagged *left, const ValueTagged *right)
+{
+    char buffer[VALUE_TEXT_SIZE];
+    size_t length;
+    return left->type == STRING && value_text(right, buffer, &length) != NULL;
+}
+
+extern char *value_string(const ValueTagged *value)
+{
+    char buffer[VALUE_TEXT_SIZE];
+    size_t length;
+    const char *text = value_text(value, buffer, &length);
+    if(text == NULL) return NULL;
+
+    char *chars = malloc(length + 1);
+    if(chars == NULL) {
+        INTERNAL_ERROR("Failed to allocate text of value!");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(chars, text, length);
+    chars[length] = '\0';
+    return chars;
+}
+
+static int value_concat(ValueTagged *left, ValueTagged *right, ValueTagged *result)
+{
+    char left_buffer[VALUE_TEXT_SIZE], right_buffer[VALUE_TEXT_SIZE];
+    size_t left_length, right_length;
+    const char *left_text = value_text(left, left_buffer, &left_length);
+    const char *right_text = value_text(right, right_buffer, &right_length);
+    if(left_text == NULL || right_text == NULL) return FALSE;
+
+    result->type = STRING;
+    if(left->type == STRING) {
+        /* Right text can't be in left string that grows in place, it would hold second reference to it */
+        result->literal.char_value = string_append(left->literal.char_value, right_text, right_length);
+        return TRUE;
+    }
+    result->literal.char_value = string_new(NULL, left_length + right_length);
+    memcpy(result->literal.char_value, left_text, left_length);
+    memcpy(result->literal.char_value + left_length, right_text, right_length);
+    return TRUE;
+}
+
+extern int value_binary_into(Token *operator, ValueTagged *left, ValueTagged *right, ValueTagged *result) 
+{
+    /* Result is built aside, so that it may be stored over left operand */
+    ValueTagged value = VALUE_NONE;
+    TokenType operator_type = operator->type;
+
+    if((left->type == STRING || right->type == STRING) && operator_type != ADD)
+        operator_error(operator, "Binary operator is not allowed on strings!");
+    else
+        switch(operator_type)
+        {
+            case EXCLAMATION_EQUEAL:
+                BINARY_COMPARISON_OPERATION(!=, left, right, &value);
+                return (*result = value, TRUE);
+            case DOUBLE_EQUAL:
+                BINARY_COMPARISON_OPERATION(==, left, right, &value); 
+                return (*result = value, TRUE);
+            case REDIRECTION_RIGHT_GREATER_RELATIONAL:
+                BINARY_COMPARISON_OPERATION(>, left, right, &value); 
+                return (*result = value, TRUE);
+            case REDIRECTION_LEFT_LESS_RELATIONAL:
+                BINARY_COMPARISON_OPERATION(<, left, right, &value);
+                return (*result = value, TRUE);
+            case GREATER_EQUAL:
+                BINARY_COMPARISON_OPERATION(>=, left, right, &value);
+                return (*result = value, TRUE);
+            case LESS_EQUAL:
+                BINARY_COMPARISON_OPERATION(<=, left, right, &value);
+                return (*result = value, TRUE);
+            case SUBTRACT:
+                BINARY_ADD_SUB_MULTIPLY_OPERATION(-, left, right, &value);
+                return (*result = value, TRUE);          
+            case MULTIPLY:
+                BINARY_ADD_SUB_MULTIPLY_OPERATION(*, left, right, &value);
+                return (*result = value, TRUE);
+            case DIVIDE:
+                BINARY_DIVIDE_OPERATION(/, left, right, &value);
+                return (*result = value, TRUE);
+            case ADD:
+            {
+                if(left->type != STRING && right->type != STRING) {
+                    BINARY_ADD_SUB_MULTIPLY_OPERATION(+, left, right, &value);
+                    return (*result = value, TRUE);
+                }
+                if(!value_concat(left, right, &value)) {
+                    operator_error(operator, "Only strings, numbers and booleans can be added to strings!");
+                    break;
+                }
+                /* String of left operand was moved into result */
+                return (value_release(right), *result = value, TRUE);
+            }
+            case MODULUS:
+            case SHIFT_LEFT:
+            case SHIFT_RIGHT:
+            case AND:
+            case PIPE:
+            {
+                long long int left_integer, right_integer;
+                if(!integer_operand(left, &left_integer) || !integer_operand(right, &right_integer)) {
+                    operator_error(operator, "Operator requires integer operands!");
+                    break;
+                }
+                if(value_integer_binary(operator, left_integer, right_integer, &value) == NULL) break;
+                return (*result = value, TRUE);
+            }
+            default:
+                operator_error(operator, "Binary operator is not supported!");
+                break;
+        }
+    value_release(left);
+    value_release(right);
+    return FALSE;
+} 
+
+extern ValueTagged *value_binary(Token *operator, ValueTagged *left, ValueTagged *right) 
+{
+    ValueTagged *result = (ValueTagged *)malloc(sizeof(ValueTagged));
+    int done = value_binary_into(operator, left, right, result);
+    free(left);
+    free(right);
+    if(!done) return (free(result), NULL);
+    return result;
+}
+
+extern void value_echo(const ValueTagged *result) 
+{   
+    switch (result->type) {
+        case NUMBER_INT:
+            fprintf(stdout, "%lld", result->literal.integer_value);
+            break;
+        case NUMBER_FLOAT:
+            fprintf(stdout, "%lf", result->literal.float_value);
+            break;
+        case STRING:
+            /* Escapes were decoded by the lexer, whole string is written at once */
+            fwrite(result->literal.char_value, 1, string_length(result->literal.char_value), stdout);
+            break;
+        case TRUE_TOKEN:
+        case FALSE_TOKEN:
+            fprintf(stdout, "%d", result->literal.boolean_value);
+            break;
+       default:
+            error("Tried to echo undefined undefined ValueTagged value in eval_print", __FILE__, __LINE__);
+            break;
+    }
+}
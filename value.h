@@ -0,0 +1,140 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef VALUE_H
+#define VALUE_H
+
+/* References of string that is owned by arena, such string is never freed by string_free */
+#define STRING_STATIC UINT32_MAX
+/* Smallest capacity of string that grows by string_append */
+#define STRING_FIRST_CAPACITY 16
+/* Buffer size for text of number or boolean added to string, longest is float written with %lf */
+#define VALUE_TEXT_SIZE 352
+
+/* Value of expression that gave nothing, like call of function without return. It is falsy and is stored as 0 */
+#define VALUE_NONE ((ValueTagged){.type = NULL_TOKEN, .literal = {.integer_value = 0}})
+
+/*@Function: string_new
+*Function that allocates string value holding copy of given bytes, NULL bytes leave it uninitialized. Length is stored
+*in StringHeader, bytes stay null terminated and string starts with one reference */
+extern char *string_new(const char *, const size_t);
+
+/*@Function: string_static
+*Function that makes string value in arena, it is not reference counted and lives as long as the arena */
+extern char *string_static(Arena *, const char *, const size_t);
+
+/*@Function: string_copy
+*Function that returns copy of string value, bytes are shared and only reference count grows */
+extern char *string_copy(const char *);
+
+/*@Function: string_append
+*Function that appends bytes to string value and returns the result, reference of caller is moved into it. String
+*with single reference grows in place with doubled capacity, shared string is copied */
+extern char *string_append(char *, const char *, const size_t);
+
+/*@Function: string_length
+*Function that returns length of string value without scanning it */
+extern size_t string_length(const char *);
+
+/*@Function: string_free
+*Function that drops reference to string value, bytes are freed with last reference */
+extern void string_free(char *);
+
+/*@Function: value_release
+*Function that frees string owned by value, value itself is not freed. Used for values passed by value */
+extern void value_release(ValueTagged *);
+
+/*@Function: free_value
+*Function that frees value together with its string */
+extern void free_value(ValueTagged *);
+
+/*@Function: value_literal
+*Function that returns value of literal token by value, only strings allocate */
+extern ValueTagged value_literal(Token *);
+
+/*@Function: value_from_token
+*Function that returns new value of literal token */
+extern ValueTagged *value_from_token(Token *);
+
+/*@Function: value_clone
+*Function that returns copy of value by value, strings are duplicated */
+extern ValueTagged value_clone(const ValueTagged *);
+
+/*@Function: value_copy
+*Function that returns new copy of value, strings are duplicated */
+extern ValueTagged *value_copy(const ValueTagged *);
+
+/*@Function: value_is_truth
+*Function that returns TRUE if value is truthy */
+extern int value_is_truth(const ValueTagged *);
+
+/*@Function: value_unary_into
+*Function that applies unary operator to value and stores result, operand is consumed and may be the result itself.
+*Returns FALSE and reports error if not allowed */
+extern int value_unary_into(Token *, ValueTagged *, ValueTagged *);
+
+/*@Function: value_unary
+*Function that applies unary operator to value, operand is consumed, returns NULL and reports error if not allowed */
+extern ValueTagged *value_unary(Token *, ValueTagged *);
+
+/*@Function: integer_operand
+*Helper Function: Stores integer value of int or boolean operand, returns FALSE for other types */
+static int integer_operand(const ValueTagged *, long long int *);
+
+/*@Function: value_integer_binary
+*Helper Function: Applies %, <<, >>, & or | to integers, returns NULL and reports error if not allowed */
+static ValueTagged *value_integer_binary(Token *, const long long int, const long long int, ValueTagged *);
+
+/*@Function: value_text
+*Helper Function: Returns bytes and length of string, number or boolean operand of concatenation, NULL for other types */
+static const char *value_text(const ValueTagged *, char *, size_t *);
+
+/*@Function: value_can_append
+*Function that returns TRUE if adding right value to left one appends to left string. Engines use it for s = s + x,
+*where variable drops its reference first, so that string is not shared and grows in place */
+extern int value_can_append(const ValueTagged *, const ValueTagged *);
+
+/*@Function: value_string
+*Function that returns text of string, number or boolean as new null terminated string freed by free, NULL for
+*other values. Used for arguments of run */
+extern char *value_string(const ValueTagged *);
+
+/*@Function: value_concat
+*Helper Function: Stores concatenation of operands where one is string, string of left operand is moved into result */
+static int value_concat(ValueTagged *, ValueTagged *, ValueTagged *);
+
+/*@Function: value_binary_into
+*Function that applies binary operator to values and stores result, operands are consumed and left one may be the result.
+*Returns FALSE and reports error if not allowed */
+extern int value_binary_into(Token *, ValueTagged *, ValueTagged *, ValueTagged *);
+
+/*@Function: value_binary
+*Function that applies binary operator to values, operands are consumed, returns NULL and reports error if not allowed */
+extern ValueTagged *value_binary(Token *, ValueTagged *, ValueTagged *);
+
+/*@Function: value_echo
+*Function that prints value for echo statement */
+extern void value_echo(const ValueTagged *);
+
+#endif // VALUE_H
@@ -0,0 +1,418 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <string.h>
+#include "coretypes.h"
+#include "error.h"
+#include "lexer.h"
+#include "environment.h"
+#include "value.h"
+#include "flat_ast.h"
+#include "trace.h"
+#include "interpreter.h"
+#include "bytecode.h"
+#include "vm.h"
+
+static ValueTagged *vm_stack = NULL;
+static size_t vm_stack_capacity = 0;
+static CallFrame *vm_frames = NULL;
+static size_t vm_frame_capacity = 0;
+static EnvironmentMap **vm_scopes = NULL;
+static size_t vm_scope_capacity = 0;
+
+static void vm_reserve_stack(const size_t size)
+{
+    if(size <= vm_stack_capacity) return;
+    size_t capacity = (vm_stack_capacity) ? vm_stack_capacity : VM_FIRST_CAPACITY;
+    while(capacity < size) capacity *= 2;
+    vm_stack = realloc(vm_stack, sizeof(ValueTagged) * capacity);
+    if(vm_stack == NULL) {
+        INTERNAL_ERROR("Could not reallocate virtual machine stack!");
+        exit(EXIT_FAILURE);
+    }
+    vm_stack_capacity = capacity;
+}
+
+static CallFrame *vm_push_frame(const size_t frame_num)
+{
+    if(frame_num >= vm_frame_capacity) {
+        vm_frame_capacity = (vm_frame_capacity) ? vm_frame_capacity * 2 : VM_FIRST_CAPACITY;
+        vm_frames = realloc(vm_frames, sizeof(CallFrame) * vm_frame_capacity);
+        if(vm_frames == NULL) {
+            INTERNAL_ERROR("Could not reallocate virtual machine call frames!");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return &vm_frames[frame_num];
+}
+
+static EnvironmentMap *vm_enter_scope(EnvironmentMap *env_enclosing, const size_t depth, const uint32_t slot_num)
+{
+    if(depth >= vm_scope_capacity) {
+        size_t capacity = (vm_scope_capacity) ? vm_scope_capacity * 2 : VM_FIRST_CAPACITY;
+        vm_scopes = realloc(vm_scopes, sizeof(EnvironmentMap *) * capacity);
+        if(vm_scopes == NULL) {
+            INTERNAL_ERROR("Could not reallocate virtual machine scopes!");
+            exit(EXIT_FAILURE);
+        }
+        memset(&vm_scopes[vm_scope_capacity], 0, sizeof(EnvironmentMap *) * (capacity - vm_scope_capacity));
+        vm_scope_capacity = capacity;
+    }
+    /* Maps are not moved by realloc of vm_scopes, enclosing pointers stay valid */
+    if(vm_scopes[depth] == NULL) {
+        vm_scopes[depth] = malloc(sizeof(EnvironmentMap));
+        if(vm_scopes[depth] == NULL) {
+            INTERNAL_ERROR("Could not allocate virtual machine scope!");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    EnvironmentMap *env_map = vm_scopes[depth];
+    env_map->env = NULL;
+    env_map->env_enclosing = env_enclosing;
+    env_map->env_return = NULL;
+    env_map->env_size = 0;
+    env_reserve_slots(env_map, slot_num);
+    return env_map;
+}
+
+extern void vm_interpret(const Bytecode *bytecode, const size_t root)
+{
+    static const void *dispatch_table[OPCODE_COUNT] = {
+#define OPCODE(name, operands) [name] = &&name##_LABEL,
+#include "opcodes.def"
+    };
+
+    const Chunk *chunk = bytecode->chunks[root];
+    FlatAST *flat = bytecode->flat;
+    const ValueTagged *constants = bytecode->constants;
+    const uint32_t *ip = chunk->code;
+    EnvironmentMap *env = &env_global;
+    size_t env_depth = 0;
+    size_t frame_num = 0;
+
+    vm_reserve_stack(chunk->stack_max);
+    ValueTagged *sp = vm_stack;
+    VM_DISPATCH();
+
+    OP_CONSTANT_LABEL:
+        *sp++ = value_clone(&constants[*ip++]);
+        VM_DISPATCH();
+
+    OP_NIL_LABEL:
+        *sp++ = VALUE_NONE;
+        VM_DISPATCH();
+
+    OP_POP_LABEL:
+        value_release(--sp);
+        VM_DISPATCH();
+
+    OP_GET_LABEL:
+    {
+        FlatNode node = *ip++;
+        ValueTagged *found = env_get_slot(flat_ast_token(flat, node), flat->lhs[node], flat->rhs[node], env);
+        if(found == NULL) goto RUNTIME_ERROR_LABEL;
+        *sp++ = value_clone(found);
+        VM_DISPATCH();
+    }
+
+    OP_ASSIGN_LABEL:
+    {
+        FlatNode node = *ip++;
+        const FlatNode *binding = &flat->extra[flat->rhs[node]];
+        ValueTagged *value = --sp;
+        env_assign_slot(flat_ast_token(flat, node), binding[0], binding[1], value, env);
+        value_release(value);
+        if(error_flag) goto RUNTIME_ERROR_LABEL;
+        VM_DISPATCH();
+    }
+
+    OP_DEFINE_LABEL:
+    {
+        FlatNode node = *ip++;
+        ValueTagged *value = --sp;
+        env_define_slot(flat_ast_token(flat, node), flat->rhs[node], value, env);
+        value_release(value);
+        VM_DISPATCH();
+    }
+
+    OP_UNARY_LABEL:
+    {
+        if(!value_unary_into(flat_ast_token(flat, *ip++), sp - 1, sp - 1)) {
+            --sp;
+            goto RUNTIME_ERROR_LABEL;
+        }
+        VM_DISPATCH();
+    }
+
+    OP_ADD_LABEL:
+        /* s = s + x: variable assigned by next instruction drops its string, so it is appended in place */
+        if(sp[-2].type == STRING && ip[1] == OP_ASSIGN && value_can_append(&sp[-2], &sp[-1])) {
+            FlatNode assign = ip[2];
+            const FlatNode *binding = &flat->extra[flat->rhs[assign]];
+            env_release_string(flat_ast_token(flat, assign), binding[0], binding[1], sp[-2].literal.char_value, env);
+        }
+        VM_BINARY_OPERATION(BINARY_ADD_SUB_MULTIPLY_OPERATION, +);
+        VM_DISPATCH();
+
+    OP_SUBTRACT_LABEL:
+        VM_BINARY_OPERATION(BINARY_ADD_SUB_MULTIPLY_OPERATION, -);
+        VM_DISPATCH();
+
+    OP_MULTIPLY_LABEL:
+        VM_BINARY_OPERATION(BINARY_ADD_SUB_MULTIPLY_OPERATION, *);
+        VM_DISPATCH();
+
+    OP_DIVIDE_LABEL:
+        VM_BINARY_OPERATION(BINARY_DIVIDE_OPERATION, /);
+        VM_DISPATCH();
+
+    OP_EQUAL_LABEL:
+        VM_BINARY_OPERATION(BINARY_COMPARISON_OPERATION, ==);
+        VM_DISPATCH();
+
+    OP_NOT_EQUAL_LABEL:
+        VM_BINARY_OPERATION(BINARY_COMPARISON_OPERATION, !=);
+        VM_DISPATCH();
+
+    OP_LESS_LABEL:
+        VM_BINARY_OPERATION(BINARY_COMPARISON_OPERATION, <);
+        VM_DISPATCH();
+
+    OP_LESS_EQUAL_LABEL:
+        VM_BINARY_OPERATION(BINARY_COMPARISON_OPERATION, <=);
+        VM_DISPATCH();
+
+    OP_GREATER_LABEL:
+        VM_BINARY_OPERATION(BINARY_COMPARISON_OPERATION, >);
+        VM_DISPATCH();
+
+    OP_GREATER_EQUAL_LABEL:
+        VM_BINARY_OPERATION(BINARY_COMPARISON_OPERATION, >=);
+        VM_DISPATCH();
+
+    OP_BINARY_LABEL:
+    {
+        ValueTagged *right = --sp;
+        if(!value_binary_into(flat_ast_token(flat, *ip++), sp - 1, right, sp - 1)) {
+            --sp;
+            goto RUNTIME_ERROR_LABEL;
+        }
+        VM_DISPATCH();
+    }
+
+    OP_JUMP_LABEL:
+        ip = chunk->code + *ip;
+        VM_DISPATCH();
+
+    OP_JUMP_IF_FALSE_LABEL:
+    {
+        ValueTagged *condition = --sp;
+        int truth = value_is_truth(condition);
+        value_release(condition);
+        ip = (truth) ? ip + 1 : chunk->code + *ip;
+        VM_DISPATCH();
+    }
+
+    OP_JUMP_IF_TRUE_OR_POP_LABEL:
+        if(value_is_truth(sp - 1)) ip = chunk->code + *ip;
+        else {
+            value_release(--sp);
+            ++ip;
+        }
+        VM_DISPATCH();
+
+    OP_JUMP_IF_FALSE_OR_POP_LABEL:
+        if(!value_is_truth(sp - 1)) ip = chunk->code + *ip;
+        else {
+            value_release(--sp);
+            ++ip;
+        }
+        VM_DISPATCH();
+
+    OP_ENTER_LABEL:
+        env = vm_enter_scope(env, env_depth++, *ip++);
+        VM_DISPATCH();
+
+    OP_LEAVE_LABEL:
+        env_reset(env);
+        env = env->env_enclosing;
+        --env_depth;
+        VM_DISPATCH();
+
+    OP_FUNCTION_LABEL:
+    {
+        FlatNode node = *ip++;
+        Chunk *body = chunk->bytecode->chunks[*ip++];
+        env_define_function(flat_ast_token(flat, node), env, NULL, flat, node, body, NULL);
+        VM_DISPATCH();
+    }
+
+    OP_CALL_LABEL:
+    {
+        Token *callee = flat_ast_token(flat, *ip++);
+        uint32_t arg_num = *ip++;
+        Environment *function = env_get_function(callee, env);
+        if(function == NULL) goto RUNTIME_ERROR_LABEL;
+
+        Chunk *body = function->data.ENV_FUNCTION.chunk;
+        if(body == NULL) {
+            INTERNAL_ERROR("Function was not defined by virtual machine!");
+            exit(EXIT_FAILURE);
+        }
+        /* Body is parsed and compiled on first call, parse error stops the statement like runtime error */
+        if(!bytecode_compile_body(body)) goto RUNTIME_ERROR_LABEL;
+        TRACE(TRACE_EVAL, "Call %s with %u arguments\n", token_lexeme(callee), arg_num);
+        if(arg_num != body->param_num) {
+            fprintf(stderr, "Error when calling %s, number of arguments given %u but expected %u\n", token_lexeme(callee), arg_num, body->param_num);
+            goto RUNTIME_ERROR_LABEL;
+        }
+
+        ValueTagged *args = sp - arg_num;
+        CallFrame *frame = vm_push_frame(frame_num++);
+        frame->chunk = chunk;
+        frame->ip = ip;
+        frame->env = env;
+        frame->env_depth = env_depth;
+        frame->stack_base = (size_t)(args - vm_stack);
+
+        /* Scope of function is enclosed by scope of caller, like in interpreters */
+        flat = body->bytecode->flat;
+        env = vm_enter_scope(env, env_depth++, body->slot_num);
+        for(uint32_t i = 0; i < arg_num; ++i) {
+            FlatNode parameter = flat->extra[body->parameters + i];
+            env_define_slot(flat_ast_token(flat, parameter), flat->rhs[parameter], &args[i], env);
+            value_release(&args[i]);
+        }
+
+        chunk = body;
+        constants = chunk->bytecode->constants;
+        ip = chunk->code;
+        vm_reserve_stack(frame->stack_base + chunk->stack_max);
+        sp = vm_stack + frame->stack_base;
+        VM_DISPATCH();
+    }
+
+    OP_RETURN_LABEL:
+    {
+        ValueTagged result = *--sp;
+        if(frame_num == 0) {
+            /* Parser rejects return outside of function, guard the frame stack anyway */
+            value_release(&result);
+            goto OP_HALT_LABEL;
+        }
+
+        CallFrame *frame = &vm_frames[--frame_num];
+        VM_LEAVE_SCOPES(frame->env_depth);
+        while(sp > vm_stack + frame->stack_base) value_release(--sp);
+        *sp++ = result;
+
+        chunk = frame->chunk;
+        flat = chunk->bytecode->flat;
+        constants = chunk->bytecode->constants;
+        ip = frame->ip;
+        env = frame->env;
+        VM_DISPATCH();
+    }
+
+    OP_ECHO_LABEL:
+    {
+        ValueTagged *value = --sp;
+        value_echo(value);
+        value_release(value);
+        VM_DISPATCH();
+    }
+
+    OP_TIME_LABEL:
+        builtin_time();
+        VM_DISPATCH();
+
+    OP_CLEAR_LABEL:
+        builtin_clear();
+        VM_DISPATCH();
+
+    OP_CD_LABEL:
+    {
+        FlatNode path = flat->lhs[*ip++];
+        builtin_cd((path == FLAT_NONE) ? NULL : token_lexeme(flat_ast_token(flat, path)));
+        VM_DISPATCH();
+    }
+
+    OP_RUN_LABEL:
+    {
+        Token *program_token = flat_ast_token(flat, *ip++);
+        uint32_t arg_num = *ip++;
+        if(program_token == NULL) {
+            fprintf(stdout, "Runtime warning: run command requires a program name to run!\n");
+            goto RUNTIME_ERROR_LABEL;
+        }
+
+        ValueTagged *args = sp - arg_num;
+        char **argv = malloc(sizeof(char *) * (arg_num + 2));
+        int valid = TRUE;
+        argv[0] = strdup(token_lexeme(program_token));
+        for(uint32_t i = 0; i < arg_num; ++i) {
+            argv[i+1] = value_string(&args[i]);
+            valid &= (argv[i+1] != NULL);
+            value_release(&args[i]);
+        }
+        argv[arg_num+1] = NULL;
+        sp = args;
+        if(valid) 
+            builtin_run(program_token, argv);
+        else
+            operator_error(program_token, "Arguments of run must be strings, numbers or booleans!");
+
+        for(uint32_t i = 0; i < arg_num + 1; ++i) {
+            free(argv[i]);
+        }
+        free(argv);
+        if(!valid) goto RUNTIME_ERROR_LABEL;
+        VM_DISPATCH();
+    }
+
+    RUNTIME_ERROR_LABEL:
+        set_error_flag();
+    OP_HALT_LABEL:
+        /* Scopes and values left by return or runtime error are freed, global scope stays */
+        VM_LEAVE_SCOPES(0);
+        while(sp > vm_stack) value_release(--sp);
+}
+
+extern void vm_release(void)
+{
+    for(size_t i = 0; i < vm_scope_capacity; ++i) {
+        free(vm_scopes[i]);
+    }
+    free(vm_scopes);
+    free(vm_frames);
+    free(vm_stack);
+    vm_scopes = NULL;
+    vm_frames = NULL;
+    vm_stack = NULL;
+    vm_scope_capacity = vm_frame_capacity = vm_stack_capacity = 0;
+}
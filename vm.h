@@ -0,0 +1,83 @@
+/*
+MIT License
+
+Copyright (c) 2024 catan2001
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef VM_H
+#define VM_H
+
+#define VM_FIRST_CAPACITY 256
+
+/* Jumps to handler of next opcode, every handler ends with its own indirect jump so that 
+ * branch predictor sees each opcode separately */
+#define VM_DISPATCH() do {                                                  \
+        TRACE(TRACE_EVAL, "Execute %s\n", trace_opcode_name(*ip));         \
+        goto *dispatch_table[*ip++];                                        \
+    } while(0)
+
+/* Numbers and booleans are computed in place of left operand like value_binary_into would compute them,
+ * strings go through value_binary_into which reports the error */
+#define VM_BINARY_OPERATION(operation, op) do {                             \
+        ValueTagged *right = --sp;                                          \
+        ValueTagged *left = sp - 1;                                         \
+        if(left->type != STRING && right->type != STRING) {                 \
+            operation(op, left, right, left);                               \
+            ++ip;                                                           \
+        }                                                                   \
+        else if(!value_binary_into(flat_ast_token(flat, *ip++), left, right, left)) { \
+            --sp;                                                           \
+            goto RUNTIME_ERROR_LABEL;                                       \
+        }                                                                   \
+    } while(0)
+
+/* Closes scopes opened above depth, global scope is never closed */
+#define VM_LEAVE_SCOPES(depth) do {                                         \
+        while(env_depth > (depth)) {                                        \
+            env_reset(env);                                                 \
+            env = env->env_enclosing;                                       \
+            --env_depth;                                                    \
+        }                                                                   \
+    } while(0)
+
+/*@Function: vm_reserve_stack
+*Helper Function: Grows operand stack to hold at least size values */
+static void vm_reserve_stack(const size_t);
+
+/*@Function: vm_push_frame
+*Helper Function: Returns next free call frame, grows call frames when they are full */
+static CallFrame *vm_push_frame(const size_t);
+
+/*@Function: vm_enter_scope
+*Helper Function: Opens Environment map at depth enclosed by env_enclosing and reserves its slots, 
+*maps are reused between scopes so that entering a block does not allocate the map itself */
+static EnvironmentMap *vm_enter_scope(EnvironmentMap *, const size_t, const uint32_t);
+
+/*@Function: vm_interpret
+*Function that runs chunk of top level statement with computed goto dispatch, functions are called 
+*without recursion of C stack. Runtime error stops the statement and sets error flag */
+extern void vm_interpret(const Bytecode *, const size_t);
+
+/*@Function: vm_release
+*Function that frees operand stack, call frames and Environment maps of virtual machine */
+extern void vm_release(void);
+
+#endif // VM_H